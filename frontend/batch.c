@@ -0,0 +1,390 @@
+/****************************************************************************
+    Batch encoding on a work-stealing thread pool
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+****************************************************************************/
+
+/*
+ * Every worker has its own queue of segments. New segments are dealt out
+ * round robin, a worker takes its newest segment first and, once its own
+ * queue is empty, steals the oldest one from another worker. Segments are
+ * coarse, a whole file or a large part of one, so a single lock covers
+ * all queues.
+ *
+ * The worker finishing the last segment of a job joins the frames and
+ * hands the job back through batch_next().
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <stdlib.h>
+#include <string.h>
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <sys/time.h>
+#include <unistd.h>
+#endif
+#ifdef HAVE_PTHREAD
+#include <pthread.h>
+#endif
+
+#include "batch.h"
+
+typedef struct
+{
+    batchjob_t *job;
+    int segment;
+} task_t;
+
+typedef struct
+{
+    task_t *task;       /* ring buffer */
+    int head, count, size;
+} queue_t;
+
+struct batch_s
+{
+    int workers;
+    queue_t *queue;
+    int deal;           /* queue the next task goes to */
+
+    batchjob_t *done, *donetail;
+    int pending;
+    int running;            /* threads started, 0 codes in batch_add() */
+
+#ifdef HAVE_PTHREAD
+    pthread_mutex_t lock;
+    pthread_cond_t work;    /* signalled when tasks are queued */
+    pthread_cond_t ready;   /* signalled when a job is done */
+    pthread_t *threads;
+    int quit;
+#endif
+};
+
+int batch_cores(void)
+{
+    int cores = 1;
+
+#ifdef _WIN32
+    SYSTEM_INFO info;
+
+    GetSystemInfo(&info);
+    cores = info.dwNumberOfProcessors;
+#elif defined(_SC_NPROCESSORS_ONLN)
+    cores = sysconf(_SC_NPROCESSORS_ONLN);
+#endif
+
+    return (cores > 0) ? cores : 1;
+}
+
+double batch_clock(void)
+{
+#ifdef _WIN32
+    return GetTickCount() * 1e-3;
+#else
+    struct timeval tv;
+
+    gettimeofday(&tv, NULL);
+    return tv.tv_sec + tv.tv_usec * 1e-6;
+#endif
+}
+
+static int queue_push(queue_t *q, task_t task)
+{
+    if (q->count == q->size)
+    {
+        int size = q->size ? 2 * q->size : 16;
+        task_t *t = (task_t *) malloc(size * sizeof(*t));
+        int i;
+
+        if (!t)
+            return -1;
+        for (i = 0; i < q->count; i++)
+            t[i] = q->task[(q->head + i) % q->size];
+        free(q->task);
+        q->task = t;
+        q->head = 0;
+        q->size = size;
+    }
+    q->task[(q->head + q->count++) % q->size] = task;
+
+    return 0;
+}
+
+#ifdef HAVE_PTHREAD
+/* own queue: newest first */
+static int queue_pop(queue_t *q, task_t *task)
+{
+    if (!q->count)
+        return 0;
+    *task = q->task[(q->head + --q->count) % q->size];
+    return 1;
+}
+
+/* other queues: oldest first */
+static int queue_steal(queue_t *q, task_t *task)
+{
+    if (!q->count)
+        return 0;
+    *task = q->task[q->head];
+    q->head = (q->head + 1) % q->size;
+    q->count--;
+    return 1;
+}
+
+static int take(batch_t *b, int worker, task_t *task)
+{
+    int i;
+
+    if (queue_pop(&b->queue[worker], task))
+        return 1;
+    for (i = 1; i < b->workers; i++)
+    {
+        if (queue_steal(&b->queue[(worker + i) % b->workers], task))
+            return 1;
+    }
+
+    return 0;
+}
+
+#endif
+
+static void finish(batch_t *b, batchjob_t *job)
+{
+    job->next = NULL;
+    if (b->donetail)
+        b->donetail->next = job;
+    else
+        b->done = job;
+    b->donetail = job;
+}
+
+static void lock(batch_t *b)
+{
+#ifdef HAVE_PTHREAD
+    if (b->running)
+        pthread_mutex_lock(&b->lock);
+#endif
+}
+
+static void unlock(batch_t *b)
+{
+#ifdef HAVE_PTHREAD
+    if (b->running)
+        pthread_mutex_unlock(&b->lock);
+#endif
+}
+
+/* run a task, called and returns with the lock held */
+static void run(batch_t *b, task_t *task)
+{
+    batchjob_t *job = task->job;
+    double start;
+
+    unlock(b);
+    start = batch_clock();
+    segments_run(job->seg, task->segment);
+    lock(b);
+
+    job->time += batch_clock() - start;
+    if (--job->left)
+        return;
+
+    unlock(b);
+    if (segments_join(job->seg, &job->out))
+        job->error = 1;
+    job->seg = NULL;
+    lock(b);
+
+    finish(b, job);
+#ifdef HAVE_PTHREAD
+    if (b->running)
+        pthread_cond_signal(&b->ready);
+#endif
+}
+
+#ifdef HAVE_PTHREAD
+typedef struct
+{
+    batch_t *b;
+    int worker;
+} worker_t;
+
+static void *worker(void *arg)
+{
+    batch_t *b = ((worker_t *)arg)->b;
+    int w = ((worker_t *)arg)->worker;
+    task_t task;
+
+    free(arg);
+
+    pthread_mutex_lock(&b->lock);
+    for (;;)
+    {
+        if (take(b, w, &task))
+            run(b, &task);
+        else if (b->quit)
+            break;
+        else
+            pthread_cond_wait(&b->work, &b->lock);
+    }
+    pthread_mutex_unlock(&b->lock);
+
+    return NULL;
+}
+#endif
+
+batch_t *batch_open(int workers)
+{
+    batch_t *b = (batch_t *) calloc(1, sizeof(*b));
+
+    if (!b)
+        return NULL;
+    if (workers < 1)
+        workers = 1;
+
+    b->workers = workers;
+    b->queue = (queue_t *) calloc(workers, sizeof(*b->queue));
+    if (!b->queue)
+    {
+        free(b);
+        return NULL;
+    }
+
+#ifdef HAVE_PTHREAD
+    pthread_mutex_init(&b->lock, NULL);
+    pthread_cond_init(&b->work, NULL);
+    pthread_cond_init(&b->ready, NULL);
+    b->threads = (pthread_t *) malloc(workers * sizeof(*b->threads));
+    /* workers wait for the lock until they are all set up */
+    pthread_mutex_lock(&b->lock);
+    for (; b->threads && b->running < workers; b->running++)
+    {
+        worker_t *arg = (worker_t *) malloc(sizeof(*arg));
+
+        if (!arg)
+            break;
+        arg->b = b;
+        arg->worker = b->running;
+        if (pthread_create(&b->threads[b->running], NULL, worker, arg))
+        {
+            free(arg);
+            break;
+        }
+    }
+    /* tasks are only dealt to queues that have a thread */
+    if (b->running)
+        b->workers = b->running;
+    pthread_mutex_unlock(&b->lock);
+#endif
+
+    return b;
+}
+
+void batch_close(batch_t *b)
+{
+    int i;
+
+    if (!b)
+        return;
+
+    while (batch_next(b))
+        ;
+
+#ifdef HAVE_PTHREAD
+    pthread_mutex_lock(&b->lock);
+    b->quit = 1;
+    pthread_cond_broadcast(&b->work);
+    pthread_mutex_unlock(&b->lock);
+    for (i = 0; i < b->running; i++)
+        pthread_join(b->threads[i], NULL);
+    free(b->threads);
+    pthread_cond_destroy(&b->ready);
+    pthread_cond_destroy(&b->work);
+    pthread_mutex_destroy(&b->lock);
+#endif
+
+    for (i = 0; i < b->workers; i++)
+        free(b->queue[i].task);
+    free(b->queue);
+    free(b);
+}
+
+void batch_add(batch_t *b, batchjob_t *job)
+{
+    int i;
+
+    memset(&job->out, 0, sizeof(job->out));
+    job->error = 0;
+    job->time = 0;
+    job->seg = segments_open(&job->in, job->segments);
+    job->left = job->segments;
+
+    lock(b);
+    b->pending++;
+    if (!job->seg)
+    {
+        job->error = 1;
+        finish(b, job);
+    }
+    for (i = 0; job->seg && i < job->segments; i++)
+    {
+        task_t task;
+
+        task.job = job;
+        task.segment = i;
+        /* without threads, or out of memory, code it right here */
+        if (!b->running || queue_push(&b->queue[b->deal], task))
+            run(b, &task);
+        else
+            b->deal = (b->deal + 1) % b->workers;
+    }
+#ifdef HAVE_PTHREAD
+    if (b->running)
+        pthread_cond_broadcast(&b->work);
+#endif
+    unlock(b);
+}
+
+int batch_pending(batch_t *b)
+{
+    return b->pending;
+}
+
+batchjob_t *batch_next(batch_t *b)
+{
+    batchjob_t *job = NULL;
+
+#ifdef HAVE_PTHREAD
+    pthread_mutex_lock(&b->lock);
+    while (b->running && !b->done && b->pending)
+        pthread_cond_wait(&b->ready, &b->lock);
+#endif
+    if (b->done)
+    {
+        job = b->done;
+        b->done = job->next;
+        if (!b->done)
+            b->donetail = NULL;
+        b->pending--;
+    }
+#ifdef HAVE_PTHREAD
+    pthread_mutex_unlock(&b->lock);
+#endif
+
+    return job;
+}
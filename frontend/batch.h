@@ -0,0 +1,58 @@
+/****************************************************************************
+    Batch encoding on a work-stealing thread pool
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+****************************************************************************/
+
+#ifndef BATCH_H
+#define BATCH_H
+
+#include "segments.h"
+
+typedef struct batchjob
+{
+    seginput_t in;
+    int segments;
+    void *user;                 /* caller data, not touched */
+
+    /* set once the job comes back from batch_next() */
+    segframes_t out;
+    int error;
+    double time;                /* encoding time summed over all workers */
+
+    /* private */
+    segments_t *seg;
+    int left;
+    struct batchjob *next;
+} batchjob_t;
+
+typedef struct batch_s batch_t;
+
+/* number of processors online, 1 if unknown */
+int batch_cores(void);
+/* wall clock in seconds */
+double batch_clock(void);
+
+batch_t *batch_open(int workers);
+void batch_close(batch_t *b);
+
+/* Queue all segments of a job. The job must stay valid until it is
+   returned by batch_next(). */
+void batch_add(batch_t *b, batchjob_t *job);
+/* jobs added but not yet returned */
+int batch_pending(batch_t *b);
+/* Wait for any job to finish, NULL when none is pending. */
+batchjob_t *batch_next(batch_t *b);
+
+#endif
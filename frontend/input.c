@@ -483,6 +483,18 @@ size_t wav_read_int24(pcmfile_t *sndf, int32_t *buf, size_t num, int *map)
   return size;
 }
 
+/* skip samples (per channel) forward, returns 0 on success */
+int wav_skip(pcmfile_t *sndf, int64_t samples)
+{
+  int64_t ofs = samples * sndf->channels * sndf->samplebytes;
+
+#ifdef _WIN32
+  return _fseeki64(sndf->f, ofs, SEEK_CUR);
+#else
+  return fseeko(sndf->f, (off_t)ofs, SEEK_CUR);
+#endif
+}
+
 int wav_close(pcmfile_t *sndf)
 {
   int i = fclose(sndf->f);
@@ -52,6 +52,7 @@ typedef struct
 pcmfile_t *wav_open_read(const char *path, int rawchans);
 size_t wav_read_float32(pcmfile_t *sndf, float *buf, size_t num, int *map);
 size_t wav_read_int24(pcmfile_t *sndf, int32_t *buf, size_t num, int *map);
+int wav_skip(pcmfile_t *sndf, int64_t samples);
 int wav_close(pcmfile_t *file);
 
 #ifdef __cplusplus
@@ -69,6 +69,7 @@
 #endif
 
 #include "input.h"
+#include "batch.h"
 
 #include <faac.h>
 
@@ -100,7 +101,9 @@ enum flags
     HELP_MP4,
     HELP_ADVANCED,
     OPT_JOINT,
-    OPT_PNS
+    OPT_PNS,
+    OPT_JOBS,
+    OPT_LD
 };
 
 typedef struct {
@@ -163,7 +166,13 @@ static help_t help_io[] = {
     "\t\tin your multichannel input files if they haven't been reordered\n"
     "\t\talready).\n"},
     {"--ignorelength\tIgnore wav length from header (useful with files over 4 GB)\n"},
-    {"--overwrite\t\tOverwrite existing output file"},
+    {"--overwrite\t\tOverwrite existing output file\n"},
+    {"--jobs <N>\tEncode on N threads\n",
+    "\t\tEncode on N threads. Several input files are encoded at once,\n"
+    "\t\tby default on one thread per processor. When there are more\n"
+    "\t\tthreads than files, each file is split into segments that are\n"
+    "\t\tencoded in parallel; the joined stream has the same frames and\n"
+    "\t\tduration as a normal encode. Needs input files of known length.\n"},
     {0}
 };
 
@@ -200,6 +209,8 @@ static help_t help_advanced[] = {
     {"--joint 2\tUse Intensity Stereo coding.\n"},
     {"--pns <0 .. 10>\tPNS level; 0=disabled.\n"},
     {"--mpeg-vers X\tForce AAC MPEG version, X can be 2 or 4\n"},
+    {"--ld\t\tAAC-LD, low delay object type with 512 sample frames and no\n"
+    "\t\tshort blocks. Needs MP4 or raw output.\n"},
     {"--shortctl X\tEnforce block type (0 = both (default); 1 = no short; 2 = no\n"
     "\t\tlong).\n"},
     {0}
@@ -425,15 +436,133 @@ static int *mkChanMap(int channels, int center, int lf)
 
 #define fprintf if(verbose)fprintf
 
+typedef struct
+{
+    const char *input;
+    char *output;
+    unsigned int latency;
+    struct
+    {
+        uint8_t *data;
+        unsigned long size;
+    } asc;
+} batchout_t;
+
+typedef struct
+{
+    int files;
+    double seconds;     /* of audio */
+} batchstats_t;
+
+/* write out a file coded by the batch pool and free the job */
+static int write_job(batchjob_t *job, enum container_format container,
+                     int overwrite, int verbose, batchstats_t *stats)
+{
+    batchout_t *out = (batchout_t *) job->user;
+    const pcmfile_t *format = &job->in.format;
+    uint64_t input_samples, encoded_samples = 0;
+    unsigned long totalBytesWritten = 0;
+    FILE *outfile = NULL;
+    size_t ofs = 0;
+    unsigned int i;
+    int error = job->error;
+
+    if (error)
+    {
+        fprintf(stderr, "%s: encoding failed\n", out->input);
+    }
+    else if (container == MP4_CONTAINER)
+    {
+        if (mp4atom_open(out->output, overwrite))
+        {
+            fprintf(stderr, "Couldn't create output file %s\n", out->output);
+            error = 1;
+        }
+        else
+        {
+            mp4atom_head();
+            mp4config.samplerate = format->samplerate;
+            mp4config.channels = format->channels;
+            mp4config.bits = format->samplebytes * 8;
+        }
+    }
+    else if (!(outfile = fopen(out->output, "wb")))
+    {
+        fprintf(stderr, "Couldn't create output file %s\n", out->output);
+        error = 1;
+    }
+
+    for (i = 0; !error && i < job->out.frames; i++)
+    {
+        /* what the encoding loop in main() would have read by this frame */
+        uint64_t frame_samples;
+
+        input_samples = (uint64_t)i * job->in.frameSize + out->latency +
+            job->in.frameSize;
+        if (input_samples > format->samples)
+            input_samples = format->samples;
+
+        frame_samples = input_samples - encoded_samples;
+        if (frame_samples > job->in.frameSize)
+            frame_samples = job->in.frameSize;
+
+        if (container == MP4_CONTAINER)
+            mp4atom_frame(job->out.data + ofs, job->out.size[i], frame_samples);
+        else
+            fwrite(job->out.data + ofs, 1, job->out.size[i], outfile);
+
+        encoded_samples += frame_samples;
+        ofs += job->out.size[i];
+        totalBytesWritten += job->out.size[i];
+    }
+
+    if (!error)
+    {
+        double seconds = (double) format->samples / format->samplerate;
+
+        if (container == MP4_CONTAINER)
+        {
+            mp4config.asc.data = out->asc.data;
+            mp4config.asc.size = out->asc.size;
+            mp4atom_tail();
+            mp4atom_close();
+            mp4config.asc.data = NULL;
+        }
+        else
+            fclose(outfile);
+
+        fprintf(stderr, "%s: %u frames, %.1f kbps, %.2fx",
+                out->output, job->out.frames,
+                totalBytesWritten * 8.0 / 1000.0 / seconds,
+                job->time > 0 ? seconds / job->time : 0.0);
+        if (job->segments > 1)
+            fprintf(stderr, " in %d segments", job->segments);
+        fprintf(stderr, "\n");
+
+        stats->files++;
+        stats->seconds += seconds;
+    }
+
+    segments_free(&job->out);
+    free(job->in.chanmap);
+    free(out->asc.data);
+    free(out->output);
+    free(out);
+    free(job);
+
+    return error;
+}
+
 int main(int argc, char *argv[])
 {
     int frames, currentFrame;
-    faacEncHandle hEncoder;
+    faacEncHandle hEncoder = NULL;
     pcmfile_t *infile = NULL;
 
     unsigned long samplesInput, maxBytesOutput, totalBytesWritten = 0;
 
     faacEncConfigurationPtr myFormat;
+    faacEncConfiguration config;
     unsigned int mpegVersion = MPEG2;
     unsigned int objectType = LOW;
     int jointmode = -1;
@@ -442,6 +571,7 @@ int main(int argc, char *argv[])
     enum container_format container = NO_CONTAINER;
     enum stream_format stream = ADTS_STREAM;
     int cutOff = -1;
+    int fileCutOff;
     int bitRate = 0;
     unsigned long quantqual = 0;
     int chanC = 3;
@@ -452,10 +582,10 @@ int main(int argc, char *argv[])
     char *aacFileExt = NULL;
     int aacFileNameGiven = 0;
 
-    float *pcmbuf;
+    float *pcmbuf = NULL;
     int *chanmap = NULL;
 
-    unsigned char *bitbuf;
+    unsigned char *bitbuf = NULL;
     int samplesRead = 0;
     const char *dieMessage = NULL;
 
@@ -465,6 +595,11 @@ int main(int argc, char *argv[])
     int rawEndian = 1;
 
     int shortctl = SHORTCTL_NORMAL;
+    int jobs = 0;
+    int nfiles;
+    batch_t *batch = NULL;
+    batchstats_t batchstats = {0};
+    double batchbegin = 0;
 
     FILE *outfile = NULL;
 
@@ -485,6 +620,13 @@ int main(int argc, char *argv[])
     uint64_t input_samples = 0;
     char *faac_id_string;
     char *faac_copyright_string;
+    char *version_string = NULL;
+    int showcnt;
+#ifdef _WIN32
+    long begin;
+#endif
+    int shown = 0;
+    int status = 0;
     static int ignorelen = 0;
     int verbose = 1;
     static int overwrite = 0;
@@ -558,6 +700,8 @@ int main(int argc, char *argv[])
             {"ignorelength", 0, &ignorelen, 1},
             {"tag", 1, 0, TAG_FLAG},
             {"overwrite", 0, &overwrite, 1},
+            {"jobs", required_argument, 0, OPT_JOBS},
+            {"ld", 0, 0, OPT_LD},
             {0, 0, 0, 0}
         };
         int c = -1;
@@ -770,6 +914,9 @@ int main(int argc, char *argv[])
                 dieMessage = "Unrecognised MPEG version!\n";
             }
             break;
+        case OPT_LD:
+            objectType = LD;
+            break;
         case 'L':
             fprintf(stderr, "%s", faac_copyright_string);
             dieMessage = license;
@@ -795,6 +942,9 @@ int main(int argc, char *argv[])
         case OPT_PNS:
             pnslevel = atoi(optarg);
             break;
+        case OPT_JOBS:
+            jobs = atoi(optarg);
+            break;
         case '?':
         default:
             help('?');
@@ -814,26 +964,7 @@ int main(int argc, char *argv[])
         return 1;
     }
 
-    while (argc - optind > 0)
-    {
-        /* get the input file name */
-        audioFileName = argv[optind++];
-    }
-
-    /* generate the output file name, if necessary */
-    if (!aacFileNameGiven)
-    {
-        char *t = strrchr(audioFileName, '.');
-        int l = t ? strlen(audioFileName) - strlen(t) : strlen(audioFileName);
-
-        aacFileExt = container == MP4_CONTAINER ? ".m4a" : ".aac";
-
-        aacFileName = malloc(l + 1 + 4);
-        memcpy(aacFileName, audioFileName, l);
-        memcpy(aacFileName + l, aacFileExt, 4);
-        aacFileName[l + 4] = '\0';
-    }
-    else
+    if (aacFileNameGiven)
     {
         aacFileExt = strrchr(aacFileName, '.');
 
@@ -843,40 +974,6 @@ int main(int argc, char *argv[])
             container = MP4_CONTAINER;
     }
 
-    /* open the audio input file */
-    if (rawChans > 0)           // use raw input
-    {
-        infile = wav_open_read(audioFileName, 1);
-        if (infile)
-        {
-            infile->bigendian = rawEndian;
-            infile->channels = rawChans;
-            infile->samplebytes = rawBits / 8;
-            infile->samplerate = rawRate;
-            infile->samples /= (infile->channels * infile->samplebytes);
-        }
-    }
-    else                        // header input
-        infile = wav_open_read(audioFileName, 0);
-
-    if (infile == NULL)
-    {
-        fprintf(stderr, "Couldn't open input file %s\n", audioFileName);
-        return 1;
-    }
-
-    /* open the encoder library */
-    hEncoder = faacEncOpen(infile->samplerate, infile->channels,
-                           &samplesInput, &maxBytesOutput);
-
-    if (hEncoder == NULL)
-    {
-        fprintf(stderr, "Couldn't open encoder instance for input file %s\n",
-                audioFileName);
-        wav_close(infile);
-        return 1;
-    }
-
     if (container != MP4_CONTAINER && (ntracks || trackno || artist ||
                                        artistsort || title ||
                                        album || albumartist ||
@@ -890,387 +987,569 @@ int main(int argc, char *argv[])
         return 1;
     }
 
-    if (container == MP4_CONTAINER)
+    if (objectType == LD)
     {
+        /* there is no ADTS profile for it */
+        if (container != MP4_CONTAINER && stream == ADTS_STREAM)
+        {
+            fprintf(stderr, "AAC-LD requires MP4 or raw output!\n");
+            return 1;
+        }
         mpegVersion = MPEG4;
-        stream = RAW_STREAM;
     }
 
-    frameSize = samplesInput / infile->channels;
-    delay_samples = frameSize;  // encoder delay 1024 samples
-    pcmbuf = (float *) malloc(samplesInput * sizeof(float));
-    bitbuf = (unsigned char *) malloc(maxBytesOutput * sizeof(unsigned char));
-    chanmap = mkChanMap(infile->channels, chanC, chanLF);
-    if (chanmap)
+    if (container == MP4_CONTAINER)
     {
-        fprintf(stderr, "Remapping input channels: Center=%d, LFE=%d\n",
-                chanC, chanLF);
-    }
+        mpegVersion = MPEG4;
+        stream = RAW_STREAM;
 
-    if (cutOff <= 0)
-    {
-        if (cutOff < 0)         // default
-            cutOff = 0;
-        else                    // disabled
-            cutOff = infile->samplerate / 2;
-    }
-    if (cutOff > (infile->samplerate / 2))
-        cutOff = infile->samplerate / 2;
-
-    /* put the options in the configuration struct */
-    myFormat = faacEncGetCurrentConfiguration(hEncoder);
-    myFormat->aacObjectType = objectType;
-    myFormat->mpegVersion = mpegVersion;
-    myFormat->useTns = useTns;
-    switch (shortctl)
-    {
-    case SHORTCTL_NOSHORT:
-        fprintf(stderr, "disabling short blocks\n");
-        myFormat->shortctl = shortctl;
-        break;
-    case SHORTCTL_NOLONG:
-        fprintf(stderr, "disabling long blocks\n");
-        myFormat->shortctl = shortctl;
-        break;
-    }
-    if (infile->channels >= 6)
-        myFormat->useLfe = 1;
-    if (jointmode >= 0)
-        myFormat->jointmode = jointmode;
-    if (pnslevel >= 0)
-        myFormat->pnslevel = pnslevel;
-    if (quantqual > 0)
-    {
-        myFormat->quantqual = quantqual;
-        myFormat->bitRate = 0;
+        version_string = malloc(strlen(faac_id_string) + 6);
+        strcpy(version_string, "FAAC ");
+        strcpy(version_string + 5, faac_id_string);
+
+        mp4config.tag.encoder = version_string;
+
+#define SETTAG(x) if(x)mp4config.tag.x=x
+        SETTAG(artist);
+        SETTAG(artistsort);
+        SETTAG(composer);
+        SETTAG(composersort);
+        SETTAG(title);
+        SETTAG(album);
+        SETTAG(albumartist);
+        SETTAG(albumartistsort);
+        SETTAG(albumsort);
+        SETTAG(trackno);
+        SETTAG(ntracks);
+        SETTAG(discno);
+        SETTAG(ndiscs);
+        SETTAG(compilation);
+        SETTAG(year);
+        SETTAG(genre);
+        SETTAG(comment);
+        if (artData && artSize)
+        {
+            mp4config.tag.cover.data = artData;
+            mp4config.tag.cover.size = artSize;
+        }
     }
-    if (bitRate)
-        myFormat->bitRate = bitRate / infile->channels;
-    myFormat->bandWidth = cutOff;
-    myFormat->outputFormat = stream;
-    myFormat->inputFormat = FAAC_INPUT_FLOAT;
-    if (!faacEncSetConfiguration(hEncoder, myFormat))
+
+    /* several files go to the batch pool, one thread per processor */
+    nfiles = argc - optind;
+    if (jobs <= 0)
+        jobs = (nfiles > 1) ? batch_cores() : 1;
+    if (jobs > 1)
     {
-        fprintf(stderr, "Unsupported output format!\n");
-        return 1;
+        batch = batch_open(jobs);
+        batchbegin = batch_clock();
     }
 
-    /* initialize MP4 creation */
-    if (container == MP4_CONTAINER)
+    for (;;)
     {
-        if (!strcmp(aacFileName, "-"))
+        /* done with the previous file */
+        if (hEncoder)
+            faacEncClose(hEncoder);
+        hEncoder = NULL;
+        if (infile)
+            wav_close(infile);
+        infile = NULL;
+        free(chanmap);
+        chanmap = NULL;
+        free(pcmbuf);
+        pcmbuf = NULL;
+        free(bitbuf);
+        bitbuf = NULL;
+        if (!aacFileNameGiven)
         {
-            fprintf(stderr, "cannot encode MP4 to stdout\n");
-            return 1;
+            free(aacFileName);
+            aacFileName = NULL;
         }
 
-        if (mp4atom_open(aacFileName, overwrite))
+        /* write what the batch has finished, keeping a bounded number of
+           files in memory */
+        while (batch && batch_pending(batch) >= (optind < argc ? 2 * jobs : 1))
+            status |= write_job(batch_next(batch), container, overwrite,
+                                verbose, &batchstats);
+
+#ifndef _WIN32
+        if (!running)
+            break;
+#endif
+        if (optind >= argc)
+            break;
+
+        /* get the input file name */
+        audioFileName = argv[optind++];
+
+        /* generate the output file name, if necessary */
+        if (!aacFileNameGiven)
         {
-            fprintf(stderr, "Couldn't create output file %s\n", aacFileName);
-            return 1;
+            char *t = strrchr(audioFileName, '.');
+            int l = t ? strlen(audioFileName) - strlen(t) : strlen(audioFileName);
+
+            aacFileExt = container == MP4_CONTAINER ? ".m4a" : ".aac";
+
+            aacFileName = malloc(l + 1 + 4);
+            memcpy(aacFileName, audioFileName, l);
+            memcpy(aacFileName + l, aacFileExt, 4);
+            aacFileName[l + 4] = '\0';
         }
-        mp4atom_head();
 
-        mp4config.samplerate = infile->samplerate;
-        mp4config.channels = infile->channels;
-        mp4config.bits = infile->samplebytes * 8;
-    }
-    else
-    {
-        /* open the aac output file */
-        if (!strcmp(aacFileName, "-"))
+        /* open the audio input file */
+        if (rawChans > 0)           // use raw input
         {
-            outfile = stdout;
+            infile = wav_open_read(audioFileName, 1);
+            if (infile)
+            {
+                infile->bigendian = rawEndian;
+                infile->channels = rawChans;
+                infile->samplebytes = rawBits / 8;
+                infile->samplerate = rawRate;
+                infile->samples /= (infile->channels * infile->samplebytes);
+            }
         }
-        else
+        else                        // header input
+            infile = wav_open_read(audioFileName, 0);
+
+        if (infile == NULL)
         {
-            outfile = fopen(aacFileName, "wb");
+            fprintf(stderr, "Couldn't open input file %s\n", audioFileName);
+            status = 1;
+            continue;
         }
-        if (!outfile)
+
+        /* open the encoder library */
+        hEncoder = faacEncOpen(infile->samplerate, infile->channels,
+                               &samplesInput, &maxBytesOutput);
+
+        if (hEncoder == NULL)
         {
-            fprintf(stderr, "Couldn't create output file %s\n", aacFileName);
-            return 1;
+            fprintf(stderr, "Couldn't open encoder instance for input file %s\n",
+                    audioFileName);
+            status = 1;
+            continue;
         }
-    }
 
-    cutOff = myFormat->bandWidth;
-    quantqual = myFormat->quantqual;
-    bitRate = myFormat->bitRate;
-    if (bitRate)
-    {
-        fprintf(stderr, "Initial quantization quality: %ld\n", quantqual);
-        fprintf(stderr, "Average bitrate: %d kbps/channel\n",
-                (bitRate + 500) / 1000);
-    }
-    else
-        fprintf(stderr, "Quantization quality: %ld\n", quantqual);
-    fprintf(stderr, "Bandwidth: %d Hz\n", cutOff);
-    if (myFormat->pnslevel > 0)
-        fprintf(stderr, "PNS level: %d\n", myFormat->pnslevel);
-    fprintf(stderr, "Object type: ");
-    switch (objectType)
-    {
-    case LOW:
-        fprintf(stderr, "Low Complexity");
-        break;
-    case MAIN:
-        fprintf(stderr, "Main");
-        break;
-    case LTP:
-        fprintf(stderr, "LTP");
-        break;
-    }
-    fprintf(stderr, "(MPEG-%d)", (mpegVersion == MPEG4) ? 4 : 2);
-    if (myFormat->useTns)
-        fprintf(stderr, " + TNS");
-
-    switch(myFormat->jointmode) {
-    case JOINT_MS:
-        fprintf(stderr, " + M/S");
-        break;
-    case JOINT_IS:
-        fprintf(stderr, " + IS");
-        break;
-    }
-    if (myFormat->pnslevel > 0)
-        fprintf(stderr, " + PNS");
-    fprintf(stderr, "\n");
+        chanmap = mkChanMap(infile->channels, chanC, chanLF);
+        if (chanmap && !shown)
+        {
+            fprintf(stderr, "Remapping input channels: Center=%d, LFE=%d\n",
+                    chanC, chanLF);
+        }
 
-    fprintf(stderr, "Container format: ");
-    switch (container)
-    {
-    case NO_CONTAINER:
-        switch (stream)
+        fileCutOff = cutOff;
+        if (fileCutOff <= 0)
+        {
+            if (fileCutOff < 0)     // default
+                fileCutOff = 0;
+            else                    // disabled
+                fileCutOff = infile->samplerate / 2;
+        }
+        if (fileCutOff > (infile->samplerate / 2))
+            fileCutOff = infile->samplerate / 2;
+
+        /* put the options in the configuration struct */
+        myFormat = faacEncGetCurrentConfiguration(hEncoder);
+        myFormat->aacObjectType = objectType;
+        myFormat->mpegVersion = mpegVersion;
+        myFormat->useTns = useTns;
+        switch (shortctl)
         {
-        case RAW_STREAM:
-            fprintf(stderr, "Headerless AAC (RAW)\n");
+        case SHORTCTL_NOSHORT:
+            if (!shown)
+                fprintf(stderr, "disabling short blocks\n");
+            myFormat->shortctl = shortctl;
             break;
-        case ADTS_STREAM:
-            fprintf(stderr, "Transport Stream (ADTS)\n");
+        case SHORTCTL_NOLONG:
+            if (!shown)
+                fprintf(stderr, "disabling long blocks\n");
+            myFormat->shortctl = shortctl;
             break;
         }
-        break;
-    case MP4_CONTAINER:
-        fprintf(stderr, "MPEG-4 File Format (MP4)\n");
-        break;
-    }
+        if (infile->channels >= 6)
+            myFormat->useLfe = 1;
+        if (jointmode >= 0)
+            myFormat->jointmode = jointmode;
+        if (pnslevel >= 0)
+            myFormat->pnslevel = pnslevel;
+        if (quantqual > 0)
+        {
+            myFormat->quantqual = quantqual;
+            myFormat->bitRate = 0;
+        }
+        if (bitRate)
+            myFormat->bitRate = bitRate / infile->channels;
+        myFormat->bandWidth = fileCutOff;
+        myFormat->outputFormat = stream;
+        myFormat->inputFormat = FAAC_INPUT_FLOAT;
+        /* batch encoders are set up the same way */
+        config = *myFormat;
+        if (!faacEncSetConfiguration(hEncoder, myFormat))
+        {
+            fprintf(stderr, "Unsupported output format!\n");
+            status = 1;
+            continue;
+        }
 
-    int showcnt = 0;
-#ifdef _WIN32
-    long begin = GetTickCount();
-#endif
-    if (infile->samples)
-        frames = ((infile->samples + 1023) / 1024) + 1;
-    else
-        frames = 0;
-    currentFrame = 0;
+        /* LD frames are shorter than faacEncOpen() assumed */
+        frameSize = faacEncGetFrameLength(hEncoder);
+        samplesInput = frameSize * infile->channels;
+        delay_samples = faacEncGetDelay(hEncoder);
 
-    fprintf(stderr, "Encoding %s to %s\n", audioFileName, aacFileName);
-    if (frames != 0)
-    {
-        fprintf(stderr, "         frame         | bitrate | elapsed/estim | "
-                "play/CPU | ETA\n");
-    }
-    else
-    {
-        fprintf(stderr, "  frame  | elapsed | play/CPU\n");
-    }
+        if (!shown)
+        {
+            unsigned long quality = myFormat->quantqual;
+            int rate = myFormat->bitRate;
 
-    /* encoding loop */
-#ifdef _WIN32
-    for (;;)
-#else
-    while (running)
-#endif
-    {
-        int bytesWritten;
+            if (rate)
+            {
+                fprintf(stderr, "Initial quantization quality: %ld\n", quality);
+                fprintf(stderr, "Average bitrate: %d kbps/channel\n",
+                        (rate + 500) / 1000);
+            }
+            else
+                fprintf(stderr, "Quantization quality: %ld\n", quality);
+            fprintf(stderr, "Bandwidth: %d Hz\n", myFormat->bandWidth);
+            if (myFormat->pnslevel > 0)
+                fprintf(stderr, "PNS level: %d\n", myFormat->pnslevel);
+            fprintf(stderr, "Object type: ");
+            switch (objectType)
+            {
+            case LOW:
+                fprintf(stderr, "Low Complexity");
+                break;
+            case MAIN:
+                fprintf(stderr, "Main");
+                break;
+            case LTP:
+                fprintf(stderr, "LTP");
+                break;
+            case LD:
+                fprintf(stderr, "Low Delay");
+                break;
+            }
+            fprintf(stderr, "(MPEG-%d)", (mpegVersion == MPEG4) ? 4 : 2);
+            if (myFormat->useTns)
+                fprintf(stderr, " + TNS");
 
-        if (!ignorelen)
+            switch(myFormat->jointmode) {
+            case JOINT_MS:
+                fprintf(stderr, " + M/S");
+                break;
+            case JOINT_IS:
+                fprintf(stderr, " + IS");
+                break;
+            }
+            if (myFormat->pnslevel > 0)
+                fprintf(stderr, " + PNS");
+            fprintf(stderr, "\n");
+
+            fprintf(stderr, "Container format: ");
+            switch (container)
+            {
+            case NO_CONTAINER:
+                switch (stream)
+                {
+                case RAW_STREAM:
+                    fprintf(stderr, "Headerless AAC (RAW)\n");
+                    break;
+                case ADTS_STREAM:
+                    fprintf(stderr, "Transport Stream (ADTS)\n");
+                    break;
+                }
+                break;
+            case MP4_CONTAINER:
+                fprintf(stderr, "MPEG-4 File Format (MP4)\n");
+                break;
+            }
+            if (batch)
+                fprintf(stderr, "Encoding on %d threads\n", jobs);
+            shown = 1;
+        }
+
+        if (batch)
         {
-            if (input_samples < infile->samples || infile->samples == 0)
-                samplesRead =
-                    wav_read_float32(infile, pcmbuf, samplesInput, chanmap);
-            else
-                samplesRead = 0;
+            if (strcmp(audioFileName, "-") && !ignorelen && infile->samples)
+            {
+                batchjob_t *job = calloc(1, sizeof(*job));
+                batchout_t *out = calloc(1, sizeof(*out));
 
-            if (input_samples + (samplesRead / infile->channels) >
-                infile->samples && infile->samples != 0)
-                samplesRead =
-                    (infile->samples - input_samples) * infile->channels;
+                if (!job || !out)
+                {
+                    free(job);
+                    free(out);
+                    fprintf(stderr, "Out of memory\n");
+                    status = 1;
+                    continue;
+                }
+
+                out->input = audioFileName;
+                out->output = strdup(aacFileName);
+                out->latency = faacEncGetLatency(hEncoder);
+                faacEncGetDecoderSpecificInfo(hEncoder, &out->asc.data,
+                                              &out->asc.size);
+
+                job->user = out;
+                job->in.path = audioFileName;
+                job->in.rawinput = (rawChans > 0);
+                job->in.format = *infile;
+                job->in.format.f = NULL;
+                job->in.chanmap = chanmap;
+                job->in.config = config;
+                job->in.frameSize = frameSize;
+                /* big files are split when there are threads to spare */
+                job->segments = segments_count(&job->in, jobs / nfiles);
+                chanmap = NULL;
+
+                batch_add(batch, job);
+                continue;
+            }
+
+            fprintf(stderr, "%s: parallel encoding needs an input file of "
+                    "known length\n", audioFileName);
         }
-        else
-            samplesRead =
-                wav_read_float32(infile, pcmbuf, samplesInput, chanmap);
 
-        input_samples += samplesRead / infile->channels;
+        /* initialize MP4 creation */
+        if (container == MP4_CONTAINER)
+        {
+            if (!strcmp(aacFileName, "-"))
+            {
+                fprintf(stderr, "cannot encode MP4 to stdout\n");
+                status = 1;
+                continue;
+            }
 
-        /* call the actual encoding routine */
-        bytesWritten = faacEncEncode(hEncoder,
-                                     (int32_t *) pcmbuf,
-                                     samplesRead, bitbuf, maxBytesOutput);
+            if (mp4atom_open(aacFileName, overwrite))
+            {
+                fprintf(stderr, "Couldn't create output file %s\n", aacFileName);
+                status = 1;
+                continue;
+            }
+            mp4atom_head();
 
-        if (bytesWritten)
+            mp4config.samplerate = infile->samplerate;
+            mp4config.channels = infile->channels;
+            mp4config.bits = infile->samplebytes * 8;
+        }
+        else
         {
-            currentFrame++;
-            showcnt--;
-            totalBytesWritten += bytesWritten;
+            /* open the aac output file */
+            if (!strcmp(aacFileName, "-"))
+            {
+                outfile = stdout;
+            }
+            else
+            {
+                outfile = fopen(aacFileName, "wb");
+            }
+            if (!outfile)
+            {
+                fprintf(stderr, "Couldn't create output file %s\n", aacFileName);
+                status = 1;
+                continue;
+            }
         }
 
-        if ((showcnt <= 0) || !bytesWritten)
-        {
-            double timeused;
-#ifdef __unix__
-            struct rusage usage;
+        pcmbuf = (float *) malloc(samplesInput * sizeof(float));
+        bitbuf = (unsigned char *) malloc(maxBytesOutput * sizeof(unsigned char));
+
+        showcnt = 0;
+#ifdef _WIN32
+        begin = GetTickCount();
 #endif
+        if (infile->samples)
+            frames = ((infile->samples + frameSize - 1) / frameSize) + 1;
+        else
+            frames = 0;
+        currentFrame = 0;
+        totalBytesWritten = 0;
+        encoded_samples = 0;
+        input_samples = 0;
+
+        fprintf(stderr, "Encoding %s to %s\n", audioFileName, aacFileName);
+        if (frames != 0)
+        {
+            fprintf(stderr, "         frame         | bitrate | elapsed/estim | "
+                    "play/CPU | ETA\n");
+        }
+        else
+        {
+            fprintf(stderr, "  frame  | elapsed | play/CPU\n");
+        }
+
+        /* encoding loop */
 #ifdef _WIN32
-            char percent[MAX_PATH + 20];
-            timeused = (GetTickCount() - begin) * 1e-3;
+        for (;;)
 #else
-#ifdef __unix__
-            if (getrusage(RUSAGE_SELF, &usage) == 0)
+        while (running)
+#endif
+        {
+            int bytesWritten;
+
+            if (!ignorelen)
             {
-                timeused = (double) usage.ru_utime.tv_sec +
-                    (double) usage.ru_utime.tv_usec * 1e-6;
+                if (input_samples < infile->samples || infile->samples == 0)
+                    samplesRead =
+                        wav_read_float32(infile, pcmbuf, samplesInput, chanmap);
+                else
+                    samplesRead = 0;
+
+                if (input_samples + (samplesRead / infile->channels) >
+                    infile->samples && infile->samples != 0)
+                    samplesRead =
+                        (infile->samples - input_samples) * infile->channels;
             }
             else
-                timeused = 0;
-#else
-            timeused = (double) clock() * (1.0 / CLOCKS_PER_SEC);
-#endif
-#endif
-            if (currentFrame && (timeused > 0.1))
+                samplesRead =
+                    wav_read_float32(infile, pcmbuf, samplesInput, chanmap);
+
+            input_samples += samplesRead / infile->channels;
+
+            /* call the actual encoding routine */
+            bytesWritten = faacEncEncode(hEncoder,
+                                         (int32_t *) pcmbuf,
+                                         samplesRead, bitbuf, maxBytesOutput);
+
+            if (bytesWritten)
             {
-                showcnt += 50;
+                currentFrame++;
+                showcnt--;
+                totalBytesWritten += bytesWritten;
+            }
 
-                if (frames != 0)
+            if ((showcnt <= 0) || !bytesWritten)
+            {
+                double timeused;
+#ifdef __unix__
+                struct rusage usage;
+#endif
+#ifdef _WIN32
+                char percent[MAX_PATH + 20];
+                timeused = (GetTickCount() - begin) * 1e-3;
+#else
+#ifdef __unix__
+                if (getrusage(RUSAGE_SELF, &usage) == 0)
                 {
-                    fprintf(stderr,
-                            "\r%7d/%-7d (%3d%%) |  %5.1f  | %6.1f/%-6.1f | %7.2fx | %.1f ",
-                            currentFrame, frames, currentFrame * 100 / frames,
-                            ((double) totalBytesWritten * 8.0 / 1000.0) /
-                            ((double) infile->samples / infile->samplerate *
-                             currentFrame / frames), timeused,
-                            timeused * frames / currentFrame,
-                            (1024.0 * currentFrame / infile->samplerate) /
-                            timeused,
-                            timeused * (frames -
-                                        currentFrame) / currentFrame);
+                    timeused = (double) usage.ru_utime.tv_sec +
+                        (double) usage.ru_utime.tv_usec * 1e-6;
                 }
                 else
+                    timeused = 0;
+#else
+                timeused = (double) clock() * (1.0 / CLOCKS_PER_SEC);
+#endif
+#endif
+                if (currentFrame && (timeused > 0.1))
                 {
-                    fprintf(stderr,
-                            "\r %7d | %7.1f | %7.2fx ",
-                            currentFrame,
-                            timeused,
-                            (1024.0 * currentFrame / infile->samplerate) /
-                            timeused);
-                }
+                    showcnt += 50;
+
+                    if (frames != 0)
+                    {
+                        fprintf(stderr,
+                                "\r%7d/%-7d (%3d%%) |  %5.1f  | %6.1f/%-6.1f | %7.2fx | %.1f ",
+                                currentFrame, frames, currentFrame * 100 / frames,
+                                ((double) totalBytesWritten * 8.0 / 1000.0) /
+                                ((double) infile->samples / infile->samplerate *
+                                 currentFrame / frames), timeused,
+                                timeused * frames / currentFrame,
+                                ((double)frameSize * currentFrame / infile->samplerate) /
+                                timeused,
+                                timeused * (frames -
+                                            currentFrame) / currentFrame);
+                    }
+                    else
+                    {
+                        fprintf(stderr,
+                                "\r %7d | %7.1f | %7.2fx ",
+                                currentFrame,
+                                timeused,
+                                ((double)frameSize * currentFrame / infile->samplerate) /
+                                timeused);
+                    }
 
-                fflush(stderr);
+                    fflush(stderr);
 #ifdef _WIN32
-                if (frames != 0)
-                {
-                    sprintf(percent, "%.2f%% encoding %s",
-                            100.0 * currentFrame / frames, audioFileName);
-                    SetConsoleTitle(percent);
-                }
+                    if (frames != 0)
+                    {
+                        sprintf(percent, "%.2f%% encoding %s",
+                                100.0 * currentFrame / frames, audioFileName);
+                        SetConsoleTitle(percent);
+                    }
 #endif
+                }
             }
-        }
 
-        /* all done, bail out */
-        if (!samplesRead && !bytesWritten)
-            break;
+            /* all done, bail out */
+            if (!samplesRead && !bytesWritten)
+                break;
 
-        if (bytesWritten < 0)
-        {
-            fprintf(stderr, "faacEncEncode() failed\n");
-            break;
-        }
+            if (bytesWritten < 0)
+            {
+                fprintf(stderr, "faacEncEncode() failed\n");
+                break;
+            }
 
-        if (bytesWritten > 0)
-        {
-            uint64_t frame_samples = input_samples - encoded_samples;
-            if (frame_samples > delay_samples)
-                frame_samples = delay_samples;
+            if (bytesWritten > 0)
+            {
+                uint64_t frame_samples = input_samples - encoded_samples;
+                if (frame_samples > delay_samples)
+                    frame_samples = delay_samples;
 
-            if (container == MP4_CONTAINER)
-                mp4atom_frame(bitbuf, bytesWritten, frame_samples);
-            else
-                fwrite(bitbuf, 1, bytesWritten, outfile);
+                if (container == MP4_CONTAINER)
+                    mp4atom_frame(bitbuf, bytesWritten, frame_samples);
+                else
+                    fwrite(bitbuf, 1, bytesWritten, outfile);
 
-            encoded_samples += frame_samples;
+                encoded_samples += frame_samples;
+            }
         }
-    }
-    fprintf(stderr, "\n");
+        fprintf(stderr, "\n");
 
-    if (container == MP4_CONTAINER)
-    {
-        char *version_string = malloc(strlen(faac_id_string) + 6);
-
-        faacEncGetDecoderSpecificInfo(hEncoder,
-                                      &mp4config.asc.data,
-                                      &mp4config.asc.size);
-        strcpy(version_string, "FAAC ");
-        strcpy(version_string + 5, faac_id_string);
+        if (container == MP4_CONTAINER)
+        {
+            faacEncGetDecoderSpecificInfo(hEncoder,
+                                          &mp4config.asc.data,
+                                          &mp4config.asc.size);
 
-        mp4config.tag.encoder = version_string;
+            mp4atom_tail();
+            mp4atom_close();
 
-#define SETTAG(x) if(x)mp4config.tag.x=x
-        SETTAG(artist);
-        SETTAG(artistsort);
-        SETTAG(composer);
-        SETTAG(composersort);
-        SETTAG(title);
-        SETTAG(album);
-        SETTAG(albumartist);
-        SETTAG(albumartistsort);
-        SETTAG(albumsort);
-        SETTAG(trackno);
-        SETTAG(ntracks);
-        SETTAG(discno);
-        SETTAG(ndiscs);
-        SETTAG(compilation);
-        SETTAG(year);
-        SETTAG(genre);
-        SETTAG(comment);
-        if (artData && artSize)
+            if (verbose >= 2)
+            {
+                fprintf(stderr, "%u frames\n", mp4config.frame.ents);
+                fprintf(stderr, "%u output samples\n", mp4config.samples);
+                fprintf(stderr, "max bitrate: %u\n", mp4config.bitrate.max);
+                fprintf(stderr, "avg bitrate: %u\n", mp4config.bitrate.avg);
+                fprintf(stderr, "max frame size: %u\n", mp4config.buffersize);
+            }
+            free(mp4config.asc.data);
+            mp4config.asc.data = NULL;
+        }
+        else
         {
-            mp4config.tag.cover.data = artData;
-            mp4config.tag.cover.size = artSize;
+            fclose(outfile);
+            outfile = NULL;
         }
+    }
 
-        mp4atom_tail();
-        mp4atom_close();
-
-        free(version_string);
+    if (batch)
+    {
+        double elapsed = batch_clock() - batchbegin;
 
-        if (verbose >= 2)
+        batch_close(batch);
+        if (batchstats.files && elapsed > 0)
         {
-            fprintf(stderr, "%u frames\n", mp4config.frame.ents);
-            fprintf(stderr, "%u output samples\n", mp4config.samples);
-            fprintf(stderr, "max bitrate: %u\n", mp4config.bitrate.max);
-            fprintf(stderr, "avg bitrate: %u\n", mp4config.bitrate.avg);
-            fprintf(stderr, "max frame size: %u\n", mp4config.buffersize);
+            fprintf(stderr, "%d files, %.1f s of audio in %.1f s, "
+                    "%.2fx realtime\n", batchstats.files, batchstats.seconds,
+                    elapsed, batchstats.seconds / elapsed);
         }
     }
-    else
-    {
-        fclose(outfile);
-    }
-
-    faacEncClose(hEncoder);
-
-    wav_close(infile);
 
+    free(version_string);
     if (artData)
         free(artData);
-    if (pcmbuf)
-        free(pcmbuf);
-    if (bitbuf)
-        free(bitbuf);
     if (aacFileNameGiven)
         free(aacFileName);
 
-    return 0;
+    return status;
 }
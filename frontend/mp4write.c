@@ -888,6 +888,11 @@ int mp4atom_open(char *name, int over)
     }
 
     mp4config.mdatsize = 0;
+    mp4config.samples = 0;
+    mp4config.buffersize = 0;
+    mp4config.framesamples = 0;
+    memset(&mp4config.bitrate, 0, sizeof(mp4config.bitrate));
+    mp4config.frame.ents = 0;
     mp4config.frame.bufsize = BUFSTEP;
     mp4config.frame.data = malloc(mp4config.frame.bufsize);
 
@@ -0,0 +1,405 @@
+/****************************************************************************
+    Parallel encoding of input file segments
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+****************************************************************************/
+
+/*
+ * Every segment is coded by its own encoder, which starts PREROLL frames
+ * before the segment so the overlap buffer, the psychoacoustic history and
+ * the rate control have settled, and goes on TAIL frames into the next
+ * segment, fed with the real input as lookahead. Within that overlap the
+ * seam is put after the first frame both encoders coded with the same
+ * window sequence and shape. The MDCT windows on both sides of the seam
+ * then match and the aliasing cancels as in a serial encode.
+ *
+ * The last segment is flushed like the serial encoder, so frame count and
+ * duration are the same.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "segments.h"
+
+enum
+{
+    PREROLL = 16,       /* frames coded before a segment and dropped */
+    TAIL = 32,          /* frames coded into the next segment */
+    MINFRAMES = 96      /* shortest segment worth a separate encoder */
+};
+
+typedef struct
+{
+    const seginput_t *in;
+
+    int first;          /* first frame coded */
+    int end;            /* stop before this frame, unless last */
+    int last;           /* flush at the end of the input */
+
+    /* coded frames first, first + 1, ... */
+    unsigned char *data;
+    size_t bytes, alloc;
+    unsigned int *size;
+    int *window;        /* window_sequence << 1 | window_shape, or -1 */
+    int frames, maxframes;
+
+    int error;
+} segment_t;
+
+struct segments_s
+{
+    const seginput_t *in;
+    int frames;         /* as many as the serial encoder gives */
+    int segments;
+    segment_t *seg;
+    int *seam;
+};
+
+typedef struct
+{
+    const unsigned char *buf;
+    int pos, len;
+} bits_t;
+
+static unsigned int getbits(bits_t *b, int n)
+{
+    unsigned int v = 0;
+
+    while (n--)
+    {
+        int bit = 0;
+
+        if (b->pos < b->len)
+            bit = (b->buf[b->pos >> 3] >> (7 - (b->pos & 7))) & 1;
+        b->pos++;
+        v = (v << 1) | bit;
+    }
+
+    return v;
+}
+
+/* window of the first channel element of a frame, all channels use the
+   same block type */
+static int frame_window(const unsigned char *buf, int size, int adts)
+{
+    enum {ID_SCE = 0, ID_CPE = 1, ID_LFE = 3, ID_FIL = 6};
+    bits_t b;
+
+    b.buf = buf;
+    b.pos = 0;
+    b.len = size * 8;
+
+    if (adts)
+    {
+        /* protection_absent */
+        b.pos = (size > 1 && !(buf[1] & 1)) ? 72 : 56;
+    }
+
+    while (b.pos < b.len)
+    {
+        int id = getbits(&b, 3);
+
+        if (id == ID_FIL)
+        {
+            int count = getbits(&b, 4);
+
+            if (count == 15)
+                count += getbits(&b, 8) - 1;
+            b.pos += 8 * count;
+            continue;
+        }
+
+        if (id != ID_SCE && id != ID_CPE && id != ID_LFE)
+            break;
+
+        getbits(&b, 4); /* element_instance_tag */
+        if (id != ID_CPE || !getbits(&b, 1)) /* common_window */
+            getbits(&b, 8); /* global_gain */
+        getbits(&b, 1); /* ics_reserved_bit */
+
+        /* window_sequence, window_shape */
+        return getbits(&b, 3);
+    }
+
+    return -1;
+}
+
+static int store_frame(segment_t *seg, const unsigned char *buf, int bytes)
+{
+    if (seg->frames == seg->maxframes)
+    {
+        seg->maxframes = seg->maxframes ? 2 * seg->maxframes : 1024;
+        seg->size = realloc(seg->size, seg->maxframes * sizeof(*seg->size));
+        seg->window = realloc(seg->window, seg->maxframes * sizeof(*seg->window));
+        if (!seg->size || !seg->window)
+            return -1;
+    }
+    if (seg->bytes + bytes > seg->alloc)
+    {
+        seg->alloc = 2 * (seg->alloc + bytes);
+        seg->data = realloc(seg->data, seg->alloc);
+        if (!seg->data)
+            return -1;
+    }
+
+    memcpy(seg->data + seg->bytes, buf, bytes);
+    seg->bytes += bytes;
+    seg->size[seg->frames] = bytes;
+    /* LD frames have no element IDs to parse, all are long and sine
+       windowed */
+    if (seg->in->config.aacObjectType == LD)
+        seg->window[seg->frames] = 0;
+    else
+        seg->window[seg->frames] = frame_window(buf, bytes,
+                                                seg->in->config.outputFormat == ADTS_STREAM);
+    seg->frames++;
+
+    return 0;
+}
+
+void segments_run(segments_t *s, int segment)
+{
+    segment_t *seg = &s->seg[segment];
+    const seginput_t *in = seg->in;
+    const pcmfile_t *format = &in->format;
+    faacEncConfiguration config = in->config;
+    faacEncHandle hEncoder;
+    unsigned long samplesInput, maxBytesOutput;
+    uint64_t input_samples = (uint64_t)seg->first * in->frameSize;
+    uint64_t input_end = (uint64_t)seg->end * in->frameSize;
+    pcmfile_t *infile;
+    float *pcmbuf;
+    unsigned char *bitbuf;
+
+    seg->error = 1;
+
+    hEncoder = faacEncOpen(format->samplerate, format->channels,
+                           &samplesInput, &maxBytesOutput);
+    if (!hEncoder)
+        return;
+
+    /* the last frame needed is coded once its lookahead is in */
+    input_end += faacEncGetLatency(hEncoder);
+    if (seg->last || input_end > (uint64_t)format->samples)
+        input_end = format->samples;
+
+    infile = wav_open_read(in->path, in->rawinput);
+    if (!infile || !faacEncSetConfiguration(hEncoder, &config))
+    {
+        if (infile)
+            wav_close(infile);
+        faacEncClose(hEncoder);
+        return;
+    }
+    infile->bigendian = format->bigendian;
+    infile->channels = format->channels;
+    infile->samplebytes = format->samplebytes;
+    infile->samplerate = format->samplerate;
+    infile->isfloat = format->isfloat;
+    infile->samples = format->samples;
+
+    /* LD frames are shorter than faacEncOpen() assumed */
+    samplesInput = in->frameSize * format->channels;
+
+    pcmbuf = (float *) malloc(samplesInput * sizeof(float));
+    bitbuf = (unsigned char *) malloc(maxBytesOutput * sizeof(unsigned char));
+
+    if (pcmbuf && bitbuf && !wav_skip(infile, input_samples))
+    {
+        for (;;)
+        {
+            int samplesRead = 0;
+            int bytesWritten;
+
+            /* same reads as the serial encoding loop in main() */
+            if (input_samples < input_end)
+            {
+                samplesRead = wav_read_float32(infile, pcmbuf, samplesInput,
+                                               in->chanmap);
+                if (input_samples + (samplesRead / format->channels) > input_end)
+                    samplesRead = (input_end - input_samples) * format->channels;
+            }
+            input_samples += samplesRead / format->channels;
+
+            bytesWritten = faacEncEncode(hEncoder, (int32_t *) pcmbuf,
+                                         samplesRead, bitbuf, maxBytesOutput);
+            if (bytesWritten < 0)
+                break;
+
+            if (bytesWritten > 0 && store_frame(seg, bitbuf, bytesWritten))
+                break;
+
+            if (seg->last ? (!samplesRead && !bytesWritten)
+                : (seg->first + seg->frames >= seg->end))
+            {
+                seg->error = 0;
+                break;
+            }
+        }
+    }
+
+    free(pcmbuf);
+    free(bitbuf);
+    wav_close(infile);
+    faacEncClose(hEncoder);
+}
+
+int segments_count(const seginput_t *in, int jobs)
+{
+    int frames = (in->format.samples + in->frameSize - 1) / in->frameSize + 1;
+
+    if (jobs > frames / MINFRAMES)
+        jobs = frames / MINFRAMES;
+    if (jobs < 1)
+        jobs = 1;
+
+    return jobs;
+}
+
+segments_t *segments_open(const seginput_t *in, int segments)
+{
+    segments_t *s = (segments_t *) calloc(1, sizeof(*s));
+    int i;
+
+    if (!s)
+        return NULL;
+
+    s->in = in;
+    s->frames = (in->format.samples + in->frameSize - 1) / in->frameSize + 1;
+    s->segments = segments;
+    s->seg = (segment_t *) calloc(segments, sizeof(*s->seg));
+    s->seam = (int *) calloc(segments + 1, sizeof(*s->seam));
+    if (!s->seg || !s->seam)
+    {
+        free(s->seg);
+        free(s->seam);
+        free(s);
+        return NULL;
+    }
+
+    for (i = 0; i < segments; i++)
+    {
+        int start = (int)((int64_t)i * s->frames / segments);
+        int next = (int)((int64_t)(i + 1) * s->frames / segments);
+
+        s->seg[i].in = in;
+        s->seg[i].first = i ? start - PREROLL : 0;
+        s->seg[i].end = next + TAIL;
+        s->seg[i].last = (i == segments - 1);
+        s->seam[i] = start;
+    }
+    s->seam[segments] = s->frames;
+
+    return s;
+}
+
+int segments_join(segments_t *s, segframes_t *out)
+{
+    segment_t *seg = s->seg;
+    int *seam = s->seam;
+    int segments = s->segments;
+    int frames = s->frames;
+    int i, error = 0;
+
+    memset(out, 0, sizeof(*out));
+
+    for (i = 0; i < segments; i++)
+        error |= seg[i].error;
+    if (seg[segments - 1].first + seg[segments - 1].frames != frames)
+        error = 1;
+
+    /* move each seam to the first frame after one coded alike */
+    for (i = 1; i < segments && !error; i++)
+    {
+        int k;
+
+        for (k = seam[i]; k <= seam[i] + TAIL; k++)
+        {
+            int w0 = seg[i - 1].window[k - 1 - seg[i - 1].first];
+            int w1 = seg[i].window[k - 1 - seg[i].first];
+
+            if (w0 >= 0 && w0 == w1)
+                break;
+        }
+        if (k > seam[i] + TAIL)
+        {
+            fprintf(stderr, "segment seam at frame %d: no matching window\n",
+                    seam[i]);
+            k = seam[i];
+        }
+        seam[i] = k;
+    }
+
+    if (!error)
+    {
+        size_t bytes = 0;
+
+        out->size = (unsigned int *) malloc(frames * sizeof(*out->size));
+        for (i = 0; i < segments; i++)
+            bytes += seg[i].bytes;
+        out->data = (unsigned char *) malloc(bytes);
+        if (!out->size || !out->data)
+            error = 1;
+        bytes = 0;
+
+        for (i = 0; i < segments && !error; i++)
+        {
+            size_t ofs = 0;
+            int k;
+
+            for (k = seg[i].first; k < seam[i + 1]; k++)
+            {
+                unsigned int size = seg[i].size[k - seg[i].first];
+
+                if (k >= seam[i])
+                {
+                    memcpy(out->data + bytes, seg[i].data + ofs, size);
+                    out->size[out->frames++] = size;
+                    bytes += size;
+                }
+                ofs += size;
+            }
+        }
+    }
+
+    for (i = 0; i < segments; i++)
+    {
+        free(seg[i].data);
+        free(seg[i].size);
+        free(seg[i].window);
+    }
+    free(seg);
+    free(seam);
+    free(s);
+
+    if (error)
+    {
+        segments_free(out);
+        return -1;
+    }
+    return 0;
+}
+
+void segments_free(segframes_t *out)
+{
+    free(out->data);
+    free(out->size);
+    memset(out, 0, sizeof(*out));
+}
@@ -0,0 +1,59 @@
+/****************************************************************************
+    Parallel encoding of input file segments
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+****************************************************************************/
+
+#ifndef SEGMENTS_H
+#define SEGMENTS_H
+
+#include <faac.h>
+#include "input.h"
+
+typedef struct
+{
+    const char *path;           /* input file, must be seekable */
+    int rawinput;               /* as passed to wav_open_read() */
+    pcmfile_t format;           /* input parameters as set up by main(),
+                                   the file itself is not used */
+    int *chanmap;
+    faacEncConfiguration config; /* as passed to faacEncSetConfiguration() */
+    unsigned int frameSize;     /* samples per channel in a frame */
+} seginput_t;
+
+typedef struct
+{
+    unsigned char *data;        /* all frames back to back */
+    unsigned int *size;         /* size of every frame */
+    unsigned int frames;
+} segframes_t;
+
+typedef struct segments_s segments_t;
+
+/* number of segments worth encoding in parallel, 1 if none */
+int segments_count(const seginput_t *in, int jobs);
+
+/* Split the input into segments, each coded by segments_run() on its own
+   encoder. Different segments may run in different threads at once. */
+segments_t *segments_open(const seginput_t *in, int segments);
+void segments_run(segments_t *s, int segment);
+
+/* Join the frames of all segments and free s. There are as many frames as
+   the serial encoder gives, and the seams fall on frames where both
+   segments chose the same window, so the stream decodes without clicks.
+   Returns 0 on success. */
+int segments_join(segments_t *s, segframes_t *out);
+void segments_free(segframes_t *out);
+
+#endif
@@ -84,6 +84,119 @@ int FAACAPI faacEncEncode(faacEncHandle hEncoder, int32_t * inputBuffer, unsigne
 			 unsigned char *outputBuffer,
 			 unsigned int bufferSize);
 
+/*
+	Same as faacEncEncode() but takes one float array per channel
+	(same range as FAAC_INPUT_FLOAT) instead of an interleaved buffer.
+	config.inputFormat is ignored, config.channel_map is applied.
+	samplesPerChannel is at most inputSamples/numChannels, 0 flushes.
+*/
+int FAACAPI faacEncEncodePlanar(faacEncHandle hEncoder, const float *const *channels,
+			 unsigned int samplesPerChannel,
+			 unsigned char *outputBuffer,
+			 unsigned int bufferSize);
+
+/*
+	Encode the channel elements (SCE, CPE, LFE) of a frame on up to
+	numThreads threads, the calling one included. The output does not
+	change. 0 or 1 switches back to single threaded encoding.
+	Returns 0 if no worker thread could be started.
+*/
+int FAACAPI faacEncSetThreads(faacEncHandle hEncoder, unsigned int numThreads);
+
+/*
+	Pipelined mode: code a frame (filterbank, quantization, bitstream)
+	on a second thread while the next one is loaded and analysed. Every
+	call then returns the frame of the call before, see
+	faacEncGetLatency(). The output does not change otherwise.
+	Only before the first frame is encoded; returns 0 on failure.
+*/
+int FAACAPI faacEncSetPipeline(faacEncHandle hEncoder, unsigned int enable);
+
+/*
+	Low delay mode: code a frame as soon as the block switching decision
+	can be made, one frame after it was passed in instead of three, or
+	at once when block switching is off (shortctl SHORTCTL_NOSHORT or
+	SHORTCTL_NOLONG). The frames are the same as without it.
+	Only before the first frame is encoded; returns 0 on failure.
+*/
+int FAACAPI faacEncSetLowDelay(faacEncHandle hEncoder, unsigned int enable);
+
+/*
+	Number of samples per channel the output lags behind the input:
+	the frame returned by a call was passed in this many samples before.
+*/
+unsigned int FAACAPI faacEncGetLatency(faacEncHandle hEncoder);
+
+/*
+	Number of samples per channel a decoder outputs before the first
+	input sample, for the muxer to skip. Together with
+	faacEncGetLatency() this is the delay from the encoder input to the
+	decoder output.
+*/
+unsigned int FAACAPI faacEncGetDelay(faacEncHandle hEncoder);
+
+/*
+	Number of samples per channel in a frame: 1024, or 512 with the LD
+	object type, 960 and 480 after faacEncSetFrameLength(). faacEncOpen()
+	reports the input size for 1024, a caller configuring LD or 960
+	passes this many samples per call instead.
+*/
+unsigned int FAACAPI faacEncGetFrameLength(faacEncHandle hEncoder);
+
+/*
+	Frame length of the stream, one of the two of the object type
+	configured first: 1024 or 960 samples, 512 or 480 with LD. 960 is
+	signalled in the decoder specific info only, so it needs a raw MPEG-4
+	stream configured first. Encoders of any length can be used at the
+	same time. libavcodec (62) decodes 480 sample LD frames wrongly,
+	other decoders may too.
+	Only before the first frame is encoded; returns 0 on failure.
+*/
+int FAACAPI faacEncSetFrameLength(faacEncHandle hEncoder, unsigned int frameLength);
+
+/*
+	Code the frames of hEncoder at other bitrates too: each of the numRungs
+	encoders, opened and configured like hEncoder but for bitrate,
+	quality, bandwidth and output format, codes the spectra of hEncoder
+	with its own stereo, quantization and rate control. Input, psychoacoustic
+	model, block switching and filterbank run once, so all streams switch
+	windows on the same frames. The rungs are driven by
+	faacEncEncodeLadder() only and are still closed by the caller.
+	Not with pipelined mode, only before the first frame is encoded;
+	0 rungs removes the ladder. Returns 0 on failure.
+*/
+int FAACAPI faacEncSetLadder(faacEncHandle hEncoder, faacEncHandle *rungs,
+			     unsigned int numRungs);
+
+/*
+	Same as faacEncEncode() and codes the frame of every rung of the ladder
+	into rungBuffers[i], at most rungBufferSizes[i] bytes. rungBytes[i]
+	gets the size of the rung's frame, written whenever hEncoder returns
+	one. Returns the bytes of the frame of hEncoder, or -1 on failure.
+*/
+int FAACAPI faacEncEncodeLadder(faacEncHandle hEncoder, int32_t *inputBuffer,
+				unsigned int samplesInput,
+				unsigned char *outputBuffer,
+				unsigned int bufferSize,
+				unsigned char **rungBuffers,
+				const unsigned int *rungBufferSizes,
+				int *rungBytes);
+
+/*
+	Start a new stream with the same configuration, as if the encoder had
+	just been opened and configured. Keeps the tables and threads, only
+	the state carried between frames is cleared. Frames not yet returned
+	are dropped.
+*/
+int FAACAPI faacEncReset(faacEncHandle hEncoder);
+
+/*
+	Bytes of memory the encoder instance holds for itself: the handle
+	and its per-channel state and buffers. The tables and windows shared
+	by all encoders of the process and the worker threads are not
+	counted.
+*/
+unsigned long FAACAPI faacEncGetFootprint(faacEncHandle hEncoder);
 
 int FAACAPI faacEncClose(faacEncHandle hEncoder);
 
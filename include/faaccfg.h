@@ -33,6 +33,7 @@
 #define LOW  2
 #define SSR  3
 #define LTP  4
+#define LD   23 /* AAC-LD, 512 sample frames, MPEG-4 raw output only */
 
 /* Input Formats */
 #define FAAC_INPUT_NULL    0
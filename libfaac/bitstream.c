@@ -34,11 +34,6 @@ Copyright (c) 1997.
 #include "bitstream.h"
 #include "util.h"
 
-static int CountBitstream(faacEncStruct* hEncoder,
-                          CoderInfo *coderInfo,
-                          ChannelInfo *channelInfo,
-                          BitStream *bitStream,
-                          int numChannels);
 static int WriteADTSHeader(faacEncStruct* hEncoder,
                            BitStream *bitStream,
                            int writeFlag);
@@ -85,16 +80,15 @@ static int WriteAACFillBits(BitStream* bitStream,
                             int writeFlag);
 static int FindGroupingBits(CoderInfo *coderInfo);
 static long BufferNumBit(BitStream *bitStream);
-static int WriteByte(BitStream *bitStream,
-                     unsigned long data,
-                     int numBit);
+static void FlushBits(BitStream *bitStream);
+static int PutBitAt(BitStream *bitStream,
+                    unsigned long curpos,
+                    unsigned long data,
+                    int numBit);
 static int ByteAlign(BitStream* bitStream,
                      int writeFlag, int bitsSoFar);
 #ifdef DRM
-static int PutBitHcr(BitStream *bitStream,
-                     unsigned long curpos,
-                     unsigned long data,
-                     int numBit);
+static void SeekBit(BitStream *bitStream, long pos);
 static int rewind_word(int W, int len);
 static int WriteReorderedSpectralData(CoderInfo *coderInfo,
                                       BitStream *bitStream,
@@ -152,9 +146,7 @@ int WriteBitstream(faacEncStruct* hEncoder,
     int channel;
     int bits = 0;
     int bitsLeftAfterFill, numFillBits;
-
-    if (CountBitstream(hEncoder, coderInfo, channelInfo, bitStream, numChannel) < 0)
-        return -1;
+    long startBit = BufferNumBit(bitStream);
 
     if(hEncoder->config.outputFormat == 1){
         bits += WriteADTSHeader(hEncoder, bitStream, 1);
@@ -164,7 +156,8 @@ int WriteBitstream(faacEncStruct* hEncoder,
 
 /* sur: faad2 complains about scalefactor error if we are writing FAAC String */
 #ifndef DRM
-    if (hEncoder->frameNum == 4)
+    if (hEncoder->codeFrameNum == hEncoder->lookahead + 1 /* first frame */
+        && hEncoder->config.aacObjectType != LD)
       WriteFAACStr(bitStream, hEncoder->config.name, 1);
 #endif
 
@@ -206,23 +199,26 @@ int WriteBitstream(faacEncStruct* hEncoder,
         }
     }
 
-    /* Compute how many fill bits are needed to avoid overflowing bit reservoir */
-    /* Save room for ID_END terminator */
-    if (bits < (8 - LEN_SE_ID) ) {
-        numFillBits = 8 - LEN_SE_ID - bits;
-    } else {
-        numFillBits = 0;
-    }
+    /* er_raw_data_block() (LD) ends with the last channel element */
+    if (hEncoder->config.aacObjectType != LD) {
+        /* Compute how many fill bits are needed to avoid overflowing bit reservoir */
+        /* Save room for ID_END terminator */
+        if (bits < (8 - LEN_SE_ID) ) {
+            numFillBits = 8 - LEN_SE_ID - bits;
+        } else {
+            numFillBits = 0;
+        }
 
-    /* Write AAC fill_elements, smallest fill element is 7 bits. */
-    /* Function may leave up to 6 bits left after fill, so tell it to fill a few extra */
-    numFillBits += 6;
-    bitsLeftAfterFill = WriteAACFillBits(bitStream, numFillBits, 1);
-    bits += (numFillBits - bitsLeftAfterFill);
+        /* Write AAC fill_elements, smallest fill element is 7 bits. */
+        /* Function may leave up to 6 bits left after fill, so tell it to fill a few extra */
+        numFillBits += 6;
+        bitsLeftAfterFill = WriteAACFillBits(bitStream, numFillBits, 1);
+        bits += (numFillBits - bitsLeftAfterFill);
 
-    /* Write ID_END terminator */
-    bits += LEN_SE_ID;
-    PutBit(bitStream, ID_END, LEN_SE_ID);
+        /* Write ID_END terminator */
+        bits += LEN_SE_ID;
+        PutBit(bitStream, ID_END, LEN_SE_ID);
+    }
 
     /* Now byte align the bitstream */
     /*
@@ -232,91 +228,7 @@ int WriteBitstream(faacEncStruct* hEncoder,
      */
     bits += ByteAlign(bitStream, 1, bits);
 
-    return bits;
-}
-
-static int CountBitstream(faacEncStruct* hEncoder,
-                          CoderInfo *coderInfo,
-                          ChannelInfo *channelInfo,
-                          BitStream *bitStream,
-                          int numChannel)
-{
-    int channel;
-    int bits = 0;
-    int bitsLeftAfterFill, numFillBits;
-
-
-    if(hEncoder->config.outputFormat == 1){
-        bits += WriteADTSHeader(hEncoder, bitStream, 0);
-    }else{
-        bits = 0; // compilier will remove it, byt anyone will see that current size of bitstream is 0
-    }
-
-/* sur: faad2 complains about scalefactor error if we are writing FAAC String */
-#ifndef DRM
-    if (hEncoder->frameNum == 4)
-      bits += WriteFAACStr(bitStream, hEncoder->config.name, 0);
-#endif
-
-    for (channel = 0; channel < numChannel; channel++) {
-
-        if (channelInfo[channel].present) {
-
-            /* Write out a single_channel_element */
-            if (!channelInfo[channel].cpe) {
-
-                if (channelInfo[channel].lfe) {
-                    /* Write out lfe */
-                    bits += WriteLFE(&coderInfo[channel],
-                        &channelInfo[channel],
-                        bitStream,
-                        hEncoder->config.aacObjectType,
-                        0);
-                } else {
-                    /* Write out sce */
-                    bits += WriteSCE(&coderInfo[channel],
-                        &channelInfo[channel],
-                        bitStream,
-                        hEncoder->config.aacObjectType,
-                        0);
-                }
-
-            } else {
-
-                if (channelInfo[channel].ch_is_left) {
-                    /* Write out cpe */
-                    bits += WriteCPE(&coderInfo[channel],
-                        &coderInfo[channelInfo[channel].paired_ch],
-                        &channelInfo[channel],
-                        bitStream,
-                        hEncoder->config.aacObjectType,
-                        0);
-                }
-            }
-        }
-    }
-
-    /* Compute how many fill bits are needed to avoid overflowing bit reservoir */
-    /* Save room for ID_END terminator */
-    if (bits < (8 - LEN_SE_ID) ) {
-        numFillBits = 8 - LEN_SE_ID - bits;
-    } else {
-        numFillBits = 0;
-    }
-
-    /* Write AAC fill_elements, smallest fill element is 7 bits. */
-    /* Function may leave up to 6 bits left after fill, so tell it to fill a few extra */
-    numFillBits += 6;
-    bitsLeftAfterFill = WriteAACFillBits(bitStream, numFillBits, 0);
-    bits += (numFillBits - bitsLeftAfterFill);
-
-    /* Write ID_END terminator */
-    bits += LEN_SE_ID;
-
-    /* Now byte align the bitstream */
-    bits += ByteAlign(bitStream, 0, bits);
-
-    hEncoder->usedBytes = bit2byte(bits);
+    hEncoder->usedBytes = bit2byte(BufferNumBit(bitStream) - startBit);
 
     if (hEncoder->usedBytes > bitStream->size)
     {
@@ -329,6 +241,13 @@ static int CountBitstream(faacEncStruct* hEncoder,
         return -1;
     }
 
+    /* the frame length of the ADTS header is known only now */
+    if (hEncoder->config.outputFormat == 1)
+    {
+        FlushBits(bitStream);
+        PutBitAt(bitStream, startBit + ADTS_LENGTH_POS, hEncoder->usedBytes, 13);
+    }
+
     return bits;
 }
 
@@ -362,7 +281,7 @@ static int WriteADTSHeader(faacEncStruct* hEncoder,
         /* Variable ADTS header */
         PutBit(bitStream, 0, 1); /* copyr. id. bit */
         PutBit(bitStream, 0, 1); /* copyr. id. start */
-        PutBit(bitStream, hEncoder->usedBytes, 13);
+        PutBit(bitStream, 0, 13); /* frame length, see WriteBitstream() */
         PutBit(bitStream, 0x7FF, 11); /* buffer fullness (0x7FF for VBR) */
         PutBit(bitStream, 0, 2); /* raw data blocks (0+1=1) */
 
@@ -396,8 +315,10 @@ static int WriteCPE(CoderInfo *coderInfoL,
 
 #ifndef DRM
     if (writeFlag) {
-        /* write ID_CPE, single_element_channel() identifier */
-        PutBit(bitStream, ID_CPE, LEN_SE_ID);
+        /* write ID_CPE, single_element_channel() identifier; LD (ER)
+           streams have the elements in a fixed order, without IDs */
+        if (objectType != LD)
+            PutBit(bitStream, ID_CPE, LEN_SE_ID);
 
         /* write the element_identifier_tag */
         PutBit(bitStream, channelInfo->tag, LEN_TAG);
@@ -406,7 +327,8 @@ static int WriteCPE(CoderInfo *coderInfoL,
         PutBit(bitStream, channelInfo->common_window, LEN_COM_WIN);
     }
 
-    bits += LEN_SE_ID;
+    if (objectType != LD)
+        bits += LEN_SE_ID;
     bits += LEN_TAG;
     bits += LEN_COM_WIN;
 #endif
@@ -454,13 +376,15 @@ static int WriteSCE(CoderInfo *coderInfo,
 #ifndef DRM
     if (writeFlag) {
         /* write Single Element Channel (SCE) identifier */
-        PutBit(bitStream, ID_SCE, LEN_SE_ID);
+        if (objectType != LD)
+            PutBit(bitStream, ID_SCE, LEN_SE_ID);
 
         /* write the element identifier tag */
         PutBit(bitStream, channelInfo->tag, LEN_TAG);
     }
 
-    bits += LEN_SE_ID;
+    if (objectType != LD)
+        bits += LEN_SE_ID;
     bits += LEN_TAG;
 #endif
 
@@ -480,13 +404,15 @@ static int WriteLFE(CoderInfo *coderInfo,
 
     if (writeFlag) {
         /* write ID_LFE, lfe_element_channel() identifier */
-        PutBit(bitStream, ID_LFE, LEN_SE_ID);
+        if (objectType != LD)
+            PutBit(bitStream, ID_LFE, LEN_SE_ID);
 
         /* write the element_identifier_tag */
         PutBit(bitStream, channelInfo->tag, LEN_TAG);
     }
 
-    bits += LEN_SE_ID;
+    if (objectType != LD)
+        bits += LEN_SE_ID;
     bits += LEN_TAG;
 
     /* Write an individual_channel_stream element */
@@ -601,7 +527,10 @@ static int WriteICS(CoderInfo *coderInfo,
 #ifdef DRM
     /* DRM CRC calculation */
     if (writeFlag)
+    {
+        FlushBits(bitStream);
         calc_CRC(bitStream, bits);
+    }
 
     bits += WriteReorderedSpectralData(coderInfo, bitStream, writeFlag);
 #else
@@ -836,33 +765,32 @@ static int FindGroupingBits(CoderInfo *coderInfo)
 }
 
 /* size in bytes! */
-BitStream *OpenBitStream(int size, unsigned char *buffer)
+/* bitStream is owned by the caller, nothing is allocated here */
+/* the buffer is not cleared, only the bytes of the frame are written */
+void OpenBitStream(BitStream *bitStream, int size, unsigned char *buffer)
 {
-    BitStream *bitStream;
-
-    bitStream = AllocMemory(sizeof(BitStream));
     bitStream->size = size;
 #ifdef DRM
     /* skip first byte for CRC */
     bitStream->numBit = 8;
     bitStream->currentBit = 8;
+    if (size > 0)
+        buffer[0] = 0;
 #else
     bitStream->numBit = 0;
     bitStream->currentBit = 0;
 #endif
     bitStream->data = buffer;
-    SetMemory(bitStream->data, 0, size);
-
-    return bitStream;
+    bitStream->numByte = 0;
+    bitStream->cache = 0;
+    bitStream->cacheBits = 0;
 }
 
 int CloseBitStream(BitStream *bitStream)
 {
-    int bytes = bit2byte(bitStream->numBit);
-
-    FreeMemory(bitStream);
+    FlushBits(bitStream);
 
-    return bytes;
+    return bit2byte(bitStream->numBit);
 }
 
 static long BufferNumBit(BitStream *bitStream)
@@ -870,47 +798,95 @@ static long BufferNumBit(BitStream *bitStream)
     return bitStream->numBit;
 }
 
-static int WriteByte(BitStream *bitStream,
-                     unsigned long data,
-                     int numBit)
+/* big endian word at byte idx, what does not fit in the buffer is dropped */
+static void StoreWord(BitStream *bitStream, long idx, uint32_t word)
 {
-    long numUsed,idx;
+    unsigned char *p = bitStream->data + idx;
+    int i;
 
-    idx = (bitStream->currentBit / BYTE_NUMBIT) % bitStream->size;
-    numUsed = bitStream->currentBit % BYTE_NUMBIT;
-#ifndef DRM
-    if (numUsed == 0)
-        bitStream->data[idx] = 0;
-#endif
-    bitStream->data[idx] |= (data & ((1<<numBit)-1)) <<
-        (BYTE_NUMBIT-numUsed-numBit);
-    bitStream->currentBit += numBit;
-    bitStream->numBit = bitStream->currentBit;
+    if (idx + 4 <= bitStream->size)
+    {
+        p[0] = word >> 24;
+        p[1] = word >> 16;
+        p[2] = word >> 8;
+        p[3] = word;
+        return;
+    }
 
-    return 0;
+    for (i = 0; i < 4 && idx + i < bitStream->size; i++)
+        p[i] = word >> (24 - 8 * i);
 }
 
+/* store the cached bits, a partial last byte padded with zeros; that one
+   stays in the cache and is stored again when it is complete */
+static void FlushBits(BitStream *bitStream)
+{
+    int bits = bitStream->cacheBits;
+    long idx = (bitStream->currentBit - bits) / BYTE_NUMBIT;
+
+    for (; bits >= BYTE_NUMBIT; bits -= BYTE_NUMBIT, idx++)
+    {
+        if (idx < bitStream->size)
+            bitStream->data[idx] = bitStream->cache >> (bits - BYTE_NUMBIT);
+    }
+    if (bits && idx < bitStream->size)
+        bitStream->data[idx] = bitStream->cache << (BYTE_NUMBIT - bits);
+
+    bitStream->cacheBits = bits;
+}
+
+/* numBit is at most LONG_NUMBIT; the bits are collected in the cache,
+   which starts on a byte boundary, and stored 32 at a time */
 int PutBit(BitStream *bitStream,
            unsigned long data,
            int numBit)
 {
-    int num,maxNum,curNum;
-    unsigned long bits;
+    uint64_t cache;
+    int bits;
 
     if (numBit == 0)
         return 0;
 
-    /* write bits in packets according to buffer byte boundaries */
-    num = 0;
-    maxNum = BYTE_NUMBIT - bitStream->currentBit % BYTE_NUMBIT;
-    while (num < numBit) {
-        curNum = min(numBit-num,maxNum);
-        bits = data>>(numBit-num-curNum);
-        if (WriteByte(bitStream, bits, curNum)) {
+    cache = (bitStream->cache << numBit)
+        | (data & (((uint64_t)1 << numBit) - 1));
+    bits = bitStream->cacheBits + numBit;
+    bitStream->currentBit += numBit;
+    bitStream->numBit = bitStream->currentBit;
+
+    if (bits >= LONG_NUMBIT)
+    {
+        bits -= LONG_NUMBIT;
+        StoreWord(bitStream,
+                  (bitStream->currentBit - bits) / BYTE_NUMBIT - 4,
+                  (uint32_t)(cache >> bits));
+    }
+
+    bitStream->cache = cache;
+    bitStream->cacheBits = bits;
+
+    return 0;
+}
+
+static int PutBitAt(BitStream *bitStream,
+                    unsigned long curpos,
+                    unsigned long data,
+                    int numBit)
+{ /* data can be written at an arbitrary position in the bitstream, it is
+     ORed into the stored bytes, so the cache has to be flushed before */
+    long idx = curpos / BYTE_NUMBIT;
+    int used = curpos % BYTE_NUMBIT;
+    uint64_t bits;
+
+    if (numBit == 0)
+        return 0;
+
+    bits = (data & (((uint64_t)1 << numBit) - 1)) << (64 - used - numBit);
+    for (numBit += used; numBit > 0; numBit -= BYTE_NUMBIT, idx++)
+    {
+        if (idx >= bitStream->size)
             return 1;
-        }
-        num += curNum;
-        maxNum = BYTE_NUMBIT;
+        bitStream->data[idx] |= bits >> 56;
+        bits <<= BYTE_NUMBIT;
     }
 
     return 0;
@@ -968,13 +944,16 @@ typedef struct { /* codeword parameters */
     unsigned short num_data; /* number of data cells for codeword */
 } cw_info_t;
 
-static int PutBitHcr(BitStream *bitStream,
-                     unsigned long curpos,
-                     unsigned long data,
-                     int numBit)
-{ /* data can be written at an arbitrary position in the bitstream */
-    bitStream->currentBit = curpos;
-    return PutBit(bitStream, data, numBit);
+static void SeekBit(BitStream *bitStream, long pos)
+{ /* continue writing at pos, keeping the bits stored before it in its
+     byte; the cache has to be flushed before */
+    bitStream->currentBit = pos;
+    bitStream->numBit = pos;
+    bitStream->cacheBits = pos % BYTE_NUMBIT;
+    bitStream->cache = 0;
+    if (bitStream->cacheBits && pos / BYTE_NUMBIT < bitStream->size)
+        bitStream->cache = bitStream->data[pos / BYTE_NUMBIT]
+            >> (BYTE_NUMBIT - bitStream->cacheBits);
 }
 
 static int rewind_word(int W, int len)
@@ -1022,7 +1001,8 @@ static int WriteReorderedSpectralData(CoderInfo *coder,
     /* len array contains lengths of data words */
     int* num_data = coder->num_data_cw;
 
-    if (writeFlag) {
+    /* a channel without spectral data has no segments to fill */
+    if (writeFlag && num_cw) {
         /* build offset table */
         cur_data = 0;
         cw_info[0].cw_offset = 0;
@@ -1070,7 +1050,8 @@ static int WriteReorderedSpectralData(CoderInfo *coder,
 
                     /* new codebook and sfb length */
                     cur_cb = coder->book[sfb_cnt];
-                    if (last_sfb < FRAME_LEN) {
+                    /* past the last window group at the end of the frame */
+                    if (win_grp_cnt < coder->groups.n) {
                         cur_sfb_len = (sfb_offset[sfb_cnt + 1] - sfb_offset[sfb_cnt])
                             / groups[win_grp_cnt];
                     }
@@ -1152,6 +1133,18 @@ static int WriteReorderedSpectralData(CoderInfo *coder,
 
         /* store current bit position */
         startbitpos = bitStream->currentBit;
+        FlushBits(bitStream);
+
+        /* the codewords are ORed in, clear the bytes not stored yet */
+        {
+            long first = bit2byte(startbitpos);
+            long end = bit2byte(startbitpos + coder->iLenReordSpData);
+
+            if (end > bitStream->size)
+                end = bitStream->size;
+            if (end > first)
+                SetMemory(bitStream->data + first, 0, end - first);
+        }
 
         /* write write priority codewords (PCWs) and nonPCWs ---------------- */
         num_sets = num_cw / segmcnt; /* number of sets */
@@ -1201,12 +1194,12 @@ static int WriteReorderedSpectralData(CoderInfo *coder,
                                 /* write complete data, no partitioning */
                                 if (is_backwards) {
                                     /* write data in reversed bit-order */
-                                    PutBitHcr(bitStream, startbitpos + segment[segment_index].right - coder->s[cur_cw_part].len + 1,
+                                    PutBitAt(bitStream, startbitpos + segment[segment_index].right - coder->s[cur_cw_part].len + 1,
                                         rewind_word(coder->s[cur_cw_part].data, coder->s[cur_cw_part].len), coder->s[cur_cw_part].len);
 
                                     segment[segment_index].right -= coder->s[cur_cw_part].len;
                                 } else {
-                                    PutBitHcr(bitStream, startbitpos + segment[segment_index].left,
+                                    PutBitAt(bitStream, startbitpos + segment[segment_index].left,
                                         coder->s[cur_cw_part].data, coder->s[cur_cw_part].len);
 
                                     segment[segment_index].left += coder->s[cur_cw_part].len;
@@ -1228,12 +1221,12 @@ static int WriteReorderedSpectralData(CoderInfo *coder,
 
                                 if (is_backwards) {
                                     /* write data in reversed bit-order */
-                                    PutBitHcr(bitStream, startbitpos + segment[segment_index].right - tmplen + 1,
+                                    PutBitAt(bitStream, startbitpos + segment[segment_index].right - tmplen + 1,
                                         rewind_word(tmp_data, tmplen), tmplen);
 
                                     segment[segment_index].right -= tmplen;
                                 } else {
-                                    PutBitHcr(bitStream, startbitpos + segment[segment_index].left,
+                                    PutBitAt(bitStream, startbitpos + segment[segment_index].left,
                                         tmp_data, tmplen);
 
                                     segment[segment_index].left += tmplen;
@@ -1254,8 +1247,7 @@ static int WriteReorderedSpectralData(CoderInfo *coder,
         }
 
         /* set parameter for bit stream to current correct position */
-        bitStream->currentBit = startbitpos + coder->iLenReordSpData;
-        bitStream->numBit = bitStream->currentBit;
+        SeekBit(bitStream, startbitpos + coder->iLenReordSpData);
     }
 
     return coder->iLenReordSpData;
@@ -134,6 +134,8 @@ extern "C" {
 #define bit2byte(a) (((a)+BYTE_NUMBIT-1)/BYTE_NUMBIT)
 
 enum {ADTS_FRAMESIZE = 1 << 13};
+/* bit position of frame_length in the ADTS header */
+enum {ADTS_LENGTH_POS = 30};
 
 typedef struct
 {
@@ -142,6 +144,8 @@ typedef struct
   long size;            /* buffer size in bytes */
   long currentBit;      /* current bit position in bit stream */
   long numByte;         /* number of bytes read/written (only file) */
+  uint64_t cache;       /* bits not stored yet, the last one lowest */
+  int cacheBits;        /* number of them, less than LONG_NUMBIT */
 } BitStream;
 
 
@@ -153,7 +157,7 @@ int WriteBitstream(faacEncStruct* hEncoder,
                    int numChannels);
 
 
-BitStream *OpenBitStream(int size, unsigned char *buffer);
+void OpenBitStream(BitStream *bitStream, int size, unsigned char *buffer);
 
 int CloseBitStream(BitStream *bitStream);
 
@@ -24,12 +24,15 @@
 
 #include "blockswitch.h"
 #include "coder.h"
-#include "fft.h"
+#include "mdct.h"
 #include "util.h"
 #include <faac.h>
 
 typedef float psyfloat;
 
+/* short windows looked at before and after the frame */
+enum {PREVS = 2, NEXTS = 2};
+
 typedef struct
 {
   /* bandwidth */
@@ -41,27 +44,14 @@ typedef struct
   psyfloat *eng[8];
   psyfloat *engNext[8];
   psyfloat *engNext2[8];
+
+  /* low delay mode: the first windows after engNext2, which only
+     need the newest samples */
+  psyfloat engEarly[NEXTS][NSFB_SHORT];
 }
 psydata_t;
 
 
-static void Hann(GlobalPsyInfo * gpsyInfo, double *inSamples, int size)
-{
-  int i;
-
-  /* Applying Hann window */
-  if (size == BLOCK_LEN_LONG * 2)
-  {
-    for (i = 0; i < size; i++)
-      inSamples[i] *= gpsyInfo->hannWindow[i];
-  }
-  else
-  {
-    for (i = 0; i < size; i++)
-      inSamples[i] *= gpsyInfo->hannWindowS[i];
-  }
-}
-
 #define PRINTSTAT 0
 #if PRINTSTAT
 static struct {
@@ -70,28 +60,40 @@ static struct {
 } frames;
 #endif
 
-static void PsyCheckShort(PsyInfo * psyInfo, double quality)
+static void PsyCheckShort(PsyInfo * psyInfo, double quality, int lowDelay)
 {
-  enum {PREVS = 2, NEXTS = 2};
   psydata_t *psydata = psyInfo->data;
   int lastband = psydata->lastband;
   int firstband = 2;
   int sfb, win;
   psyfloat *lasteng;
+  psyfloat **engPrev = psydata->engPrev;
+  psyfloat **eng = psydata->eng;
+  psyfloat *engNext[NEXTS];
+
+  /* the frame after the one being coded, with its neighbours; in low
+     delay mode that is the newest one */
+  if (lowDelay)
+  {
+    engPrev = psydata->engNext;
+    eng = psydata->engNext2;
+  }
+  for (win = 0; win < NEXTS; win++)
+    engNext[win] = lowDelay ? psydata->engEarly[win] : psydata->engNext[win];
 
   psyInfo->block_type = ONLY_LONG_WINDOW;
 
   lasteng = NULL;
   for (win = 0; win < PREVS + 8 + NEXTS; win++)
   {
-      psyfloat *eng;
+      psyfloat *e;
 
       if (win < PREVS)
-          eng = psydata->engPrev[win + 8 - PREVS];
+          e = engPrev[win + 8 - PREVS];
       else if (win < (PREVS + 8))
-          eng = psydata->eng[win - PREVS];
+          e = eng[win - PREVS];
       else
-          eng = psydata->engNext[win - PREVS - 8];
+          e = engNext[win - PREVS - 8];
 
       if (lasteng)
       {
@@ -100,8 +102,8 @@ static void PsyCheckShort(PsyInfo * psyInfo, double quality)
 
           for (sfb = firstband; sfb < lastband; sfb++)
           {
-              toteng += (eng[sfb] < lasteng[sfb]) ? eng[sfb] : lasteng[sfb];
-              volchg += fabs(eng[sfb] - lasteng[sfb]);
+              toteng += (e[sfb] < lasteng[sfb]) ? e[sfb] : lasteng[sfb];
+              volchg += fabs(e[sfb] - lasteng[sfb]);
           }
 
           if ((volchg / toteng * quality) > 3.0)
@@ -110,7 +112,7 @@ static void PsyCheckShort(PsyInfo * psyInfo, double quality)
               break;
           }
       }
-      lasteng = eng;
+      lasteng = e;
   }
 
 #if PRINTSTAT
@@ -125,38 +127,28 @@ static void PsyInit(GlobalPsyInfo * gpsyInfo, PsyInfo * psyInfo, unsigned int nu
 		    int *cb_width_short, int num_cb_short)
 {
   unsigned int channel;
-  int i, j, size;
-
-  gpsyInfo->hannWindow =
-    (double *) AllocMemory(2 * BLOCK_LEN_LONG * sizeof(double));
-  gpsyInfo->hannWindowS =
-    (double *) AllocMemory(2 * BLOCK_LEN_SHORT * sizeof(double));
-
-  for (i = 0; i < BLOCK_LEN_LONG * 2; i++)
-    gpsyInfo->hannWindow[i] = 0.5 * (1 - cos(2.0 * M_PI * (i + 0.5) /
-					     (BLOCK_LEN_LONG * 2)));
-  for (i = 0; i < BLOCK_LEN_SHORT * 2; i++)
-    gpsyInfo->hannWindowS[i] = 0.5 * (1 - cos(2.0 * M_PI * (i + 0.5) /
-					      (BLOCK_LEN_SHORT * 2)));
+  int j, size;
+
   gpsyInfo->sampleRate = (double) sampleRate;
 
   for (channel = 0; channel < numChannels; channel++)
   {
     psydata_t *psydata = AllocMemory(sizeof(psydata_t));
+    memset(psydata->engEarly, 0, sizeof(psydata->engEarly));
     psyInfo[channel].data = psydata;
   }
 
-  size = BLOCK_LEN_LONG;
+  size = gpsyInfo->frameLen;
   for (channel = 0; channel < numChannels; channel++)
   {
     psyInfo[channel].size = size;
 
     psyInfo[channel].prevSamples =
-      (double *) AllocMemory(size * sizeof(double));
-    memset(psyInfo[channel].prevSamples, 0, size * sizeof(double));
+      (faac_real *) AllocMemory(size * sizeof(faac_real));
+    memset(psyInfo[channel].prevSamples, 0, size * sizeof(faac_real));
   }
 
-  size = BLOCK_LEN_SHORT;
+  size = gpsyInfo->frameLen / MAX_SHORT_WINDOWS;
   for (channel = 0; channel < numChannels; channel++)
   {
     psydata_t *psydata = psyInfo[channel].data;
@@ -179,6 +171,10 @@ static void PsyInit(GlobalPsyInfo * gpsyInfo, PsyInfo * psyInfo, unsigned int nu
       memset(psydata->engNext2[j], 0, NSFB_SHORT * sizeof(psyfloat));
     }
   }
+
+  gpsyInfo->memory = numChannels * (sizeof(psydata_t)
+                                    + gpsyInfo->frameLen * sizeof(faac_real)
+                                    + 4 * 8 * NSFB_SHORT * sizeof(psyfloat));
 }
 
 static void PsyEnd(GlobalPsyInfo * gpsyInfo, PsyInfo * psyInfo, unsigned int numChannels)
@@ -186,11 +182,6 @@ static void PsyEnd(GlobalPsyInfo * gpsyInfo, PsyInfo * psyInfo, unsigned int num
   unsigned int channel;
   int j;
 
-  if (gpsyInfo->hannWindow)
-    FreeMemory(gpsyInfo->hannWindow);
-  if (gpsyInfo->hannWindowS)
-    FreeMemory(gpsyInfo->hannWindowS);
-
   for (channel = 0; channel < numChannels; channel++)
   {
     if (psyInfo[channel].prevSamples)
@@ -225,6 +216,30 @@ static void PsyEnd(GlobalPsyInfo * gpsyInfo, PsyInfo * psyInfo, unsigned int num
 #endif
 }
 
+/* Forget the signal history, for a new stream */
+static void PsyReset(GlobalPsyInfo * gpsyInfo, PsyInfo * psyInfo, unsigned int numChannels)
+{
+  unsigned int channel;
+  int j;
+
+  for (channel = 0; channel < numChannels; channel++)
+  {
+    psydata_t *psydata = psyInfo[channel].data;
+
+    psyInfo[channel].block_type = ONLY_LONG_WINDOW;
+    memset(psyInfo[channel].prevSamples, 0, psyInfo[channel].size * sizeof(faac_real));
+
+    for (j = 0; j < 8; j++)
+    {
+      memset(psydata->engPrev[j], 0, NSFB_SHORT * sizeof(psyfloat));
+      memset(psydata->eng[j], 0, NSFB_SHORT * sizeof(psyfloat));
+      memset(psydata->engNext[j], 0, NSFB_SHORT * sizeof(psyfloat));
+      memset(psydata->engNext2[j], 0, NSFB_SHORT * sizeof(psyfloat));
+    }
+    memset(psydata->engEarly, 0, sizeof(psydata->engEarly));
+  }
+}
+
 /* Do psychoacoustical analysis */
 static void PsyCalculate(ChannelInfo * channelInfo, GlobalPsyInfo * gpsyInfo,
 			 PsyInfo * psyInfo, int *cb_width_long, int
@@ -251,8 +266,8 @@ static void PsyCalculate(ChannelInfo * channelInfo, GlobalPsyInfo * gpsyInfo,
 	int leftChan = channel;
 	int rightChan = channelInfo[channel].paired_ch;
 
-	PsyCheckShort(&psyInfo[leftChan], quality);
-	PsyCheckShort(&psyInfo[rightChan], quality);
+	PsyCheckShort(&psyInfo[leftChan], quality, gpsyInfo->lowDelay);
+	PsyCheckShort(&psyInfo[rightChan], quality, gpsyInfo->lowDelay);
       }
       else if (!channelInfo[channel].cpe &&
 	       channelInfo[channel].lfe)
@@ -262,115 +277,71 @@ static void PsyCalculate(ChannelInfo * channelInfo, GlobalPsyInfo * gpsyInfo,
       }
       else if (!channelInfo[channel].cpe)
       {				/* SCE */
-	PsyCheckShort(&psyInfo[channel], quality);
+	PsyCheckShort(&psyInfo[channel], quality, gpsyInfo->lowDelay);
       }
     }
   }
 }
 
-// imported from filtbank.c
-static void mdct( FFT_Tables *fft_tables, double *data, int N )
+
+/* energies of the short window bands below the bandwidth, returns the
+   number of bands */
+static int PsyBandEnergy(psyfloat *eng, const faac_real *spec, int bandS,
+                         int *cb_width_short, int num_cb_short)
 {
-    double tempr, tempi, c, s, cold, cfreq, sfreq; /* temps for pre and post twiddle */
-    double freq = 2.0 * M_PI / N;
-    double cosfreq8, sinfreq8;
-    int i, n;
-
-    double xi[BLOCK_LEN_LONG / 2];
-    double xr[BLOCK_LEN_LONG / 2];
-
-    /* prepare for recurrence relation in pre-twiddle */
-    cfreq = cos (freq);
-    sfreq = sin (freq);
-    cosfreq8 = cos (freq * 0.125);
-    sinfreq8 = sin (freq * 0.125);
-    c = cosfreq8;
-    s = sinfreq8;
-
-    for (i = 0; i < (N >> 2); i++) {
-        /* calculate real and imaginary parts of g(n) or G(p) */
-        n = 2 * i;
-
-        if (n < (N >> 2))
-            tempr = data [(N>>2) + (N>>1) - 1 - n] + data [N - (N>>2) + n];
-        else
-            tempr = data [(N>>2) + (N>>1) - 1 - n] - data [-(N>>2) + n];
-
-        if (n < (N >> 2))
-            tempi = data [(N>>2) + n] - data [(N>>2) - 1 - n];
-        else
-            tempi = data [(N>>2) + n] + data [N + (N>>2) - 1 - n];
-
-        /* calculate pre-twiddled FFT input */
-        xr[i] = tempr * c + tempi * s;
-        xi[i] = tempi * c - tempr * s;
-
-        /* use recurrence to prepare cosine and sine for next value of i */
-        cold = c;
-        c = c * cfreq - s * sfreq;
-        s = s * cfreq + cold * sfreq;
-    }
+  int first = 0;
+  int last = 0;
+  int sfb, nbands;
 
-    /* Perform in-place complex FFT of length N/4 */
-    switch (N) {
-    case BLOCK_LEN_SHORT * 2:
-        fft( fft_tables, xr, xi, 6);
+  for (sfb = 0; sfb < num_cb_short; sfb++)
+  {
+    double e;
+    int l;
+
+    first = last;
+    last = first + cb_width_short[sfb];
+
+    if (first < 1)
+        first = 1;
+
+    if (first >= bandS) // band out of range
         break;
-    case BLOCK_LEN_LONG * 2:
-        fft( fft_tables, xr, xi, 9);
-    }
 
-    /* prepare for recurrence relations in post-twiddle */
-    c = cosfreq8;
-    s = sinfreq8;
-
-    /* post-twiddle FFT output and then get output data */
-    for (i = 0; i < (N >> 2); i++) {
-        /* get post-twiddled FFT output  */
-        tempr = 2. * (xr[i] * c + xi[i] * s);
-        tempi = 2. * (xi[i] * c - xr[i] * s);
-
-        /* fill in output values */
-        data [2 * i] = -tempr;   /* first half even */
-        data [(N >> 1) - 1 - 2 * i] = tempi;  /* first half odd */
-        data [(N >> 1) + 2 * i] = -tempi;  /* second half even */
-        data [N - 1 - 2 * i] = tempr;  /* second half odd */
-
-        /* use recurrence to prepare cosine and sine for next value of i */
-        cold = c;
-        c = c * cfreq - s * sfreq;
-        s = s * cfreq + cold * sfreq;
-    }
-}
+    e = 0.0;
+    for (l = first; l < last; l++)
+        e += spec[l] * spec[l];
+
+    eng[sfb] = e;
+  }
+  nbands = sfb;
+  for (; sfb < num_cb_short; sfb++)
+  {
+      eng[sfb] = 0;
+  }
 
+  return nbands;
+}
 
-static void PsyBufferUpdate( FFT_Tables *fft_tables, GlobalPsyInfo * gpsyInfo, PsyInfo * psyInfo,
-			    double *newSamples, unsigned int bandwidth,
+static void PsyBufferUpdate( MDCTInfo *mdctInfo, GlobalPsyInfo * gpsyInfo, PsyInfo * psyInfo,
+			    faac_real *newSamples, unsigned int bandwidth,
 			    int *cb_width_short, int num_cb_short)
 {
   int win;
-  double transBuff[2 * BLOCK_LEN_LONG];
-  double transBuffS[2 * BLOCK_LEN_SHORT];
+  faac_real transBuff[2 * BLOCK_LEN_LONG];
+  faac_real shortSpec[BLOCK_LEN_LONG];
   psydata_t *psydata = psyInfo->data;
   psyfloat *tmp;
-  int sfb;
 
   psydata->bandS = psyInfo->sizeS * bandwidth * 2 / gpsyInfo->sampleRate;
 
-  memcpy(transBuff, psyInfo->prevSamples, psyInfo->size * sizeof(double));
-  memcpy(transBuff + psyInfo->size, newSamples, psyInfo->size * sizeof(double));
+  memcpy(transBuff, psyInfo->prevSamples, psyInfo->size * sizeof(faac_real));
+  memcpy(transBuff + psyInfo->size, newSamples, psyInfo->size * sizeof(faac_real));
+
+  MDCTShort(mdctInfo, shortSpec, transBuff + (psyInfo->size - psyInfo->sizeS) / 2,
+            gpsyInfo->hannWindowS, gpsyInfo->hannWindowS);
 
   for (win = 0; win < 8; win++)
   {
-    int first = 0;
-    int last = 0;
-
-    memcpy(transBuffS, transBuff + (win * BLOCK_LEN_SHORT) + (BLOCK_LEN_LONG - BLOCK_LEN_SHORT) / 2,
-	   2 * psyInfo->sizeS * sizeof(double));
-
-    Hann(gpsyInfo, transBuffS, 2 * psyInfo->sizeS);
-    mdct( fft_tables, transBuffS, 2 * psyInfo->sizeS);
-
     // shift bufs
     tmp = psydata->engPrev[win];
     psydata->engPrev[win] = psydata->eng[win];
@@ -378,34 +349,29 @@ static void PsyBufferUpdate( FFT_Tables *fft_tables, GlobalPsyInfo * gpsyInfo, P
     psydata->engNext[win] = psydata->engNext2[win];
     psydata->engNext2[win] = tmp;
 
-    for (sfb = 0; sfb < num_cb_short; sfb++)
-    {
-      double e;
-      int l;
-
-      first = last;
-      last = first + cb_width_short[sfb];
+    psydata->lastband = PsyBandEnergy(psydata->engNext2[win],
+                                      shortSpec + win * psyInfo->sizeS,
+                                      psydata->bandS, cb_width_short, num_cb_short);
+  }
 
-      if (first < 1)
-          first = 1;
+  /* The first windows of the next frame lie within the new samples, the
+     ones after them are not needed. Same values as the next call gets. */
+  if (gpsyInfo->lowDelay)
+  {
+    faac_real spec[BLOCK_LEN_LONG];
 
-      if (first >= psydata->bandS) // band out of range
-          break;
+    memcpy(transBuff, newSamples, psyInfo->size * sizeof(faac_real));
+    memset(transBuff + psyInfo->size, 0, psyInfo->size * sizeof(faac_real));
 
-      e = 0.0;
-      for (l = first; l < last; l++)
-          e += transBuffS[l] * transBuffS[l];
+    MDCTShort(mdctInfo, spec, transBuff + (psyInfo->size - psyInfo->sizeS) / 2,
+              gpsyInfo->hannWindowS, gpsyInfo->hannWindowS);
 
-      psydata->engNext2[win][sfb] = e;
-    }
-    psydata->lastband = sfb;
-    for (; sfb < num_cb_short; sfb++)
-    {
-        psydata->engNext2[win][sfb] = 0;
-    }
+    for (win = 0; win < NEXTS; win++)
+      PsyBandEnergy(psydata->engEarly[win], spec + win * psyInfo->sizeS,
+                    psydata->bandS, cb_width_short, num_cb_short);
   }
 
-  memcpy(psyInfo->prevSamples, newSamples, psyInfo->size * sizeof(double));
+  memcpy(psyInfo->prevSamples, newSamples, psyInfo->size * sizeof(faac_real));
 }
 
 static void BlockSwitch(CoderInfo * coderInfo, PsyInfo * psyInfo, unsigned int numChannels)
@@ -450,6 +416,7 @@ psymodel_t psymodel2 =
 {
   PsyInit,
   PsyEnd,
+  PsyReset,
   PsyCalculate,
   PsyBufferUpdate,
   BlockSwitch
@@ -32,14 +32,14 @@ extern "C" {
 
 #include "coder.h"
 #include "channels.h"
-#include "fft.h"
+#include "mdct.h"
 
 typedef struct {
 	int size;
 	int sizeS;
 
 	/* Previous input samples */
-	double *prevSamples;
+	faac_real *prevSamples;
 
 	int block_type;
 
@@ -49,9 +49,20 @@ typedef struct {
 typedef struct {
 	double sampleRate;
 
-	/* Hann window */
-	double *hannWindow;
-	double *hannWindowS;
+	/* long block length, an eighth of it for short blocks; set by the
+	   encoder before PsyInit() */
+	int frameLen;
+
+	/* short block Hann window; shared, set by the encoder before
+	   PsyInit() */
+	const faac_real *hannWindowS;
+
+	/* set by the encoder: decide on the newest frame, with one frame
+	   of lookahead instead of three */
+	int lowDelay;
+
+	/* bytes allocated by PsyInit() for all channels */
+	unsigned long memory;
 
         void *data;
 } GlobalPsyInfo;
@@ -64,12 +75,14 @@ void (*PsyInit) (GlobalPsyInfo *gpsyInfo, PsyInfo *psyInfo,
 		int *cb_width_short, int num_cb_short);
 void (*PsyEnd) (GlobalPsyInfo *gpsyInfo, PsyInfo *psyInfo,
 		unsigned int numChannels);
+void (*PsyReset) (GlobalPsyInfo *gpsyInfo, PsyInfo *psyInfo,
+		unsigned int numChannels);
 void (*PsyCalculate) (ChannelInfo *channelInfo, GlobalPsyInfo *gpsyInfo,
 		PsyInfo *psyInfo, int *cb_width_long, int num_cb_long,
 		int *cb_width_short, int num_cb_short,
 		unsigned int numChannels, double quality);
-void (*PsyBufferUpdate) ( FFT_Tables *fft_tables, GlobalPsyInfo * gpsyInfo, PsyInfo * psyInfo,
-		double *newSamples, unsigned int bandwidth,
+void (*PsyBufferUpdate) ( MDCTInfo *mdctInfo, GlobalPsyInfo * gpsyInfo, PsyInfo * psyInfo,
+		faac_real *newSamples, unsigned int bandwidth,
 		int *cb_width_short, int num_cb_short);
 void (*BlockSwitch) (CoderInfo *coderInfo, PsyInfo *psyInfo,
 		unsigned int numChannels);
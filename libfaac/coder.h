@@ -29,25 +29,25 @@ extern "C" {
 /* Allow encoding of Digital Radio Mondiale (DRM) */
 //#define DRM
 
-/* Allow encoding of Digital Radio Mondiale (DRM) with transform length 1024 */
-//#define DRM_1024
-
 #define MAX_CHANNELS 64
 
-#ifdef DRM
-#ifdef DRM_1024
-# define FRAME_LEN 1024
-# define BLOCK_LEN_LONG 1024
-# define BLOCK_LEN_SHORT 128
+/* The longest frame and blocks, buffers are sized for them. The frame
+   length of a stream is chosen at run time: FRAME_LEN or FRAME_LEN_960
+   (frameLengthFlag), with blocks of an eighth of it, or half of either
+   for AAC-LD. */
+#define FRAME_LEN 1024
+#define BLOCK_LEN_LONG 1024
+#define BLOCK_LEN_SHORT 128
+#define FRAME_LEN_960 960
+/* AAC-LD, long blocks only */
+#define LD_FRAME_LEN 512
+#define LD_FRAME_LEN_480 480
+
+/* Sample type of the signal path: time signal, windows and spectra */
+#ifdef FAAC_PRECISION_SINGLE
+typedef float faac_real;
 #else
-# define FRAME_LEN 960
-# define BLOCK_LEN_LONG 960
-# define BLOCK_LEN_SHORT 120
-#endif /* DRM_1024 */
-#else
-# define FRAME_LEN 1024
-# define BLOCK_LEN_LONG 1024
-# define BLOCK_LEN_SHORT 128
+typedef double faac_real;
 #endif
 
 #define NSFB_LONG  51
@@ -70,8 +70,6 @@ enum WINDOW_TYPE {
 #define LEN_TNS_NFILTL 2
 #define LEN_TNS_NFILTS 1
 
-#define LPC 2
-
 typedef struct {
     int order;                           /* Filter order */
     int direction;                       /* Filtering direction */
@@ -99,18 +97,6 @@ typedef struct {
     TnsWindowData windowData[MAX_SHORT_WINDOWS]; /* TNS data per window */
 } TnsInfo;
 
-typedef struct
-{
-    int psy_init_mc;
-    double dr_mc[LPC][BLOCK_LEN_LONG],e_mc[LPC+1+1][BLOCK_LEN_LONG];
-    double K_mc[LPC+1][BLOCK_LEN_LONG], R_mc[LPC+1][BLOCK_LEN_LONG];
-    double VAR_mc[LPC+1][BLOCK_LEN_LONG], KOR_mc[LPC+1][BLOCK_LEN_LONG];
-    double sb_samples_pred_mc[BLOCK_LEN_LONG];
-    int thisLineNeedsResetting_mc[BLOCK_LEN_LONG];
-    int reset_count_mc;
-} BwpInfo;
-
-
 typedef struct {
     int window_shape;
     int prev_window_shape;
@@ -145,10 +131,17 @@ typedef struct {
 
     int iLenLongestCW;
     int iLenReordSpData;
+
+    /* virtual codebook chosen for the band being coded */
+    int vcb11;
+
+    /* books and scalefactors set by AACstereo(), restored for every
+       quantizer pass of the frame */
+    int stereo_sf[MAX_SCFAC_BANDS];
+    int stereo_book[MAX_SCFAC_BANDS];
 #endif
 
     TnsInfo tnsInfo;
-    BwpInfo bwpInfo;
 } CoderInfo;
 
 typedef struct {
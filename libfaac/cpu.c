@@ -0,0 +1,581 @@
+/****************************************************************************
+    Runtime CPU feature detection and kernel dispatch
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+****************************************************************************/
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <math.h>
+#include <string.h>
+#include "cpu.h"
+#include "quantize.h"
+
+/* The kernels must agree bit for bit, so multiplies and adds must not be
+   fused into FMA instructions that only some of the variants can use. */
+#if defined(__clang__)
+# pragma STDC FP_CONTRACT OFF
+#elif defined(__GNUC__)
+# pragma GCC optimize ("fp-contract=off")
+#endif
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__)) \
+    && defined(HAVE_IMMINTRIN_H) && (__GNUC__ >= 5 || defined(__clang__))
+# include <immintrin.h>
+# define CPU_X86
+# define TARGET(isa) __attribute__((target(isa)))
+#elif defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+# include <immintrin.h>
+# include <intrin.h>
+# define CPU_X86
+# define TARGET(isa)
+#endif
+
+/* In single precision like the SIMD variants, the same operations in the
+   same order */
+static void quantize_scalar(const faac_real *xr, int *xi, int n, double sfacfix)
+{
+    const float sfac = sfacfix;
+    const float magic = MAGIC_NUMBER;
+    int cnt;
+
+    for (cnt = 0; cnt < n; cnt++)
+    {
+        float tmp = fabsf((float)xr[cnt]);
+
+        tmp *= sfac;
+        tmp = sqrtf(tmp * sqrtf(tmp));
+
+        xi[cnt] = (int)(tmp + magic);
+        if (xr[cnt] < 0)
+            xi[cnt] = -xi[cnt];
+    }
+}
+
+static void window_scalar(faac_real *x, const faac_real *w, int n)
+{
+    int i;
+
+    for (i = 0; i < n; i++)
+        x[i] *= w[i];
+}
+
+static void window_rev_scalar(faac_real *x, const faac_real *w, int n)
+{
+    int i;
+
+    for (i = 0; i < n; i++)
+        x[i] *= w[n - 1 - i];
+}
+
+static void cmul_scalar(faac_real *x, const faac_real *wr, const faac_real *wi, int n)
+{
+    int k;
+
+    for (k = 0; k < 2 * n; k += 2)
+    {
+        faac_real re = x[k], im = x[k + 1];
+
+        x[k] = re * wr[k] + im * wi[k];
+        x[k + 1] = im * wr[k + 1] + re * wi[k + 1];
+    }
+}
+
+/* Radix-4 butterfly on the values x[0], x[d], x[2d], x[3d], whose imaginary
+   parts are im further on. x[d], x[2d] and x[3d] are rotated by W^2, W and
+   W^3, whose split tables start at w, w + 2e and w + 4e. */
+static void radix4_one(faac_real *x, int im, int d, const faac_real *w, int e)
+{
+    faac_real *x1 = x + d, *x2 = x + 2 * d, *x3 = x + 3 * d;
+    faac_real b1r = x1[0] * w[0] + x1[im] * w[e];
+    faac_real b1i = x1[im] * w[1] + x1[0] * w[e + 1];
+    faac_real b2r = x2[0] * w[2 * e] + x2[im] * w[3 * e];
+    faac_real b2i = x2[im] * w[2 * e + 1] + x2[0] * w[3 * e + 1];
+    faac_real b3r = x3[0] * w[4 * e] + x3[im] * w[5 * e];
+    faac_real b3i = x3[im] * w[4 * e + 1] + x3[0] * w[5 * e + 1];
+    faac_real t0r = x[0] + b1r, t0i = x[im] + b1i;
+    faac_real t1r = x[0] - b1r, t1i = x[im] - b1i;
+    faac_real t2r = b2r + b3r, t2i = b2i + b3i;
+    faac_real t3r = b2r - b3r, t3i = b2i - b3i;
+
+    x[0] = t0r + t2r;
+    x[im] = t0i + t2i;
+    x2[0] = t0r - t2r;
+    x2[im] = t0i - t2i;
+    /* t1 -/+ i * t3 */
+    x1[0] = t1r + t3i;
+    x1[im] = t1i - t3r;
+    x3[0] = t1r - t3i;
+    x3[im] = t1i + t3r;
+}
+
+static void radix4_scalar(faac_real *x, const faac_real *w, int s, int n)
+{
+    int d = 2 * s;
+    int g, k;
+
+    for (g = 0; g < 2 * n; g += 4 * d)
+        for (k = 0; k < d; k += 2)
+            radix4_one(x + g + k, 1, d, w + k, d);
+}
+
+static void cmul8_scalar(faac_real *x, const faac_real *wr, const faac_real *wi, int n)
+{
+    int k, l;
+
+    for (k = 0; k < n; k++, x += 16)
+    {
+        for (l = 0; l < 8; l++)
+        {
+            faac_real re = x[l], im = x[8 + l];
+
+            x[l] = re * wr[2 * k] + im * wi[2 * k];
+            x[8 + l] = im * wr[2 * k + 1] + re * wi[2 * k + 1];
+        }
+    }
+}
+
+static void radix4_8_scalar(faac_real *x, const faac_real *w, int s, int n)
+{
+    int d = 16 * s;
+    int g, k, l;
+
+    for (g = 0; g < 16 * n; g += 4 * d)
+        for (k = 0; k < s; k++)
+            for (l = 0; l < 8; l++)
+                radix4_one(x + g + 16 * k + l, 8, d, w + 2 * k, 2 * s);
+}
+
+#ifdef CPU_X86
+
+/* Every lane of the SIMD quantizers does the same single precision
+   operations as quantize_scalar(), so all variants agree bit by bit. */
+
+static void quantize_sign(const faac_real *xr, int *xi, int n)
+{
+    int cnt;
+
+    for (cnt = 0; cnt < n; cnt++)
+    {
+        if (xr[cnt] < 0)
+            xi[cnt] = -xi[cnt];
+    }
+}
+
+TARGET("sse2")
+static __m128 load4(const faac_real *xr)
+{
+#ifdef FAAC_PRECISION_SINGLE
+    return _mm_loadu_ps(xr);
+#else
+    return _mm_movelh_ps(_mm_cvtpd_ps(_mm_loadu_pd(xr)),
+                         _mm_cvtpd_ps(_mm_loadu_pd(xr + 2)));
+#endif
+}
+
+TARGET("sse2")
+static __m128i quant4(__m128 x, __m128 sfac)
+{
+    x = _mm_max_ps(x, _mm_sub_ps(_mm_setzero_ps(), x));
+    x = _mm_mul_ps(x, sfac);
+    x = _mm_mul_ps(x, _mm_sqrt_ps(x));
+    x = _mm_sqrt_ps(x);
+    x = _mm_add_ps(x, _mm_set1_ps(MAGIC_NUMBER));
+
+    return _mm_cvttps_epi32(x);
+}
+
+/* quantize lines from cnt up to n, four at a time, padding the last group */
+TARGET("sse2")
+static void quantize_rest4(const faac_real *xr, int *xi, int cnt, int n, __m128 sfac)
+{
+    for (; cnt + 4 <= n; cnt += 4)
+        _mm_storeu_si128((__m128i *)(xi + cnt), quant4(load4(xr + cnt), sfac));
+
+    if (cnt < n)
+    {
+        faac_real xtmp[4] = {0, 0, 0, 0};
+        int itmp[4];
+
+        memcpy(xtmp, xr + cnt, (n - cnt) * sizeof(xtmp[0]));
+        _mm_storeu_si128((__m128i *)itmp, quant4(load4(xtmp), sfac));
+        memcpy(xi + cnt, itmp, (n - cnt) * sizeof(itmp[0]));
+    }
+}
+
+TARGET("sse2")
+static void quantize_sse2(const faac_real *xr, int *xi, int n, double sfacfix)
+{
+    quantize_rest4(xr, xi, 0, n, _mm_set1_ps(sfacfix));
+    quantize_sign(xr, xi, n);
+}
+
+TARGET("avx2")
+static void quantize_avx2(const faac_real *xr, int *xi, int n, double sfacfix)
+{
+    const __m256 sfac = _mm256_set1_ps(sfacfix);
+    int cnt;
+
+    for (cnt = 0; cnt + 8 <= n; cnt += 8)
+    {
+#ifdef FAAC_PRECISION_SINGLE
+        __m256 x = _mm256_loadu_ps(xr + cnt);
+#else
+        __m256 x = _mm256_insertf128_ps(
+            _mm256_castps128_ps256(_mm256_cvtpd_ps(_mm256_loadu_pd(xr + cnt))),
+            _mm256_cvtpd_ps(_mm256_loadu_pd(xr + cnt + 4)), 1);
+#endif
+
+        x = _mm256_max_ps(x, _mm256_sub_ps(_mm256_setzero_ps(), x));
+        x = _mm256_mul_ps(x, sfac);
+        x = _mm256_mul_ps(x, _mm256_sqrt_ps(x));
+        x = _mm256_sqrt_ps(x);
+        x = _mm256_add_ps(x, _mm256_set1_ps(MAGIC_NUMBER));
+
+        _mm256_storeu_si256((__m256i *)(xi + cnt), _mm256_cvttps_epi32(x));
+    }
+    quantize_rest4(xr, xi, cnt, n, _mm_set1_ps(sfacfix));
+    quantize_sign(xr, xi, n);
+}
+
+TARGET("avx512f")
+static void quantize_avx512(const faac_real *xr, int *xi, int n, double sfacfix)
+{
+    const __m512 sfac = _mm512_set1_ps(sfacfix);
+    int cnt;
+
+    for (cnt = 0; cnt + 16 <= n; cnt += 16)
+    {
+#ifdef FAAC_PRECISION_SINGLE
+        __m512 x = _mm512_loadu_ps(xr + cnt);
+#else
+        __m512 x = _mm512_castpd_ps(_mm512_insertf64x4(
+            _mm512_castpd256_pd512(_mm256_castps_pd(_mm512_cvtpd_ps(_mm512_loadu_pd(xr + cnt)))),
+            _mm256_castps_pd(_mm512_cvtpd_ps(_mm512_loadu_pd(xr + cnt + 8))), 1));
+#endif
+
+        x = _mm512_max_ps(x, _mm512_sub_ps(_mm512_setzero_ps(), x));
+        x = _mm512_mul_ps(x, sfac);
+        x = _mm512_mul_ps(x, _mm512_sqrt_ps(x));
+        x = _mm512_sqrt_ps(x);
+        x = _mm512_add_ps(x, _mm512_set1_ps(MAGIC_NUMBER));
+
+        _mm512_storeu_si512((void *)(xi + cnt), _mm512_cvttps_epi32(x));
+    }
+    quantize_rest4(xr, xi, cnt, n, _mm_set1_ps(sfacfix));
+    quantize_sign(xr, xi, n);
+}
+
+/* The windowing and FFT kernels do the same operations in the same order as
+   the scalar code, just several elements at a time, so every width gives the
+   same result. Complex values are interleaved: swap exchanges re and im. */
+
+static const faac_real plus_minus[16] = {1, -1, 1, -1, 1, -1, 1, -1,
+                                         1, -1, 1, -1, 1, -1, 1, -1};
+
+#ifdef FAAC_PRECISION_SINGLE
+# define V4 4
+# define V8 8
+# define V16 16
+# define v4_t __m128
+# define v4_load _mm_loadu_ps
+# define v4_set1 _mm_set1_ps
+# define v4_store _mm_storeu_ps
+# define v4_mul _mm_mul_ps
+# define v4_add _mm_add_ps
+# define v4_sub _mm_sub_ps
+# define v4_rev(v) _mm_shuffle_ps(v, v, _MM_SHUFFLE(0, 1, 2, 3))
+# define v4_swap(v) _mm_shuffle_ps(v, v, _MM_SHUFFLE(2, 3, 0, 1))
+# define v8_t __m256
+# define v8_load _mm256_loadu_ps
+# define v8_set1 _mm256_set1_ps
+# define v8_store _mm256_storeu_ps
+# define v8_mul _mm256_mul_ps
+# define v8_add _mm256_add_ps
+# define v8_sub _mm256_sub_ps
+# define v8_rev(v) _mm256_permutevar8x32_ps(v, _mm256_setr_epi32(7, 6, 5, 4, 3, 2, 1, 0))
+# define v8_swap(v) _mm256_permute_ps(v, 0xb1)
+# define v16_t __m512
+# define v16_load _mm512_loadu_ps
+# define v16_set1 _mm512_set1_ps
+# define v16_store _mm512_storeu_ps
+# define v16_mul _mm512_mul_ps
+# define v16_add _mm512_add_ps
+# define v16_sub _mm512_sub_ps
+# define v16_rev(v) _mm512_permutexvar_ps(_mm512_setr_epi32(15, 14, 13, 12, 11, 10, 9, 8, \
+                                                             7, 6, 5, 4, 3, 2, 1, 0), v)
+# define v16_swap(v) _mm512_permute_ps(v, 0xb1)
+#else
+# define V4 2
+# define V8 4
+# define V16 8
+# define v4_t __m128d
+# define v4_load _mm_loadu_pd
+# define v4_set1 _mm_set1_pd
+# define v4_store _mm_storeu_pd
+# define v4_mul _mm_mul_pd
+# define v4_add _mm_add_pd
+# define v4_sub _mm_sub_pd
+# define v4_rev(v) _mm_shuffle_pd(v, v, 1)
+# define v4_swap(v) _mm_shuffle_pd(v, v, 1)
+# define v8_t __m256d
+# define v8_load _mm256_loadu_pd
+# define v8_set1 _mm256_set1_pd
+# define v8_store _mm256_storeu_pd
+# define v8_mul _mm256_mul_pd
+# define v8_add _mm256_add_pd
+# define v8_sub _mm256_sub_pd
+# define v8_rev(v) _mm256_permute4x64_pd(v, _MM_SHUFFLE(0, 1, 2, 3))
+# define v8_swap(v) _mm256_permute_pd(v, 5)
+# define v16_t __m512d
+# define v16_load _mm512_loadu_pd
+# define v16_set1 _mm512_set1_pd
+# define v16_store _mm512_storeu_pd
+# define v16_mul _mm512_mul_pd
+# define v16_add _mm512_add_pd
+# define v16_sub _mm512_sub_pd
+# define v16_rev(v) _mm512_permutexvar_pd(_mm512_setr_epi64(7, 6, 5, 4, 3, 2, 1, 0), v)
+# define v16_swap(v) _mm512_permute_pd(v, 0x55)
+#endif
+
+#define VECTOR_KERNELS(isa, name, vt, vl, load, store, mul, add, sub, rev, swap) \
+TARGET(isa) \
+static void window_##name(faac_real *x, const faac_real *w, int n) \
+{ \
+    int i; \
+    for (i = 0; i + vl <= n; i += vl) \
+        store(x + i, mul(load(x + i), load(w + i))); \
+    for (; i < n; i++) \
+        x[i] *= w[i]; \
+} \
+TARGET(isa) \
+static void window_rev_##name(faac_real *x, const faac_real *w, int n) \
+{ \
+    int i; \
+    for (i = 0; i + vl <= n; i += vl) \
+        store(x + i, mul(load(x + i), rev(load(w + n - vl - i)))); \
+    for (; i < n; i++) \
+        x[i] *= w[n - 1 - i]; \
+} \
+TARGET(isa) \
+static void cmul_##name(faac_real *x, const faac_real *wr, const faac_real *wi, int n) \
+{ \
+    int k; \
+    for (k = 0; k + vl <= 2 * n; k += vl) \
+    { \
+        vt a = load(x + k); \
+        store(x + k, add(mul(a, load(wr + k)), mul(swap(a), load(wi + k)))); \
+    } \
+    cmul_scalar(x + k, wr + k, wi + k, n - k / 2); \
+} \
+TARGET(isa) \
+static void radix4_##name(faac_real *x, const faac_real *w, int s, int n) \
+{ \
+    vt pm; \
+    int d = 2 * s; \
+    int g, k; \
+    if (d % vl) \
+    { \
+        radix4_scalar(x, w, s, n); \
+        return; \
+    } \
+    pm = load(plus_minus); \
+    for (g = 0; g < 2 * n; g += 4 * d) \
+        for (k = 0; k < d; k += vl) \
+        { \
+            faac_real *p = x + g + k; \
+            const faac_real *q = w + k; \
+            vt x0 = load(p), x1 = load(p + d), x2 = load(p + 2 * d), x3 = load(p + 3 * d); \
+            vt b1 = add(mul(x1, load(q)), mul(swap(x1), load(q + d))); \
+            vt b2 = add(mul(x2, load(q + 2 * d)), mul(swap(x2), load(q + 3 * d))); \
+            vt b3 = add(mul(x3, load(q + 4 * d)), mul(swap(x3), load(q + 5 * d))); \
+            vt t0 = add(x0, b1), t1 = sub(x0, b1); \
+            vt t2 = add(b2, b3), t3 = mul(swap(sub(b2, b3)), pm); \
+            store(p, add(t0, t2)); \
+            store(p + d, add(t1, t3)); \
+            store(p + 2 * d, sub(t0, t2)); \
+            store(p + 3 * d, sub(t1, t3)); \
+        } \
+}
+
+/* Eight transforms side by side, vl of them per vector. The twiddles are
+   the same for all of them and get broadcast. */
+#define SOA_KERNELS(isa, name, vt, vl, load, store, mul, add, sub, set1) \
+TARGET(isa) \
+static void cmul8_##name(faac_real *x, const faac_real *wr, const faac_real *wi, int n) \
+{ \
+    int k, l; \
+    for (k = 0; k < n; k++, x += 16) \
+    { \
+        vt r0 = set1(wr[2 * k]), r1 = set1(wr[2 * k + 1]); \
+        vt i0 = set1(wi[2 * k]), i1 = set1(wi[2 * k + 1]); \
+        for (l = 0; l < 8; l += vl) \
+        { \
+            vt re = load(x + l), im = load(x + 8 + l); \
+            store(x + l, add(mul(re, r0), mul(im, i0))); \
+            store(x + 8 + l, add(mul(im, r1), mul(re, i1))); \
+        } \
+    } \
+} \
+TARGET(isa) \
+static void radix4_8_##name(faac_real *x, const faac_real *w, int s, int n) \
+{ \
+    int d = 16 * s, e = 2 * s; \
+    int g, k, l; \
+    for (g = 0; g < 16 * n; g += 4 * d) \
+        for (k = 0; k < s; k++) \
+        { \
+            faac_real *p = x + g + 16 * k; \
+            const faac_real *q = w + 2 * k; \
+            vt w1r0 = set1(q[0]), w1r1 = set1(q[1]), w1i0 = set1(q[e]), w1i1 = set1(q[e + 1]); \
+            vt w2r0 = set1(q[2 * e]), w2r1 = set1(q[2 * e + 1]); \
+            vt w2i0 = set1(q[3 * e]), w2i1 = set1(q[3 * e + 1]); \
+            vt w3r0 = set1(q[4 * e]), w3r1 = set1(q[4 * e + 1]); \
+            vt w3i0 = set1(q[5 * e]), w3i1 = set1(q[5 * e + 1]); \
+            for (l = 0; l < 8; l += vl, p += vl) \
+            { \
+                vt x0r = load(p), x0i = load(p + 8); \
+                vt x1r = load(p + d), x1i = load(p + d + 8); \
+                vt x2r = load(p + 2 * d), x2i = load(p + 2 * d + 8); \
+                vt x3r = load(p + 3 * d), x3i = load(p + 3 * d + 8); \
+                vt b1r = add(mul(x1r, w1r0), mul(x1i, w1i0)); \
+                vt b1i = add(mul(x1i, w1r1), mul(x1r, w1i1)); \
+                vt b2r = add(mul(x2r, w2r0), mul(x2i, w2i0)); \
+                vt b2i = add(mul(x2i, w2r1), mul(x2r, w2i1)); \
+                vt b3r = add(mul(x3r, w3r0), mul(x3i, w3i0)); \
+                vt b3i = add(mul(x3i, w3r1), mul(x3r, w3i1)); \
+                vt t0r = add(x0r, b1r), t0i = add(x0i, b1i); \
+                vt t1r = sub(x0r, b1r), t1i = sub(x0i, b1i); \
+                vt t2r = add(b2r, b3r), t2i = add(b2i, b3i); \
+                vt t3r = sub(b2r, b3r), t3i = sub(b2i, b3i); \
+                store(p, add(t0r, t2r)); \
+                store(p + 8, add(t0i, t2i)); \
+                store(p + d, add(t1r, t3i)); \
+                store(p + d + 8, sub(t1i, t3r)); \
+                store(p + 2 * d, sub(t0r, t2r)); \
+                store(p + 2 * d + 8, sub(t0i, t2i)); \
+                store(p + 3 * d, sub(t1r, t3i)); \
+                store(p + 3 * d + 8, add(t1i, t3r)); \
+            } \
+        } \
+}
+
+VECTOR_KERNELS("sse2", sse2, v4_t, V4, v4_load, v4_store, v4_mul, v4_add, v4_sub, v4_rev, v4_swap)
+VECTOR_KERNELS("avx2", avx2, v8_t, V8, v8_load, v8_store, v8_mul, v8_add, v8_sub, v8_rev, v8_swap)
+VECTOR_KERNELS("avx512f", avx512, v16_t, V16, v16_load, v16_store, v16_mul, v16_add, v16_sub, v16_rev, v16_swap)
+
+SOA_KERNELS("sse2", sse2, v4_t, V4, v4_load, v4_store, v4_mul, v4_add, v4_sub, v4_set1)
+SOA_KERNELS("avx2", avx2, v8_t, V8, v8_load, v8_store, v8_mul, v8_add, v8_sub, v8_set1)
+#ifndef FAAC_PRECISION_SINGLE
+SOA_KERNELS("avx512f", avx512, v16_t, V16, v16_load, v16_store, v16_mul, v16_add, v16_sub, v16_set1)
+#else
+/* sixteen floats are wider than the eight transforms */
+# define cmul8_avx512 cmul8_avx2
+# define radix4_8_avx512 radix4_8_avx2
+#endif
+
+static int cpu_level(void)
+{
+#ifdef _MSC_VER
+    int info[4];
+    unsigned long long xcr0 = 0;
+    int level = CPU_SCALAR;
+
+    __cpuid(info, 1);
+    if (!(info[3] & (1 << 26)))
+        return level;
+    level = CPU_SSE2;
+    /* OSXSAVE and AVX: the OS saves the wide registers */
+    if ((info[2] & (1 << 27)) && (info[2] & (1 << 28)))
+        xcr0 = _xgetbv(0);
+    __cpuidex(info, 7, 0);
+    if (((xcr0 & 0x06) == 0x06) && (info[1] & (1 << 5)))
+        level = CPU_AVX2;
+    if (((xcr0 & 0xe6) == 0xe6) && (info[1] & (1 << 16)))
+        level = CPU_AVX512;
+
+    return level;
+#else
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx512f"))
+        return CPU_AVX512;
+    if (__builtin_cpu_supports("avx2"))
+        return CPU_AVX2;
+    if (__builtin_cpu_supports("sse2"))
+        return CPU_SSE2;
+    return CPU_SCALAR;
+#endif
+}
+
+#else /* !CPU_X86 */
+
+static int cpu_level(void)
+{
+    return CPU_SCALAR;
+}
+
+#endif /* CPU_X86 */
+
+void CPUKernelsInit(CPUKernels *kernels)
+{
+    CPUKernelsSelect(kernels, cpu_level());
+}
+
+void CPUKernelsSelect(CPUKernels *kernels, int level)
+{
+    kernels->level = level;
+
+    kernels->quantize = quantize_scalar;
+    kernels->window = window_scalar;
+    kernels->window_rev = window_rev_scalar;
+    kernels->cmul = cmul_scalar;
+    kernels->radix4 = radix4_scalar;
+    kernels->cmul8 = cmul8_scalar;
+    kernels->radix4_8 = radix4_8_scalar;
+
+#ifdef CPU_X86
+    switch (kernels->level)
+    {
+    case CPU_AVX512:
+        kernels->quantize = quantize_avx512;
+        kernels->window = window_avx512;
+        kernels->window_rev = window_rev_avx512;
+        kernels->cmul = cmul_avx512;
+        kernels->radix4 = radix4_avx512;
+        kernels->cmul8 = cmul8_avx512;
+        kernels->radix4_8 = radix4_8_avx512;
+        break;
+    case CPU_AVX2:
+        kernels->quantize = quantize_avx2;
+        kernels->window = window_avx2;
+        kernels->window_rev = window_rev_avx2;
+        kernels->cmul = cmul_avx2;
+        kernels->radix4 = radix4_avx2;
+        kernels->cmul8 = cmul8_avx2;
+        kernels->radix4_8 = radix4_8_avx2;
+        break;
+    case CPU_SSE2:
+        kernels->quantize = quantize_sse2;
+        kernels->window = window_sse2;
+        kernels->window_rev = window_rev_sse2;
+        kernels->cmul = cmul_sse2;
+        kernels->radix4 = radix4_sse2;
+        kernels->cmul8 = cmul8_sse2;
+        kernels->radix4_8 = radix4_8_sse2;
+        break;
+    }
+#endif
+}
@@ -0,0 +1,59 @@
+/****************************************************************************
+    Runtime CPU feature detection and kernel dispatch
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+****************************************************************************/
+
+#ifndef CPU_H
+#define CPU_H
+
+#include "coder.h"
+
+enum {
+    CPU_SCALAR,
+    CPU_SSE2,
+    CPU_AVX2,
+    CPU_AVX512
+};
+
+/* All variants of a kernel give bit identical results, so the encoded
+   stream does not depend on the CPU it was produced on. */
+typedef struct
+{
+    int level;
+
+    /* xi[i] = sign(xr[i]) * (int)((|xr[i]| * sfacfix)^0.75 + MAGIC_NUMBER),
+       in single precision */
+    void (*quantize)(const faac_real *xr, int *xi, int n, double sfacfix);
+    /* x[i] *= w[i] */
+    void (*window)(faac_real *x, const faac_real *w, int n);
+    /* x[i] *= w[n - 1 - i] */
+    void (*window_rev)(faac_real *x, const faac_real *w, int n);
+    /* x[k] *= w[k] for n interleaved complex values, with w stored as
+       wr[2k] = wr[2k+1] = Re(w[k]) and wi[2k] = -wi[2k+1] = -Im(w[k]) */
+    void (*cmul)(faac_real *x, const faac_real *wr, const faac_real *wi, int n);
+    /* one radix-4 FFT pass with span s over n interleaved complex values,
+       twiddle layout as built by fft_initialize() */
+    void (*radix4)(faac_real *x, const faac_real *w, int s, int n);
+    /* the same two for eight transforms at once, each complex value held
+       as eight real parts followed by eight imaginary parts */
+    void (*cmul8)(faac_real *x, const faac_real *wr, const faac_real *wi, int n);
+    void (*radix4_8)(faac_real *x, const faac_real *w, int s, int n);
+} CPUKernels;
+
+void CPUKernelsInit(CPUKernels *kernels);
+/* the kernels of a level up to the one of the CPU, for the tests */
+void CPUKernelsSelect(CPUKernels *kernels, int level);
+
+#endif
@@ -25,261 +25,96 @@
 
 #include "fft.h"
 #include "util.h"
-
-#define MAXLOGM 9
-#define MAXLOGR 8
-
-#if defined DRM && !defined DRM_1024
-
 #include "kiss_fft/kiss_fft.h"
-#include "kiss_fft/kiss_fftr.h"
 
-static const int logm_to_nfft[] = 
-{
-/*  0       1       2       3       */
-    0,      0,      0,      0,
-/*  4       5       6       7       */
-    0,      0,      60,     0,
-/*  8       9                       */
-    240,    480
-};
-
-void fft_initialize( FFT_Tables *fft_tables )
-{
-    memset( fft_tables->cfg, 0, sizeof( fft_tables->cfg ) );
-}
-void fft_terminate( FFT_Tables *fft_tables )
-{
-    unsigned int i;
-    for ( i = 0; i < sizeof( fft_tables->cfg ) / sizeof( fft_tables->cfg[0] ); i++ )
-    {
-        if ( fft_tables->cfg[i][0] )
-        {
-            free( fft_tables->cfg[i][0] );
-            fft_tables->cfg[i][0] = NULL;
-        }
-        if ( fft_tables->cfg[i][1] )
-        {
-            free( fft_tables->cfg[i][1] );
-            fft_tables->cfg[i][1] = NULL;
-        }
-    }
-}
+#define MAXLOGR 8
 
-void rfft( FFT_Tables *fft_tables, double *x, int logm )
+/* kiss_fft of the sizes 15 * 2^(logm - 4), interleaved complex data */
+static void kiss_initialize( FFT_Tables *fft_tables )
 {
-/* sur: use real-only optimized FFT */
-
-    int nfft = 0;
-
-    kiss_fft_scalar fin[1 << MAXLOGR];
-    kiss_fft_cpx    fout[1 << MAXLOGR];
+	int logm;
 
-    if ( logm > MAXLOGR )
+	/* build all configurations up front, so the transforms never allocate */
+	for (logm = 4; logm <= MAXLOGM; logm++)
 	{
-		fprintf(stderr, "fft size too big\n");
-		exit(1);
-	}
+		int nfft = 15 << (logm - 4);
 
-    nfft = logm_to_nfft[logm];
-
-    if ( fft_tables->cfg[logm][0] == NULL )
-    {
-        if ( nfft )
-        {
-            fft_tables->cfg[logm][0] = kiss_fftr_alloc( nfft, 0, NULL, NULL );
-        }
-        else
-        {
-	    	fprintf(stderr, "bad logm = %d\n", logm);
-            exit( 1 );
-        }
-    }
-
-    if ( fft_tables->cfg[logm][0] )
-    {
-        unsigned int i;
-        
-        for ( i = 0; i < nfft; i++ )
-        {
-            fin[i] = x[i];    
-        }
-        
-        kiss_fftr( (kiss_fftr_cfg)fft_tables->cfg[logm][0], fin, fout );
-
-        for ( i = 0; i < nfft / 2; i++ )
-        {
-            x[i]            = fout[i].r;
-            x[i + nfft / 2] = fout[i].i;
-        }
-    }
-    else
-    {
-        fprintf( stderr, "bad config for logm = %d\n", logm);
-        exit( 1 );
-    }
+		fft_tables->nfft[logm] = nfft;
+		fft_tables->cfg[logm][0] = kiss_fft_alloc(nfft, 0, NULL, NULL);
+		fft_tables->cfg[logm][1] = kiss_fft_alloc(nfft, 1, NULL, NULL);
+	}
 }
 
-void fft( FFT_Tables *fft_tables, double *xr, double *xi, int logm )
+static void kiss_cfft( FFT_Tables *fft_tables, faac_real *out, const faac_real *in,
+		int logm, int inverse )
 {
-    int nfft = 0;
-
-    kiss_fft_cpx    fin[1 << MAXLOGM];
-    kiss_fft_cpx    fout[1 << MAXLOGM];
+	kiss_fft_cpx fin[1 << MAXLOGM];
+	kiss_fft_cpx fout[1 << MAXLOGM];
+	int nfft = fft_tables->nfft[logm];
+	int i;
 
-    if ( logm > MAXLOGM )
+	if (!fft_tables->cfg[logm][inverse] || (nfft < 1))
 	{
-		fprintf(stderr, "fft size too big\n");
+		fprintf(stderr, "bad config for logm = %d\n", logm);
 		exit(1);
 	}
 
-    nfft = logm_to_nfft[logm];
-
-    if ( fft_tables->cfg[logm][0] == NULL )
-    {
-        if ( nfft )
-        {
-            fft_tables->cfg[logm][0] = kiss_fft_alloc( nfft, 0, NULL, NULL );
-        }
-        else
-        {
-	    	fprintf(stderr, "bad logm = %d\n", logm);
-            exit( 1 );
-        }
-    }
-
-    if ( fft_tables->cfg[logm][0] )
-    {
-        unsigned int i;
-        
-        for ( i = 0; i < nfft; i++ )
-        {
-            fin[i].r = xr[i];    
-            fin[i].i = xi[i];
-        }
-        
-        kiss_fft( (kiss_fft_cfg)fft_tables->cfg[logm][0], fin, fout );
-
-        for ( i = 0; i < nfft; i++ )
-        {
-            xr[i]   = fout[i].r;
-            xi[i]   = fout[i].i;
-        }
-    }
-    else
-    {
-        fprintf( stderr, "bad config for logm = %d\n", logm);
-        exit( 1 );
-    }
-}
-
-void ffti( FFT_Tables *fft_tables, double *xr, double *xi, int logm )
-{
-    int nfft = 0;
+	for (i = 0; i < nfft; i++)
+	{
+		fin[i].r = in[2 * i];
+		fin[i].i = in[2 * i + 1];
+	}
 
-    kiss_fft_cpx    fin[1 << MAXLOGM];
-    kiss_fft_cpx    fout[1 << MAXLOGM];
+	kiss_fft((kiss_fft_cfg)fft_tables->cfg[logm][inverse], fin, fout);
 
-    if ( logm > MAXLOGM )
+	for (i = 0; i < nfft; i++)
 	{
-		fprintf(stderr, "fft size too big\n");
-		exit(1);
+		out[2 * i]     = fout[i].r;
+		out[2 * i + 1] = fout[i].i;
 	}
-
-    nfft = logm_to_nfft[logm];
-
-    if ( fft_tables->cfg[logm][1] == NULL )
-    {
-        if ( nfft )
-        {
-            fft_tables->cfg[logm][1] = kiss_fft_alloc( nfft, 1, NULL, NULL );
-        }
-        else
-        {
-	    	fprintf(stderr, "bad logm = %d\n", logm);
-            exit( 1 );
-        }
-    }
-    
-    if ( fft_tables->cfg[logm][1] )
-    {
-        unsigned int i;
-        double fac = 1.0 / (double)nfft;
-        
-        for ( i = 0; i < nfft; i++ )
-        {
-            fin[i].r = xr[i];    
-            fin[i].i = xi[i];
-        }
-        
-        kiss_fft( (kiss_fft_cfg)fft_tables->cfg[logm][1], fin, fout );
-
-        for ( i = 0; i < nfft; i++ )
-        {
-            xr[i]   = fout[i].r * fac;
-            xi[i]   = fout[i].i * fac;
-        }
-    }
-    else
-    {
-        fprintf( stderr, "bad config for logm = %d\n", logm);
-        exit( 1 );
-    }
 }
 
-#else /* !defined DRM || defined DRM_1024 */
+/*
+ * Radix-4 decimation in time on interleaved complex data. The first pass
+ * reads the input in bit reversed order, which saves a separate reordering
+ * step, and is a plain radix-2 pass when logm is odd. The remaining passes
+ * have span s = 2, 8, 32, ... or 4, 16, 64, ... and go through the CPU
+ * kernel table.
+ *
+ * For a pass of span s the twiddle table holds W^2, W, W^3 with
+ * W = exp(-2*pi*i*k/(4*s)), k = 0..s-1, each in the split layout of
+ * CPUKernels.cmul: 2*s reals of Re(W^j) followed by 2*s reals of
+ * (-Im(W^j), Im(W^j)). The passes of one size follow each other.
+ */
 
-void fft_initialize( FFT_Tables *fft_tables )
+static int first_span(int logm)
 {
-	int i;
-	fft_tables->costbl		= AllocMemory( (MAXLOGM+1) * sizeof( fft_tables->costbl[0] ) );
-	fft_tables->negsintbl	= AllocMemory( (MAXLOGM+1) * sizeof( fft_tables->negsintbl[0] ) );
-	fft_tables->reordertbl	= AllocMemory( (MAXLOGM+1) * sizeof( fft_tables->reordertbl[0] ) );
-	
-	for( i = 0; i< MAXLOGM+1; i++ )
-	{
-		fft_tables->costbl[i]		= NULL;
-		fft_tables->negsintbl[i]	= NULL;
-		fft_tables->reordertbl[i]	= NULL;
-	}
+	return (logm & 1) ? 2 : 4;
 }
 
-void fft_terminate( FFT_Tables *fft_tables )
+void fft_initialize( FFT_Tables *fft_tables, const CPUKernels *kernels, int frameLen )
 {
-	int i;
+	static const int power[3] = {2, 1, 3};
+	int logm;
 
-	for( i = 0; i< MAXLOGM+1; i++ )
+	SetMemory(fft_tables, 0, sizeof(*fft_tables));
+	fft_tables->kernels = kernels;
+
+	/* 960 and 480 sample frames */
+	if (!(frameLen % 15))
 	{
-		if( fft_tables->costbl[i] != NULL )
-			FreeMemory( fft_tables->costbl[i] );
-		
-		if( fft_tables->negsintbl[i] != NULL )
-			FreeMemory( fft_tables->negsintbl[i] );
-			
-		if( fft_tables->reordertbl[i] != NULL )
-			FreeMemory( fft_tables->reordertbl[i] );
+		kiss_initialize(fft_tables);
+		return;
 	}
 
-	FreeMemory( fft_tables->costbl );
-	FreeMemory( fft_tables->negsintbl );
-	FreeMemory( fft_tables->reordertbl );
-
-	fft_tables->costbl		= NULL;
-	fft_tables->negsintbl	= NULL;
-	fft_tables->reordertbl	= NULL;
-}
-
-static void reorder( FFT_Tables *fft_tables, double *x, int logm)
-{
-	int i;
-	int size = 1 << logm;
-	unsigned short *r;	//size
-
-
-	if ( fft_tables->reordertbl[logm] == NULL ) // create bit reversing table
+	for (logm = 0; logm <= MAXLOGM; logm++)
 	{
-		fft_tables->reordertbl[logm] = AllocMemory(size * sizeof(*(fft_tables->reordertbl[0])));
+		int size = 1 << logm;
+		int i, s, len = 0;
+		faac_real *w;
 
+		fft_tables->nfft[logm] = size;
+		fft_tables->reordertbl[logm] = AllocMemory(size * sizeof(*(fft_tables->reordertbl[0])));
 		for (i = 0; i < size; i++)
 		{
 			int reversed = 0;
@@ -293,92 +128,172 @@ static void reorder( FFT_Tables *fft_tables, double *x, int logm)
 			}
 			fft_tables->reordertbl[logm][i] = reversed;
 		}
+
+		for (s = first_span(logm); 4 * s <= size; s *= 4)
+			len += 12 * s;
+		fft_tables->twiddles[logm] = NULL;
+		if (!len)
+			continue;
+
+		w = fft_tables->twiddles[logm] = AllocMemory(len * sizeof(*w));
+		for (s = first_span(logm); 4 * s <= size; s *= 4)
+		{
+			int j, k;
+
+			for (j = 0; j < 3; j++)
+			{
+				for (k = 0; k < s; k++)
+				{
+					double theta = 2.0 * M_PI * power[j] * k / (4.0 * s);
+
+					w[2 * k] = w[2 * k + 1] = cos(theta);
+					w[2 * s + 2 * k] = sin(theta);
+					w[2 * s + 2 * k + 1] = -sin(theta);
+				}
+				w += 4 * s;
+			}
+		}
 	}
+}
 
-	r = fft_tables->reordertbl[logm];
+void fft_terminate( FFT_Tables *fft_tables )
+{
+	int i;
 
-	for (i = 0; i < size; i++)
+	for( i = 0; i< MAXLOGM+1; i++ )
 	{
-		int j = r[i];
-		double tmp;
+		if( fft_tables->twiddles[i] != NULL )
+			FreeMemory( fft_tables->twiddles[i] );
 
-		if (j <= i)
-			continue;
+		if( fft_tables->reordertbl[i] != NULL )
+			FreeMemory( fft_tables->reordertbl[i] );
+
+		fft_tables->twiddles[i]		= NULL;
+		fft_tables->reordertbl[i]	= NULL;
 
-		tmp = x[i];
-		x[i] = x[j];
-		x[j] = tmp;
+		/* allocated by kiss_fft_alloc() */
+		free( fft_tables->cfg[i][0] );
+		free( fft_tables->cfg[i][1] );
+		fft_tables->cfg[i][0]		= NULL;
+		fft_tables->cfg[i][1]		= NULL;
 	}
 }
 
-static void fft_proc(
-		double *xr, 
-		double *xi,
-		fftfloat *refac, 
-		fftfloat *imfac, 
-		int size)	
+/* element j of the input is (re[j * stride], im[j * stride]) */
+static void fft_proc( FFT_Tables *fft_tables, faac_real *out,
+		const faac_real *re, const faac_real *im, int stride, int logm)
 {
-	int step, shift, pos;
-	int exp, estep;
+	const unsigned short *r = fft_tables->reordertbl[logm];
+	const faac_real *w = fft_tables->twiddles[logm];
+	int size = 1 << logm;
+	int i, s;
 
-	estep = size;
-	for (step = 1; step < size; step *= 2)
+	if (logm & 1)
 	{
-		int x1;
-		int x2 = 0;
-		estep >>= 1;
-		for (pos = 0; pos < size; pos += (2 * step))
+		for (i = 0; i < size; i += 2)
 		{
-			x1 = x2;
-			x2 += step;
-			exp = 0;
-			for (shift = 0; shift < step; shift++)
-			{
-				double v2r, v2i;
+			int j0 = r[i] * stride, j1 = r[i + 1] * stride;
 
-				v2r = xr[x2] * refac[exp] - xi[x2] * imfac[exp];
-				v2i = xr[x2] * imfac[exp] + xi[x2] * refac[exp];
+			out[2 * i]     = re[j0] + re[j1];
+			out[2 * i + 1] = im[j0] + im[j1];
+			out[2 * i + 2] = re[j0] - re[j1];
+			out[2 * i + 3] = im[j0] - im[j1];
+		}
+	}
+	else
+	{
+		for (i = 0; i < size; i += 4)
+		{
+			int j0 = r[i] * stride, j1 = r[i + 1] * stride;
+			int j2 = r[i + 2] * stride, j3 = r[i + 3] * stride;
+			faac_real t0r = re[j0] + re[j1], t0i = im[j0] + im[j1];
+			faac_real t1r = re[j0] - re[j1], t1i = im[j0] - im[j1];
+			faac_real t2r = re[j2] + re[j3], t2i = im[j2] + im[j3];
+			faac_real t3r = re[j2] - re[j3], t3i = im[j2] - im[j3];
+
+			out[2 * i]     = t0r + t2r;
+			out[2 * i + 1] = t0i + t2i;
+			out[2 * i + 2] = t1r + t3i;
+			out[2 * i + 3] = t1i - t3r;
+			out[2 * i + 4] = t0r - t2r;
+			out[2 * i + 5] = t0i - t2i;
+			out[2 * i + 6] = t1r - t3i;
+			out[2 * i + 7] = t1i + t3r;
+		}
+	}
 
-				xr[x2] = xr[x1] - v2r;
-				xr[x1] += v2r;
+	for (s = first_span(logm); 4 * s <= size; s *= 4)
+	{
+		fft_tables->kernels->radix4(out, w, s, size);
+		w += 12 * s;
+	}
+}
 
-				xi[x2] = xi[x1] - v2i;
+void fft( FFT_Tables *fft_tables, faac_real *xr, faac_real *xi, int logm)
+{
+	faac_real x[2 << MAXLOGM];
+	int i;
 
-				xi[x1] += v2i;
+	if (logm > MAXLOGM)
+	{
+		fprintf(stderr, "fft size too big\n");
+		exit(1);
+	}
 
-				exp += estep;
+	if (logm < 1)
+	{
+		//printf("logm < 1\n");
+		return;
+	}
 
-				x1++;
-				x2++;
-			}
+	if (fft_tables->cfg[logm][0])
+	{
+		for (i = 0; i < fft_tables->nfft[logm]; i++)
+		{
+			x[2 * i] = xr[i];
+			x[2 * i + 1] = xi[i];
 		}
+		kiss_cfft( fft_tables, x, x, logm, 0);
+	}
+	else
+		fft_proc( fft_tables, x, xr, xi, 1, logm);
+
+	for (i = 0; i < fft_tables->nfft[logm]; i++)
+	{
+		xr[i] = x[2 * i];
+		xi[i] = x[2 * i + 1];
 	}
 }
 
-static void check_tables( FFT_Tables *fft_tables, int logm)
+void cfft( FFT_Tables *fft_tables, faac_real *out, const faac_real *in, int logm)
 {
-	if( fft_tables->costbl[logm] == NULL )
+	if (logm > MAXLOGM)
 	{
-		int i;
-		int size = 1 << logm;
-
-		if( fft_tables->negsintbl[logm] != NULL )
-			FreeMemory( fft_tables->negsintbl[logm] );
-
-		fft_tables->costbl[logm]	= AllocMemory((size / 2) * sizeof(*(fft_tables->costbl[0])));
-		fft_tables->negsintbl[logm]	= AllocMemory((size / 2) * sizeof(*(fft_tables->negsintbl[0])));
+		fprintf(stderr, "fft size too big\n");
+		exit(1);
+	}
 
-		for (i = 0; i < (size >> 1); i++)
-		{
-			double theta = 2.0 * M_PI * ((double) i) / (double) size;
-			fft_tables->costbl[logm][i]		= cos(theta);
-			fft_tables->negsintbl[logm][i]	= -sin(theta);
-		}
+	if (logm < 1)
+	{
+		out[0] = in[0];
+		out[1] = in[1];
+		return;
 	}
+
+	if (fft_tables->cfg[logm][0])
+		kiss_cfft( fft_tables, out, in, logm, 0);
+	else
+		fft_proc( fft_tables, out, in, in + 1, 2, logm);
 }
 
-void fft( FFT_Tables *fft_tables, double *xr, double *xi, int logm)
+/* same passes as fft_proc() with every value replaced by eight lanes */
+void cfft8( FFT_Tables *fft_tables, faac_real *out, const faac_real *in, int logm)
 {
+	const unsigned short *r = fft_tables->reordertbl[logm];
+	const faac_real *w = fft_tables->twiddles[logm];
+	int size = 1 << logm;
+	int i, l, s;
+
 	if (logm > MAXLOGM)
 	{
 		fprintf(stderr, "fft size too big\n");
@@ -387,21 +302,88 @@ void fft( FFT_Tables *fft_tables, double *xr, double *xi, int logm)
 
 	if (logm < 1)
 	{
-		//printf("logm < 1\n");
+		memcpy(out, in, 16 * sizeof(*out));
+		return;
+	}
+
+	/* kiss_fft one lane after the other */
+	if (fft_tables->cfg[logm][0])
+	{
+		kiss_fft_cpx fin[1 << MAXLOGM];
+		kiss_fft_cpx fout[1 << MAXLOGM];
+		int nfft = fft_tables->nfft[logm];
+
+		for (l = 0; l < 8; l++)
+		{
+			for (i = 0; i < nfft; i++)
+			{
+				fin[i].r = in[16 * i + l];
+				fin[i].i = in[16 * i + 8 + l];
+			}
+
+			kiss_fft((kiss_fft_cfg)fft_tables->cfg[logm][0], fin, fout);
+
+			for (i = 0; i < nfft; i++)
+			{
+				out[16 * i + l]     = fout[i].r;
+				out[16 * i + 8 + l] = fout[i].i;
+			}
+		}
 		return;
 	}
 
-	check_tables( fft_tables, logm);
+	if (logm & 1)
+	{
+		for (i = 0; i < size; i += 2)
+		{
+			const faac_real *a = in + 16 * r[i], *b = in + 16 * r[i + 1];
+			faac_real *o = out + 16 * i;
+
+			for (l = 0; l < 16; l++)
+			{
+				o[l]      = a[l] + b[l];
+				o[16 + l] = a[l] - b[l];
+			}
+		}
+	}
+	else
+	{
+		for (i = 0; i < size; i += 4)
+		{
+			const faac_real *a = in + 16 * r[i], *b = in + 16 * r[i + 1];
+			const faac_real *c = in + 16 * r[i + 2], *d = in + 16 * r[i + 3];
+			faac_real *o = out + 16 * i;
 
-	reorder( fft_tables, xr, logm);
-	reorder( fft_tables, xi, logm);
+			for (l = 0; l < 8; l++)
+			{
+				faac_real t0r = a[l] + b[l], t0i = a[8 + l] + b[8 + l];
+				faac_real t1r = a[l] - b[l], t1i = a[8 + l] - b[8 + l];
+				faac_real t2r = c[l] + d[l], t2i = c[8 + l] + d[8 + l];
+				faac_real t3r = c[l] - d[l], t3i = c[8 + l] - d[8 + l];
+
+				o[l]      = t0r + t2r;
+				o[8 + l]  = t0i + t2i;
+				o[16 + l] = t1r + t3i;
+				o[24 + l] = t1i - t3r;
+				o[32 + l] = t0r - t2r;
+				o[40 + l] = t0i - t2i;
+				o[48 + l] = t1r - t3i;
+				o[56 + l] = t1i + t3r;
+			}
+		}
+	}
 
-	fft_proc( xr, xi, fft_tables->costbl[logm], fft_tables->negsintbl[logm], 1 << logm );
+	for (s = first_span(logm); 4 * s <= size; s *= 4)
+	{
+		fft_tables->kernels->radix4_8(out, w, s, size);
+		w += 12 * s;
+	}
 }
 
-void rfft( FFT_Tables *fft_tables, double *x, int logm)
+void rfft( FFT_Tables *fft_tables, faac_real *x, int logm)
 {
-	double xi[1 << MAXLOGR];
+	faac_real xi[1 << MAXLOGR];
+	int size;
 
 	if (logm > MAXLOGR)
 	{
@@ -409,22 +391,23 @@ void rfft( FFT_Tables *fft_tables, double *x, int logm)
 		exit(1);
 	}
 
-	memset(xi, 0, (1 << logm) * sizeof(xi[0]));
+	size = fft_tables->nfft[logm];
+	memset(xi, 0, size * sizeof(xi[0]));
 
 	fft( fft_tables, x, xi, logm);
 
-	memcpy(x + (1 << (logm - 1)), xi, (1 << (logm - 1)) * sizeof(*x));
+	memcpy(x + size / 2, xi, size / 2 * sizeof(*x));
 }
 
-void ffti( FFT_Tables *fft_tables, double *xr, double *xi, int logm)
+void ffti( FFT_Tables *fft_tables, faac_real *xr, faac_real *xi, int logm)
 {
 	int i, size;
 	double fac;
-	double *xrp, *xip;
+	faac_real *xrp, *xip;
 
 	fft( fft_tables, xi, xr, logm);
 
-	size = 1 << logm;
+	size = fft_tables->nfft[logm];
 	fac = 1.0 / size;
 	xrp = xr;
 	xip = xi;
@@ -435,5 +418,3 @@ void ffti( FFT_Tables *fft_tables, double *xr, double *xi, int logm)
 		*xip++ *= fac;
 	}
 }
-
-#endif /* defined DRM && !defined DRM_1024 */
@@ -22,34 +22,40 @@
 #ifndef _FFT_H_
 #define _FFT_H_
 
-typedef float fftfloat;
+#include "coder.h"
+#include "cpu.h"
 
-#if defined DRM && !defined DRM_1024
-
-#define MAX_FFT 10
+#define MAXLOGM 9
 
+/*
+ * The transform of size logm has 2^logm points, or 15 * 2^(logm - 4) in
+ * tables for 960 and 480 sample frames. Powers of two go through the
+ * radix-4 FFT, the other sizes through kiss_fft.
+ */
 typedef struct
 {
-    /*      cfg[Max FFT][FFT and inverse FFT] */
-    void*   cfg[MAX_FFT][2];
-} FFT_Tables;
+    /* points of each size */
+    int nfft[MAXLOGM + 1];
 
-#else  /* use own FFT */
+    /* twiddles of the radix-4 passes of each size, see fft_initialize() */
+    faac_real *twiddles[MAXLOGM + 1];
+    unsigned short *reordertbl[MAXLOGM + 1];
+    const CPUKernels *kernels;
 
-typedef struct
-{
-    fftfloat **costbl;
-    fftfloat **negsintbl;
-    unsigned short **reordertbl;
+    /* kiss_fft configurations of each size, forward and inverse */
+    void *cfg[MAXLOGM + 1][2];
 } FFT_Tables;
 
-#endif /* defined DRM && !defined DRM_1024 */
-
-void fft_initialize		( FFT_Tables *fft_tables );
+/* tables for the transforms of frameLen sample frames */
+void fft_initialize		( FFT_Tables *fft_tables, const CPUKernels *kernels, int frameLen );
 void fft_terminate	( FFT_Tables *fft_tables );
 
-void rfft			( FFT_Tables *fft_tables, double *x, int logm );
-void fft			( FFT_Tables *fft_tables, double *xr, double *xi, int logm );
-void ffti			( FFT_Tables *fft_tables, double *xr, double *xi, int logm );
+void rfft			( FFT_Tables *fft_tables, faac_real *x, int logm );
+void fft			( FFT_Tables *fft_tables, faac_real *xr, faac_real *xi, int logm );
+void ffti			( FFT_Tables *fft_tables, faac_real *xr, faac_real *xi, int logm );
+/* out of place FFT of interleaved complex data, out must not overlap in */
+void cfft			( FFT_Tables *fft_tables, faac_real *out, const faac_real *in, int logm );
+/* cfft() of eight transforms at once, in the layout of CPUKernels.cmul8 */
+void cfft8			( FFT_Tables *fft_tables, faac_real *out, const faac_real *in, int logm );
 
 #endif
@@ -44,35 +44,41 @@ Copyright(c)1996.
 #define  TWOPI       2*M_PI
 
 
-static void		CalculateKBDWindow	( double* win, double alpha, int length );
+static void		CalculateKBDWindow	( faac_real* win, double alpha, int length );
 static double	Izero				( double x);
-static void		MDCT				( FFT_Tables *fft_tables, double *data, int N );
-static void		IMDCT				( FFT_Tables *fft_tables, double *data, int N );
+static void		IMDCT				( FFT_Tables *fft_tables, faac_real *data, int N );
 
 
 
-void FilterBankInit(faacEncStruct* hEncoder)
+void FilterBankWindows(SharedTables *tables)
 {
-    unsigned int i, channel;
+    int len = tables->frameLen;
+    int shortLen = len / MAX_SHORT_WINDOWS;
+    int i;
 
-    for (channel = 0; channel < hEncoder->numChannels; channel++) {
-        hEncoder->freqBuff[channel] = (double*)AllocMemory(2*FRAME_LEN*sizeof(double));
-        hEncoder->overlapBuff[channel] = (double*)AllocMemory(FRAME_LEN*sizeof(double));
-        SetMemory(hEncoder->overlapBuff[channel], 0, FRAME_LEN*sizeof(double));
-    }
+    tables->sin_window_long = (faac_real*)AllocMemory(len*sizeof(faac_real));
+    tables->sin_window_short = (faac_real*)AllocMemory(shortLen*sizeof(faac_real));
+    tables->kbd_window_long = (faac_real*)AllocMemory(len*sizeof(faac_real));
+    tables->kbd_window_short = (faac_real*)AllocMemory(shortLen*sizeof(faac_real));
+
+    for( i=0; i<len; i++ )
+        tables->sin_window_long[i] = sin((M_PI/(2*len)) * (i + 0.5));
+    for( i=0; i<shortLen; i++ )
+        tables->sin_window_short[i] = sin((M_PI/(2*shortLen)) * (i + 0.5));
 
-    hEncoder->sin_window_long = (double*)AllocMemory(BLOCK_LEN_LONG*sizeof(double));
-    hEncoder->sin_window_short = (double*)AllocMemory(BLOCK_LEN_SHORT*sizeof(double));
-    hEncoder->kbd_window_long = (double*)AllocMemory(BLOCK_LEN_LONG*sizeof(double));
-    hEncoder->kbd_window_short = (double*)AllocMemory(BLOCK_LEN_SHORT*sizeof(double));
+    CalculateKBDWindow(tables->kbd_window_long, 4, len*2);
+    CalculateKBDWindow(tables->kbd_window_short, 6, shortLen*2);
+}
 
-    for( i=0; i<BLOCK_LEN_LONG; i++ )
-        hEncoder->sin_window_long[i] = sin((M_PI/(2*BLOCK_LEN_LONG)) * (i + 0.5));
-    for( i=0; i<BLOCK_LEN_SHORT; i++ )
-        hEncoder->sin_window_short[i] = sin((M_PI/(2*BLOCK_LEN_SHORT)) * (i + 0.5));
+void FilterBankInit(faacEncStruct* hEncoder)
+{
+    unsigned int channel;
 
-    CalculateKBDWindow(hEncoder->kbd_window_long, 4, BLOCK_LEN_LONG*2);
-    CalculateKBDWindow(hEncoder->kbd_window_short, 6, BLOCK_LEN_SHORT*2);
+    for (channel = 0; channel < hEncoder->numChannels; channel++) {
+        hEncoder->freqBuff[channel] = (faac_real*)AllocMemory(2*FRAME_LEN*sizeof(faac_real));
+        hEncoder->overlapBuff[channel] = (faac_real*)AllocMemory(FRAME_LEN*sizeof(faac_real));
+        SetMemory(hEncoder->overlapBuff[channel], 0, FRAME_LEN*sizeof(faac_real));
+    }
 }
 
 void FilterBankEnd(faacEncStruct* hEncoder)
@@ -83,35 +89,34 @@ void FilterBankEnd(faacEncStruct* hEncoder)
         if (hEncoder->freqBuff[channel]) FreeMemory(hEncoder->freqBuff[channel]);
         if (hEncoder->overlapBuff[channel]) FreeMemory(hEncoder->overlapBuff[channel]);
     }
-
-    if (hEncoder->sin_window_long) FreeMemory(hEncoder->sin_window_long);
-    if (hEncoder->sin_window_short) FreeMemory(hEncoder->sin_window_short);
-    if (hEncoder->kbd_window_long) FreeMemory(hEncoder->kbd_window_long);
-    if (hEncoder->kbd_window_short) FreeMemory(hEncoder->kbd_window_short);
 }
 
 void FilterBank(faacEncStruct* hEncoder,
                 CoderInfo *coderInfo,
-                double *p_in_data,
-                double *p_out_mdct,
-                double *p_overlap,
+                faac_real *p_in_data,
+                faac_real *p_out_mdct,
+                faac_real *p_overlap,
                 int overlap_select)
 {
-    double *p_o_buf, *first_window, *second_window;
-    double *transf_buf;
-    int k, i;
+    faac_real *p_o_buf, *first_window, *second_window;
+    int i;
     int block_type = coderInfo->block_type;
-
-    transf_buf = (double*)AllocMemory(2*BLOCK_LEN_LONG*sizeof(double));
+    /* the frame length and the short blocks, an eighth of it */
+    int len = hEncoder->frameLen;
+    int shortLen = len / MAX_SHORT_WINDOWS;
+    int nflat = (len - shortLen) / 2;
+    const CPUKernels *kernels = &hEncoder->tables->kernels;
 
     /* create / shift old values */
     /* We use p_overlap here as buffer holding the last frame time signal*/
+    /* p_out_mdct holds 2*FRAME_LEN values, so the windowing below is done
+       in place there instead of going through a temporary buffer */
     if(overlap_select != MNON_OVERLAPPED) {
-        memcpy(transf_buf, p_overlap, FRAME_LEN*sizeof(double));
-        memcpy(transf_buf+BLOCK_LEN_LONG, p_in_data, FRAME_LEN*sizeof(double));
-        memcpy(p_overlap, p_in_data, FRAME_LEN*sizeof(double));
+        memcpy(p_out_mdct, p_overlap, len*sizeof(faac_real));
+        memcpy(p_out_mdct+len, p_in_data, len*sizeof(faac_real));
+        memcpy(p_overlap, p_in_data, len*sizeof(faac_real));
     } else {
-        memcpy(transf_buf, p_in_data, 2*FRAME_LEN*sizeof(double));
+        memcpy(p_out_mdct, p_in_data, 2*len*sizeof(faac_real));
     }
 
     /*  Window shape processing */
@@ -154,72 +159,65 @@ void FilterBank(faacEncStruct* hEncoder,
     }
 
     /* Set ptr to transf-Buffer */
-    p_o_buf = transf_buf;
+    p_o_buf = p_out_mdct;
 
     /* Separate action for each Block Type */
     switch (block_type) {
     case ONLY_LONG_WINDOW :
-        for ( i = 0 ; i < BLOCK_LEN_LONG ; i++){
-            p_out_mdct[i] = p_o_buf[i] * first_window[i];
-            p_out_mdct[i+BLOCK_LEN_LONG] = p_o_buf[i+BLOCK_LEN_LONG] * second_window[BLOCK_LEN_LONG-i-1];
-        }
-        MDCT( &hEncoder->fft_tables, p_out_mdct, 2*BLOCK_LEN_LONG );
+        kernels->window(p_out_mdct, first_window, len);
+        kernels->window_rev(p_out_mdct+len, second_window, len);
+        MDCT( hEncoder->mdctInfo, p_out_mdct, 2*len );
         break;
 
     case LONG_SHORT_WINDOW :
-        for ( i = 0 ; i < BLOCK_LEN_LONG ; i++)
-            p_out_mdct[i] = p_o_buf[i] * first_window[i];
-        memcpy(p_out_mdct+BLOCK_LEN_LONG,p_o_buf+BLOCK_LEN_LONG,NFLAT_LS*sizeof(double));
-        for ( i = 0 ; i < BLOCK_LEN_SHORT ; i++)
-            p_out_mdct[i+BLOCK_LEN_LONG+NFLAT_LS] = p_o_buf[i+BLOCK_LEN_LONG+NFLAT_LS] * second_window[BLOCK_LEN_SHORT-i-1];
-        SetMemory(p_out_mdct+BLOCK_LEN_LONG+NFLAT_LS+BLOCK_LEN_SHORT,0,NFLAT_LS*sizeof(double));
-        MDCT( &hEncoder->fft_tables, p_out_mdct, 2*BLOCK_LEN_LONG );
+        kernels->window(p_out_mdct, first_window, len);
+        kernels->window_rev(p_out_mdct+len+nflat, second_window, shortLen);
+        SetMemory(p_out_mdct+len+nflat+shortLen,0,nflat*sizeof(faac_real));
+        MDCT( hEncoder->mdctInfo, p_out_mdct, 2*len );
         break;
 
     case SHORT_LONG_WINDOW :
-        SetMemory(p_out_mdct,0,NFLAT_LS*sizeof(double));
-        for ( i = 0 ; i < BLOCK_LEN_SHORT ; i++)
-            p_out_mdct[i+NFLAT_LS] = p_o_buf[i+NFLAT_LS] * first_window[i];
-        memcpy(p_out_mdct+NFLAT_LS+BLOCK_LEN_SHORT,p_o_buf+NFLAT_LS+BLOCK_LEN_SHORT,NFLAT_LS*sizeof(double));
-        for ( i = 0 ; i < BLOCK_LEN_LONG ; i++)
-            p_out_mdct[i+BLOCK_LEN_LONG] = p_o_buf[i+BLOCK_LEN_LONG] * second_window[BLOCK_LEN_LONG-i-1];
-        MDCT( &hEncoder->fft_tables, p_out_mdct, 2*BLOCK_LEN_LONG );
+        SetMemory(p_out_mdct,0,nflat*sizeof(faac_real));
+        kernels->window(p_out_mdct+nflat, first_window, shortLen);
+        kernels->window_rev(p_out_mdct+len, second_window, len);
+        MDCT( hEncoder->mdctInfo, p_out_mdct, 2*len );
         break;
 
     case ONLY_SHORT_WINDOW :
-        p_o_buf += NFLAT_LS;
-        for ( k=0; k < MAX_SHORT_WINDOWS; k++ ) {
-            for ( i = 0 ; i < BLOCK_LEN_SHORT ; i++ ){
-                p_out_mdct[i] = p_o_buf[i] * first_window[i];
-                p_out_mdct[i+BLOCK_LEN_SHORT] = p_o_buf[i+BLOCK_LEN_SHORT] * second_window[BLOCK_LEN_SHORT-i-1];
+        {
+            faac_real window[2][2*BLOCK_LEN_SHORT];
+
+            for ( i = 0 ; i < shortLen ; i++ ){
+                window[0][i] = first_window[i];
+                window[1][i] = second_window[i];
+                window[0][i+shortLen] = second_window[shortLen-i-1];
+                window[1][i+shortLen] = second_window[shortLen-i-1];
             }
-            MDCT( &hEncoder->fft_tables, p_out_mdct, 2*BLOCK_LEN_SHORT );
-            p_out_mdct += BLOCK_LEN_SHORT;
-            p_o_buf += BLOCK_LEN_SHORT;
-            first_window = second_window;
+            MDCTShort( hEncoder->mdctInfo, p_out_mdct, p_o_buf+nflat, window[0], window[1] );
         }
         break;
     }
-
-    if (transf_buf) FreeMemory(transf_buf);
 }
 
 void IFilterBank(faacEncStruct* hEncoder,
                  CoderInfo *coderInfo,
-                 double *p_in_data,
-                 double *p_out_data,
-                 double *p_overlap,
+                 faac_real *p_in_data,
+                 faac_real *p_out_data,
+                 faac_real *p_overlap,
                  int overlap_select)
 {
-    double *o_buf, *transf_buf, *overlap_buf;
-    double *first_window, *second_window;
+    faac_real *o_buf, *transf_buf, *overlap_buf;
+    faac_real *first_window, *second_window;
 
-    double  *fp;
+    faac_real  *fp;
     int k, i;
     int block_type = coderInfo->block_type;
+    int len = hEncoder->frameLen;
+    int shortLen = len / MAX_SHORT_WINDOWS;
+    int nflat = (len - shortLen) / 2;
 
-    transf_buf = (double*)AllocMemory(2*BLOCK_LEN_LONG*sizeof(double));
-    overlap_buf = (double*)AllocMemory(2*BLOCK_LEN_LONG*sizeof(double));
+    transf_buf = (faac_real*)AllocMemory(2*len*sizeof(faac_real));
+    overlap_buf = (faac_real*)AllocMemory(2*len*sizeof(faac_real));
 
     /*  Window shape processing */
     if (overlap_select != MNON_OVERLAPPED) {
@@ -259,107 +257,107 @@ void IFilterBank(faacEncStruct* hEncoder,
     }
 
     /* Assemble overlap buffer */
-    memcpy(overlap_buf,p_overlap,BLOCK_LEN_LONG*sizeof(double));
+    memcpy(overlap_buf,p_overlap,len*sizeof(faac_real));
     o_buf = overlap_buf;
 
     /* Separate action for each Block Type */
     switch( block_type ) {
     case ONLY_LONG_WINDOW :
-        memcpy(transf_buf, p_in_data,BLOCK_LEN_LONG*sizeof(double));
-        IMDCT( &hEncoder->fft_tables, transf_buf, 2*BLOCK_LEN_LONG );
-        for ( i = 0 ; i < BLOCK_LEN_LONG ; i++)
+        memcpy(transf_buf, p_in_data,len*sizeof(faac_real));
+        IMDCT( hEncoder->fft_tables, transf_buf, 2*len );
+        for ( i = 0 ; i < len ; i++)
             transf_buf[i] *= first_window[i];
         if (overlap_select != MNON_OVERLAPPED) {
-            for ( i = 0 ; i < BLOCK_LEN_LONG; i++ ){
+            for ( i = 0 ; i < len; i++ ){
                 o_buf[i] += transf_buf[i];
-                o_buf[i+BLOCK_LEN_LONG] = transf_buf[i+BLOCK_LEN_LONG] * second_window[BLOCK_LEN_LONG-i-1];
+                o_buf[i+len] = transf_buf[i+len] * second_window[len-i-1];
             }
         } else { /* overlap_select == NON_OVERLAPPED */
-            for ( i = 0 ; i < BLOCK_LEN_LONG; i++ )
-                transf_buf[i+BLOCK_LEN_LONG] *= second_window[BLOCK_LEN_LONG-i-1];
+            for ( i = 0 ; i < len; i++ )
+                transf_buf[i+len] *= second_window[len-i-1];
         }
         break;
 
     case LONG_SHORT_WINDOW :
-        memcpy(transf_buf, p_in_data,BLOCK_LEN_LONG*sizeof(double));
-        IMDCT( &hEncoder->fft_tables, transf_buf, 2*BLOCK_LEN_LONG );
-        for ( i = 0 ; i < BLOCK_LEN_LONG ; i++)
+        memcpy(transf_buf, p_in_data,len*sizeof(faac_real));
+        IMDCT( hEncoder->fft_tables, transf_buf, 2*len );
+        for ( i = 0 ; i < len ; i++)
             transf_buf[i] *= first_window[i];
         if (overlap_select != MNON_OVERLAPPED) {
-            for ( i = 0 ; i < BLOCK_LEN_LONG; i++ )
+            for ( i = 0 ; i < len; i++ )
                 o_buf[i] += transf_buf[i];
-            memcpy(o_buf+BLOCK_LEN_LONG,transf_buf+BLOCK_LEN_LONG,NFLAT_LS*sizeof(double));
-            for ( i = 0 ; i < BLOCK_LEN_SHORT ; i++)
-                o_buf[i+BLOCK_LEN_LONG+NFLAT_LS] = transf_buf[i+BLOCK_LEN_LONG+NFLAT_LS] * second_window[BLOCK_LEN_SHORT-i-1];
-            SetMemory(o_buf+BLOCK_LEN_LONG+NFLAT_LS+BLOCK_LEN_SHORT,0,NFLAT_LS*sizeof(double));
+            memcpy(o_buf+len,transf_buf+len,nflat*sizeof(faac_real));
+            for ( i = 0 ; i < shortLen ; i++)
+                o_buf[i+len+nflat] = transf_buf[i+len+nflat] * second_window[shortLen-i-1];
+            SetMemory(o_buf+len+nflat+shortLen,0,nflat*sizeof(faac_real));
         } else { /* overlap_select == NON_OVERLAPPED */
-            for ( i = 0 ; i < BLOCK_LEN_SHORT ; i++)
-                transf_buf[i+BLOCK_LEN_LONG+NFLAT_LS] *= second_window[BLOCK_LEN_SHORT-i-1];
-            SetMemory(transf_buf+BLOCK_LEN_LONG+NFLAT_LS+BLOCK_LEN_SHORT,0,NFLAT_LS*sizeof(double));
+            for ( i = 0 ; i < shortLen ; i++)
+                transf_buf[i+len+nflat] *= second_window[shortLen-i-1];
+            SetMemory(transf_buf+len+nflat+shortLen,0,nflat*sizeof(faac_real));
         }
         break;
 
     case SHORT_LONG_WINDOW :
-        memcpy(transf_buf, p_in_data,BLOCK_LEN_LONG*sizeof(double));
-        IMDCT( &hEncoder->fft_tables, transf_buf, 2*BLOCK_LEN_LONG );
-        for ( i = 0 ; i < BLOCK_LEN_SHORT ; i++)
-            transf_buf[i+NFLAT_LS] *= first_window[i];
+        memcpy(transf_buf, p_in_data,len*sizeof(faac_real));
+        IMDCT( hEncoder->fft_tables, transf_buf, 2*len );
+        for ( i = 0 ; i < shortLen ; i++)
+            transf_buf[i+nflat] *= first_window[i];
         if (overlap_select != MNON_OVERLAPPED) {
-            for ( i = 0 ; i < BLOCK_LEN_SHORT; i++ )
-                o_buf[i+NFLAT_LS] += transf_buf[i+NFLAT_LS];
-            memcpy(o_buf+BLOCK_LEN_SHORT+NFLAT_LS,transf_buf+BLOCK_LEN_SHORT+NFLAT_LS,NFLAT_LS*sizeof(double));
-            for ( i = 0 ; i < BLOCK_LEN_LONG ; i++)
-                o_buf[i+BLOCK_LEN_LONG] = transf_buf[i+BLOCK_LEN_LONG] * second_window[BLOCK_LEN_LONG-i-1];
+            for ( i = 0 ; i < shortLen; i++ )
+                o_buf[i+nflat] += transf_buf[i+nflat];
+            memcpy(o_buf+shortLen+nflat,transf_buf+shortLen+nflat,nflat*sizeof(faac_real));
+            for ( i = 0 ; i < len ; i++)
+                o_buf[i+len] = transf_buf[i+len] * second_window[len-i-1];
         } else { /* overlap_select == NON_OVERLAPPED */
-            SetMemory(transf_buf,0,NFLAT_LS*sizeof(double));
-            for ( i = 0 ; i < BLOCK_LEN_LONG ; i++)
-                transf_buf[i+BLOCK_LEN_LONG] *= second_window[BLOCK_LEN_LONG-i-1];
+            SetMemory(transf_buf,0,nflat*sizeof(faac_real));
+            for ( i = 0 ; i < len ; i++)
+                transf_buf[i+len] *= second_window[len-i-1];
         }
         break;
 
     case ONLY_SHORT_WINDOW :
         if (overlap_select != MNON_OVERLAPPED) {
-            fp = o_buf + NFLAT_LS;
+            fp = o_buf + nflat;
         } else { /* overlap_select == NON_OVERLAPPED */
             fp = transf_buf;
         }
         for ( k=0; k < MAX_SHORT_WINDOWS; k++ ) {
-            memcpy(transf_buf,p_in_data,BLOCK_LEN_SHORT*sizeof(double));
-            IMDCT( &hEncoder->fft_tables, transf_buf, 2*BLOCK_LEN_SHORT );
-            p_in_data += BLOCK_LEN_SHORT;
+            memcpy(transf_buf,p_in_data,shortLen*sizeof(faac_real));
+            IMDCT( hEncoder->fft_tables, transf_buf, 2*shortLen );
+            p_in_data += shortLen;
             if (overlap_select != MNON_OVERLAPPED) {
-                for ( i = 0 ; i < BLOCK_LEN_SHORT ; i++){
+                for ( i = 0 ; i < shortLen ; i++){
                     transf_buf[i] *= first_window[i];
                     fp[i] += transf_buf[i];
-                    fp[i+BLOCK_LEN_SHORT] = transf_buf[i+BLOCK_LEN_SHORT] * second_window[BLOCK_LEN_SHORT-i-1];
+                    fp[i+shortLen] = transf_buf[i+shortLen] * second_window[shortLen-i-1];
                 }
-                fp += BLOCK_LEN_SHORT;
+                fp += shortLen;
             } else { /* overlap_select == NON_OVERLAPPED */
-                for ( i = 0 ; i < BLOCK_LEN_SHORT ; i++){
+                for ( i = 0 ; i < shortLen ; i++){
                     fp[i] *= first_window[i];
-                    fp[i+BLOCK_LEN_SHORT] *= second_window[BLOCK_LEN_SHORT-i-1];
+                    fp[i+shortLen] *= second_window[shortLen-i-1];
                 }
-                fp += 2*BLOCK_LEN_SHORT;
+                fp += 2*shortLen;
             }
             first_window = second_window;
         }
-        SetMemory(o_buf+BLOCK_LEN_LONG+NFLAT_LS+BLOCK_LEN_SHORT,0,NFLAT_LS*sizeof(double));
+        SetMemory(o_buf+len+nflat+shortLen,0,nflat*sizeof(faac_real));
         break;
     }
 
     if (overlap_select != MNON_OVERLAPPED)
-        memcpy(p_out_data,o_buf,BLOCK_LEN_LONG*sizeof(double));
+        memcpy(p_out_data,o_buf,len*sizeof(faac_real));
     else  /* overlap_select == NON_OVERLAPPED */
-        memcpy(p_out_data,transf_buf,2*BLOCK_LEN_LONG*sizeof(double));
+        memcpy(p_out_data,transf_buf,2*len*sizeof(faac_real));
 
     /* save unused output data */
-    memcpy(p_overlap,o_buf+BLOCK_LEN_LONG,BLOCK_LEN_LONG*sizeof(double));
+    memcpy(p_overlap,o_buf+len,len*sizeof(faac_real));
 
     if (overlap_buf) FreeMemory(overlap_buf);
     if (transf_buf) FreeMemory(transf_buf);
 }
 
-void specFilter(double *freqBuff,
+void specFilter(faac_real *freqBuff,
                 int sampleRate,
                 int lowpassFreq,
                 int specLen
@@ -371,7 +369,7 @@ void specFilter(double *freqBuff,
     lowpass = (lowpassFreq * specLen) / (sampleRate>>1) + 1;
     xlowpass = (lowpass < specLen) ? lowpass : specLen ;
 
-    SetMemory(freqBuff+xlowpass,0,(specLen-xlowpass)*sizeof(double));
+    SetMemory(freqBuff+xlowpass,0,(specLen-xlowpass)*sizeof(faac_real));
 }
 
 static double Izero(double x)
@@ -393,7 +391,7 @@ static double Izero(double x)
     return(sum);
 }
 
-static void CalculateKBDWindow(double* win, double alpha, int length)
+static void CalculateKBDWindow(faac_real* win, double alpha, int length)
 {
     int i;
     double IBeta;
@@ -420,96 +418,15 @@ static void CalculateKBDWindow(double* win, double alpha, int length)
     }
 }
 
-static void MDCT( FFT_Tables *fft_tables, double *data, int N )
-{
-    double *xi, *xr;
-    double tempr, tempi, c, s, cold, cfreq, sfreq; /* temps for pre and post twiddle */
-    double freq = TWOPI / N;
-    double cosfreq8, sinfreq8;
-    int i, n;
-
-    xi = (double*)AllocMemory((N >> 2)*sizeof(double));
-    xr = (double*)AllocMemory((N >> 2)*sizeof(double));
-
-    /* prepare for recurrence relation in pre-twiddle */
-    cfreq = cos (freq);
-    sfreq = sin (freq);
-    cosfreq8 = cos (freq * 0.125);
-    sinfreq8 = sin (freq * 0.125);
-    c = cosfreq8;
-    s = sinfreq8;
-
-    for (i = 0; i < (N >> 2); i++) {
-        /* calculate real and imaginary parts of g(n) or G(p) */
-        n = (N >> 1) - 1 - 2 * i;
-
-        if (i < (N >> 3))
-            tempr = data [(N >> 2) + n] + data [N + (N >> 2) - 1 - n]; /* use second form of e(n) for n = N / 2 - 1 - 2i */
-        else
-            tempr = data [(N >> 2) + n] - data [(N >> 2) - 1 - n]; /* use first form of e(n) for n = N / 2 - 1 - 2i */
-
-        n = 2 * i;
-        if (i < (N >> 3))
-            tempi = data [(N >> 2) + n] - data [(N >> 2) - 1 - n]; /* use first form of e(n) for n=2i */
-        else
-            tempi = data [(N >> 2) + n] + data [N + (N >> 2) - 1 - n]; /* use second form of e(n) for n=2i*/
-
-        /* calculate pre-twiddled FFT input */
-        xr[i] = tempr * c + tempi * s;
-        xi[i] = tempi * c - tempr * s;
-
-        /* use recurrence to prepare cosine and sine for next value of i */
-        cold = c;
-        c = c * cfreq - s * sfreq;
-        s = s * cfreq + cold * sfreq;
-    }
-
-    /* Perform in-place complex FFT of length N/4 */
-    switch (N) {
-    case BLOCK_LEN_SHORT * 2:
-        fft( fft_tables, xr, xi, 6);
-        break;
-    case BLOCK_LEN_LONG * 2:
-        fft( fft_tables, xr, xi, 9);
-    }
-
-    /* prepare for recurrence relations in post-twiddle */
-    c = cosfreq8;
-    s = sinfreq8;
-
-    /* post-twiddle FFT output and then get output data */
-    for (i = 0; i < (N >> 2); i++) {
-        /* get post-twiddled FFT output  */
-        tempr = 2. * (xr[i] * c + xi[i] * s);
-        tempi = 2. * (xi[i] * c - xr[i] * s);
-
-        /* fill in output values */
-        data [2 * i] = -tempr;   /* first half even */
-        data [(N >> 1) - 1 - 2 * i] = tempi;  /* first half odd */
-        data [(N >> 1) + 2 * i] = -tempi;  /* second half even */
-        data [N - 1 - 2 * i] = tempr;  /* second half odd */
-
-        /* use recurrence to prepare cosine and sine for next value of i */
-        cold = c;
-        c = c * cfreq - s * sfreq;
-        s = s * cfreq + cold * sfreq;
-    }
-
-    if (xr) FreeMemory(xr);
-    if (xi) FreeMemory(xi);
-}
-
-static void IMDCT( FFT_Tables *fft_tables, double *data, int N)
+static void IMDCT( FFT_Tables *fft_tables, faac_real *data, int N)
 {
-    double *xi, *xr;
+    faac_real xi[BLOCK_LEN_LONG / 2];
+    faac_real xr[BLOCK_LEN_LONG / 2];
     double tempr, tempi, c, s, cold, cfreq, sfreq; /* temps for pre and post twiddle */
     double freq = 2.0 * M_PI / N;
     double fac, cosfreq8, sinfreq8;
     int i;
 
-    xi = (double*)AllocMemory((N >> 2)*sizeof(double));
-    xr = (double*)AllocMemory((N >> 2)*sizeof(double));
-
     /* Choosing to allocate 2/N factor to Inverse Xform! */
     fac = 2. / N; /* remaining 2/N from 4/N IFFT factor */
 
@@ -537,13 +454,12 @@ static void IMDCT( FFT_Tables *fft_tables, double *data, int N)
     }
 
     /* Perform in-place complex IFFT of length N/4 */
-    switch (N) {
-    case BLOCK_LEN_SHORT * 2:
-        ffti( fft_tables, xr, xi, 6);
-        break;
-    case BLOCK_LEN_LONG * 2:
-        ffti( fft_tables, xr, xi, 9);
+    for (i = 0; i < MAXLOGM; i++)
+    {
+        if (fft_tables->nfft[i] >= (N >> 2))
+            break;
     }
+    ffti( fft_tables, xr, xi, i);
 
     /* prepare for recurrence relations in post-twiddle */
     c = cosfreq8;
@@ -574,7 +490,4 @@ static void IMDCT( FFT_Tables *fft_tables, double *data, int N)
         c = c * cfreq - s * sfreq;
         s = s * cfreq + cold * sfreq;
     }
-
-    if (xr) FreeMemory(xr);
-    if (xi) FreeMemory(xi);
 }
@@ -28,12 +28,6 @@ extern "C" {
 
 #include "frame.h"
 
-#ifdef DRM
-#define NFLAT_LS (( BLOCK_LEN_LONG - BLOCK_LEN_SHORT ) / 2)
-#else
-#define NFLAT_LS 448
-#endif
-
 #define MOVERLAPPED     0
 #define MNON_OVERLAPPED 1
 
@@ -41,25 +35,28 @@ extern "C" {
 #define SINE_WINDOW 0
 #define KBD_WINDOW  1
 
+/* fill in the windows of the shared tables */
+void			FilterBankWindows	( SharedTables *tables );
+
 void			FilterBankInit		( faacEncStruct* hEncoder );
 
 void			FilterBankEnd		( faacEncStruct* hEncoder );
 
 void			FilterBank( faacEncStruct* hEncoder,
 						CoderInfo *coderInfo,
-						double *p_in_data,
-						double *p_out_mdct,
-						double *p_overlap,
+						faac_real *p_in_data,
+						faac_real *p_out_mdct,
+						faac_real *p_overlap,
 						int overlap_select );
 
 void			IFilterBank( faacEncStruct* hEncoder,
 						CoderInfo *coderInfo,
-						double *p_in_data,
-						double *p_out_mdct,
-						double *p_overlap,
+						faac_real *p_in_data,
+						faac_real *p_out_mdct,
+						faac_real *p_overlap,
 						int overlap_select );
 
-void			specFilter(	double *freqBuff,
+void			specFilter(	faac_real *freqBuff,
 						int sampleRate,
 						int lowpassFreq,
 						int specLen );
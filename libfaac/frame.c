@@ -22,6 +22,7 @@
 #include <stdlib.h>
 #include <assert.h>
 #include <string.h>
+#include <math.h>
 
 #include "frame.h"
 #include "coder.h"
@@ -49,6 +50,45 @@ static const psymodellist_t psymodellist[] = {
 };
 
 static SR_INFO srInfo[12+1];
+static SR_INFO srInfo960[12+1];
+#ifndef DRM
+static SR_INFO srInfoLD[12+1];
+static SR_INFO srInfoLD480[12+1];
+#endif
+
+#ifdef DRM
+/* Highest quality of a DRM frame, and fraction of the frame budget the
+   rate control aims at, leaving room for its error. A frame below
+   RATEMINFILL of the budget is coded again. */
+#define DRMMAXQUAL 120
+#define RATEFILL 0.95
+#define RATEMINFILL 0.85
+
+/* Quality expected to code target bits, if the frame takes scale bits
+   per BlocBits() */
+static double RateQuality(const BlocLevels *levels, double scale, double target)
+{
+    double lo = 1.0, hi = DRMMAXQUAL;
+    int cnt;
+
+    if (scale * BlocBits(levels, hi) <= target)
+        return hi;
+    if (scale * BlocBits(levels, lo) >= target)
+        return lo;
+
+    for (cnt = 0; cnt < 16; cnt++)
+    {
+        double mid = sqrt(lo * hi);
+
+        if (scale * BlocBits(levels, mid) > target)
+            hi = mid;
+        else
+            lo = mid;
+    }
+
+    return lo;
+}
+#endif
 
 // default bandwidth/samplerate ratio
 static const struct {
@@ -72,7 +112,7 @@ int FAACAPI faacEncGetVersion( char **faac_id_string,
 int FAACAPI faacEncGetDecoderSpecificInfo(faacEncHandle hpEncoder,unsigned char** ppBuffer,unsigned long* pSizeOfDecoderSpecificInfo)
 {
     faacEncStruct* hEncoder = (faacEncStruct*)hpEncoder;
-    BitStream* pBitStream = NULL;
+    BitStream bitStream;
 
     if((hEncoder == NULL) || (ppBuffer == NULL) || (pSizeOfDecoderSpecificInfo == NULL)) {
         return -1;
@@ -82,17 +122,28 @@ int FAACAPI faacEncGetDecoderSpecificInfo(faacEncHandle hpEncoder,unsigned char*
         return -2; /* not supported */
     }
 
-    *pSizeOfDecoderSpecificInfo = 2;
-    *ppBuffer = malloc(2);
+    *pSizeOfDecoderSpecificInfo = (hEncoder->config.aacObjectType == LD) ? 3 : 2;
+    *ppBuffer = malloc(*pSizeOfDecoderSpecificInfo);
 
     if(*ppBuffer != NULL){
 
         memset(*ppBuffer,0,*pSizeOfDecoderSpecificInfo);
-        pBitStream = OpenBitStream(*pSizeOfDecoderSpecificInfo, *ppBuffer);
-        PutBit(pBitStream, hEncoder->config.aacObjectType, 5);
-        PutBit(pBitStream, hEncoder->sampleRateIdx, 4);
-        PutBit(pBitStream, hEncoder->numChannels, 4);
-        CloseBitStream(pBitStream);
+        OpenBitStream(&bitStream, *pSizeOfDecoderSpecificInfo, *ppBuffer);
+        PutBit(&bitStream, hEncoder->config.aacObjectType, 5);
+        PutBit(&bitStream, hEncoder->sampleRateIdx, 4);
+        PutBit(&bitStream, hEncoder->numChannels, 4);
+        /* GASpecificConfig: frameLengthFlag, 960 or 480 samples */
+        PutBit(&bitStream, hEncoder->frameLengthFlag, 1);
+        if (hEncoder->config.aacObjectType == LD)
+        {
+            /* ER object type, then epConfig */
+            PutBit(&bitStream, 0, 1); /* dependsOnCoreCoder */
+            PutBit(&bitStream, 1, 1); /* extensionFlag */
+            PutBit(&bitStream, 0, 3); /* no section, scalefactor or spectral data resilience */
+            PutBit(&bitStream, 0, 1); /* extensionFlag3 */
+            PutBit(&bitStream, 0, 2); /* epConfig */
+        }
+        CloseBitStream(&bitStream);
 
         return 0;
     } else {
@@ -101,6 +152,112 @@ int FAACAPI faacEncGetDecoderSpecificInfo(faacEncHandle hpEncoder,unsigned char*
 }
 
 
+/* Determine the channel configuration and the channel elements */
+static void SetupChannels(faacEncStruct *hEncoder)
+{
+    ChannelInfo *channelInfo = hEncoder->channelInfo;
+    unsigned int channel;
+
+    GetChannelInfo(channelInfo, hEncoder->numChannels, hEncoder->config.useLfe);
+
+    hEncoder->numElements = 0;
+    for (channel = 0; channel < hEncoder->numChannels; channel++)
+    {
+        if (!channelInfo[channel].cpe || channelInfo[channel].ch_is_left)
+            hEncoder->element[hEncoder->numElements++] = channel;
+    }
+}
+
+static void FreeChannels(faacEncStruct *hEncoder)
+{
+    if (hEncoder->coderInfo)
+        FreeMemory(hEncoder->coderInfo);
+    if (hEncoder->channelInfo)
+        FreeMemory(hEncoder->channelInfo);
+    if (hEncoder->psyInfo)
+        FreeMemory(hEncoder->psyInfo);
+}
+
+/* Scalefactor band tables for frameLen */
+static SR_INFO *FrameSrInfo(unsigned int frameLen)
+{
+    switch (frameLen)
+    {
+    case FRAME_LEN_960:
+        return srInfo960;
+#ifndef DRM
+    case LD_FRAME_LEN:
+        return srInfoLD;
+    case LD_FRAME_LEN_480:
+        return srInfoLD480;
+#endif
+    }
+
+    return srInfo;
+}
+
+/* Point the encoder at the shared tables for frameLen */
+static int SetTables(faacEncStruct *hEncoder, unsigned int frameLen)
+{
+    SharedTables *tables = TablesAcquire(frameLen);
+
+    if (!tables)
+        return 0;
+    TablesRelease(hEncoder->tables);
+
+    hEncoder->tables = tables;
+    hEncoder->frameLen = frameLen;
+    hEncoder->aacquantCfg.frameLen = frameLen;
+    hEncoder->aacquantCfg.kernels = &tables->kernels;
+    hEncoder->fft_tables = &tables->fft_tables;
+    hEncoder->mdctInfo = &tables->mdctInfo;
+    hEncoder->gpsyInfo.frameLen = frameLen;
+    hEncoder->gpsyInfo.hannWindowS = tables->hann_window_short;
+    hEncoder->sin_window_long = tables->sin_window_long;
+    hEncoder->sin_window_short = tables->sin_window_short;
+    hEncoder->kbd_window_long = tables->kbd_window_long;
+    hEncoder->kbd_window_short = tables->kbd_window_short;
+
+    return 1;
+}
+
+/* Frame length of the object type in config, 0 if it cannot be coded */
+static unsigned int ObjectFrameLen(faacEncStruct *hEncoder,
+                                   faacEncConfigurationPtr config)
+{
+#ifndef DRM
+    unsigned int frameLen;
+#endif
+
+    switch (config->aacObjectType)
+    {
+    case LOW:
+        if (!hEncoder->frameLengthFlag)
+            return FRAME_LEN;
+#ifndef DRM
+        /* only the AudioSpecificConfig can tell 960 sample frames */
+        if (config->outputFormat != RAW_STREAM || config->mpegVersion != MPEG4)
+            return 0;
+#endif
+        return FRAME_LEN_960;
+#ifndef DRM
+    case LD:
+        /* ADTS has no profile for LD, the channel configuration is
+           written as the number of channels */
+        if (config->outputFormat != RAW_STREAM || config->mpegVersion != MPEG4)
+            return 0;
+        if (hEncoder->numChannels < 1 || hEncoder->numChannels > 6)
+            return 0;
+        frameLen = hEncoder->frameLengthFlag ? LD_FRAME_LEN_480 : LD_FRAME_LEN;
+        if (!FrameSrInfo(frameLen)[hEncoder->sampleRateIdx].num_cb_long)
+            return 0;
+        return frameLen;
+#endif
+    }
+
+    return 0;
+}
+
 faacEncConfigurationPtr FAACAPI faacEncGetCurrentConfiguration(faacEncHandle hpEncoder)
 {
     faacEncStruct* hEncoder = (faacEncStruct*)hpEncoder;
@@ -115,6 +272,20 @@ int FAACAPI faacEncSetConfiguration(faacEncHandle hpEncoder,
     faacEncStruct* hEncoder = (faacEncStruct*)hpEncoder;
     int i;
     int maxqual = hEncoder->config.outputFormat ? MAXQUALADTS : MAXQUAL;
+    unsigned int frameLen;
+
+    /* let a pipelined frame finish with the old settings */
+    PoolWait(hEncoder->pipe);
+
+    /* the frame length can only change before the first frame */
+    frameLen = ObjectFrameLen(hEncoder, config);
+    if (!frameLen)
+        return 0;
+    if (frameLen != hEncoder->frameLen)
+    {
+        if (hEncoder->frameNum || !SetTables(hEncoder, frameLen))
+            return 0;
+    }
 
     hEncoder->config.jointmode = config->jointmode;
     hEncoder->config.useLfe = config->useLfe;
@@ -140,8 +311,16 @@ int FAACAPI faacEncSetConfiguration(faacEncHandle hpEncoder,
             break;
     }
 
-    if (hEncoder->config.aacObjectType != LOW)
-        return 0;
+    hEncoder->srInfo = &FrameSrInfo(frameLen)[hEncoder->sampleRateIdx];
+#ifndef DRM
+    if (hEncoder->config.aacObjectType == LD)
+    {
+        /* no block switching, and TNS is only tabled for 1024 and 128
+           sample blocks */
+        hEncoder->config.shortctl = SHORTCTL_NOSHORT;
+        hEncoder->config.useTns = 0;
+    }
+#endif
 
 #ifdef DRM
     config->pnslevel = 0;
@@ -153,8 +332,8 @@ int FAACAPI faacEncSetConfiguration(faacEncHandle hpEncoder,
     /* Check for correct bitrate */
     if (!hEncoder->sampleRate || !hEncoder->numChannels)
         return 0;
-    if (config->bitRate > (MaxBitrate(hEncoder->sampleRate) / hEncoder->numChannels))
-        config->bitRate = MaxBitrate(hEncoder->sampleRate) / hEncoder->numChannels;
+    if (config->bitRate > (MaxBitrate(hEncoder->sampleRate, frameLen) / hEncoder->numChannels))
+        config->bitRate = MaxBitrate(hEncoder->sampleRate, frameLen) / hEncoder->numChannels;
 #if 0
     if (config->bitRate < MinBitrate())
         return 0;
@@ -229,6 +408,8 @@ int FAACAPI faacEncSetConfiguration(faacEncHandle hpEncoder,
 	for( i = 0; i < MAX_CHANNELS; i++ )
 		hEncoder->config.channel_map[i] = config->channel_map[i];
 
+    SetupChannels(hEncoder);
+
     /* OK */
     return 1;
 }
@@ -240,11 +421,16 @@ faacEncHandle FAACAPI faacEncOpen(unsigned long sampleRate,
 {
     unsigned int channel;
     faacEncStruct* hEncoder;
+#ifdef DRM
+    unsigned int frameLen = FRAME_LEN_960;
+#else
+    unsigned int frameLen = FRAME_LEN;
+#endif
 
     if (numChannels > MAX_CHANNELS)
 	return NULL;
 
-    *inputSamples = FRAME_LEN*numChannels;
+    *inputSamples = frameLen*numChannels;
     *maxOutputBytes = ADTS_FRAMESIZE;
 
 #ifdef DRM
@@ -252,8 +438,24 @@ faacEncHandle FAACAPI faacEncOpen(unsigned long sampleRate,
 #endif
 
     hEncoder = (faacEncStruct*)AllocMemory(sizeof(faacEncStruct));
+    if (!hEncoder)
+        return NULL;
     SetMemory(hEncoder, 0, sizeof(faacEncStruct));
 
+    /* per channel state, only for the channels there are */
+    hEncoder->coderInfo = (CoderInfo*)AllocMemory(numChannels*sizeof(CoderInfo));
+    hEncoder->channelInfo = (ChannelInfo*)AllocMemory(numChannels*sizeof(ChannelInfo));
+    hEncoder->psyInfo = (PsyInfo*)AllocMemory(numChannels*sizeof(PsyInfo));
+    if (!hEncoder->coderInfo || !hEncoder->channelInfo || !hEncoder->psyInfo)
+    {
+        FreeChannels(hEncoder);
+        FreeMemory(hEncoder);
+        return NULL;
+    }
+    SetMemory(hEncoder->coderInfo, 0, numChannels*sizeof(CoderInfo));
+    SetMemory(hEncoder->channelInfo, 0, numChannels*sizeof(ChannelInfo));
+    SetMemory(hEncoder->psyInfo, 0, numChannels*sizeof(PsyInfo));
+
     hEncoder->numChannels = numChannels;
     hEncoder->sampleRate = sampleRate;
     hEncoder->sampleRateIdx = GetSRIndex(sampleRate);
@@ -261,6 +463,7 @@ faacEncHandle FAACAPI faacEncOpen(unsigned long sampleRate,
     /* Initialize variables to default values */
     hEncoder->frameNum = 0;
     hEncoder->flushFrame = 0;
+    hEncoder->frameLengthFlag = (frameLen == FRAME_LEN_960);
 
     /* Default configuration */
     hEncoder->config.version = FAAC_CFG_VERSION;
@@ -293,7 +496,7 @@ faacEncHandle FAACAPI faacEncOpen(unsigned long sampleRate,
     hEncoder->config.inputFormat = FAAC_INPUT_32BIT;
 
     /* find correct sampling rate depending parameters */
-    hEncoder->srInfo = &srInfo[hEncoder->sampleRateIdx];
+    hEncoder->srInfo = &FrameSrInfo(frameLen)[hEncoder->sampleRateIdx];
 
     for (channel = 0; channel < numChannels; channel++)
 	{
@@ -303,14 +506,31 @@ faacEncHandle FAACAPI faacEncOpen(unsigned long sampleRate,
         hEncoder->coderInfo[channel].groups.n = 1;
         hEncoder->coderInfo[channel].groups.len[0] = 1;
 
-        hEncoder->sampleBuff[channel] = NULL;
-        hEncoder->nextSampleBuff[channel] = NULL;
-        hEncoder->next2SampleBuff[channel] = NULL;
+        /* allocate all sample buffers up front, nothing is allocated
+           per frame in faacEncEncode() */
+        hEncoder->sampleBuff[channel] = (faac_real*)AllocMemory(FRAME_LEN*sizeof(faac_real));
+        hEncoder->nextSampleBuff[channel] = (faac_real*)AllocMemory(FRAME_LEN*sizeof(faac_real));
+        hEncoder->next2SampleBuff[channel] = (faac_real*)AllocMemory(FRAME_LEN*sizeof(faac_real));
+        hEncoder->next3SampleBuff[channel] = (faac_real*)AllocMemory(FRAME_LEN*sizeof(faac_real));
+        SetMemory(hEncoder->sampleBuff[channel], 0, FRAME_LEN*sizeof(faac_real));
+        SetMemory(hEncoder->nextSampleBuff[channel], 0, FRAME_LEN*sizeof(faac_real));
+        SetMemory(hEncoder->next2SampleBuff[channel], 0, FRAME_LEN*sizeof(faac_real));
+        SetMemory(hEncoder->next3SampleBuff[channel], 0, FRAME_LEN*sizeof(faac_real));
     }
 
-    /* Initialize coder functions */
-	fft_initialize( &hEncoder->fft_tables );
-
+    if (!SetTables(hEncoder, frameLen))
+    {
+        for (channel = 0; channel < numChannels; channel++)
+        {
+            FreeMemory(hEncoder->sampleBuff[channel]);
+            FreeMemory(hEncoder->nextSampleBuff[channel]);
+            FreeMemory(hEncoder->next2SampleBuff[channel]);
+            FreeMemory(hEncoder->next3SampleBuff[channel]);
+        }
+        FreeChannels(hEncoder);
+        FreeMemory(hEncoder);
+        return NULL;
+    }
 	hEncoder->psymodel->PsyInit(&hEncoder->gpsyInfo, hEncoder->psyInfo, hEncoder->numChannels,
         hEncoder->sampleRate, hEncoder->srInfo->cb_width_long,
         hEncoder->srInfo->num_cb_long, hEncoder->srInfo->cb_width_short,
@@ -320,21 +540,291 @@ faacEncHandle FAACAPI faacEncOpen(unsigned long sampleRate,
 
     TnsInit(hEncoder);
 
+    SetupChannels(hEncoder);
+
     /* Return handle */
     return hEncoder;
 }
 
+int FAACAPI faacEncSetThreads(faacEncHandle hpEncoder, unsigned int numThreads)
+{
+    faacEncStruct* hEncoder = (faacEncStruct*)hpEncoder;
+
+    /* a pipelined frame may be using the pool */
+    PoolWait(hEncoder->pipe);
+
+    PoolDestroy(hEncoder->pool);
+    hEncoder->pool = NULL;
+
+    /* there is no more than one job per channel */
+    if (numThreads > hEncoder->numChannels)
+        numThreads = hEncoder->numChannels;
+
+    if (numThreads > 1)
+    {
+        hEncoder->pool = PoolCreate(numThreads);
+        if (!hEncoder->pool)
+            return 0;
+    }
+
+    return 1;
+}
+
+int FAACAPI faacEncSetPipeline(faacEncHandle hpEncoder, unsigned int enable)
+{
+    faacEncStruct* hEncoder = (faacEncStruct*)hpEncoder;
+    unsigned int channel;
+
+    /* only before the first frame */
+    if (hEncoder->frameNum)
+        return 0;
+
+    if (!enable == !hEncoder->pipe)
+        return 1;
+
+    /* the rungs of a ladder are coded in the calling thread */
+    if (enable && hEncoder->ladderRungs)
+        return 0;
+
+    if (!enable)
+    {
+        PoolDestroy(hEncoder->pipe);
+        hEncoder->pipe = NULL;
+        return 1;
+    }
+
+    /* one worker for the coding stage */
+    hEncoder->pipe = PoolCreate(2);
+    if (!hEncoder->pipe)
+        return 0;
+
+    if (!hEncoder->codeBuffer)
+    {
+        hEncoder->codeBuffer = (unsigned char*)AllocMemory(ADTS_FRAMESIZE + 1);
+        for (channel = 0; channel < hEncoder->numChannels; channel++)
+        {
+            hEncoder->spareSampleBuff[channel] = (faac_real*)AllocMemory(FRAME_LEN*sizeof(faac_real));
+            SetMemory(hEncoder->spareSampleBuff[channel], 0, FRAME_LEN*sizeof(faac_real));
+        }
+    }
+
+    return 1;
+}
+
+/* Frames the coded frame lags behind the newest input, see faacEncStruct */
+static unsigned int Lookahead(faacEncStruct *hEncoder)
+{
+    if (hEncoder->frameNum)
+        return hEncoder->lookahead;
+    /* LD codes every frame at once */
+    if (hEncoder->config.aacObjectType == LD)
+        return 0;
+    if (!hEncoder->lowDelay)
+        return 3;
+    /* block switching needs the next frame, nothing else looks ahead */
+    if (hEncoder->config.shortctl == SHORTCTL_NOSHORT
+        || hEncoder->config.shortctl == SHORTCTL_NOLONG)
+        return 0;
+    return 1;
+}
+
+int FAACAPI faacEncSetLowDelay(faacEncHandle hpEncoder, unsigned int enable)
+{
+    faacEncStruct* hEncoder = (faacEncStruct*)hpEncoder;
+
+    /* only before the first frame */
+    if (hEncoder->frameNum)
+        return 0;
+
+    hEncoder->lowDelay = (enable != 0);
+
+    return 1;
+}
+
+unsigned int FAACAPI faacEncGetLatency(faacEncHandle hpEncoder)
+{
+    faacEncStruct* hEncoder = (faacEncStruct*)hpEncoder;
+
+    /* a frame is coded lookahead frames after it was passed in, one
+       more when the coding stage is pipelined */
+    return (Lookahead(hEncoder) + (hEncoder->pipe ? 1 : 0)) * hEncoder->frameLen;
+}
+
+unsigned int FAACAPI faacEncGetDelay(faacEncHandle hpEncoder)
+{
+    faacEncStruct* hEncoder = (faacEncStruct*)hpEncoder;
+
+    /* the first frame overlaps a frame of silence before the input */
+    return hEncoder->frameLen;
+}
+
+unsigned int FAACAPI faacEncGetFrameLength(faacEncHandle hpEncoder)
+{
+    faacEncStruct* hEncoder = (faacEncStruct*)hpEncoder;
+
+    return hEncoder->frameLen;
+}
+
+int FAACAPI faacEncSetFrameLength(faacEncHandle hpEncoder, unsigned int frameLength)
+{
+    faacEncStruct* hEncoder = (faacEncStruct*)hpEncoder;
+    faacEncConfiguration config;
+    int frameLengthFlag = hEncoder->frameLengthFlag;
+    /* the lengths of the configured object type, without and with the
+       frameLengthFlag */
+    unsigned int longLen = FRAME_LEN, shortLen = FRAME_LEN_960;
+
+#ifndef DRM
+    if (hEncoder->config.aacObjectType == LD)
+    {
+        longLen = LD_FRAME_LEN;
+        shortLen = LD_FRAME_LEN_480;
+    }
+#endif
+    if ((frameLength != longLen) && (frameLength != shortLen))
+        return 0;
+
+    /* set up the tables of the configured object type, only before the
+       first frame */
+    hEncoder->frameLengthFlag = (frameLength == shortLen);
+    config = hEncoder->config;
+    if (!faacEncSetConfiguration(hEncoder, &config))
+    {
+        hEncoder->frameLengthFlag = frameLengthFlag;
+        return 0;
+    }
+
+    return 1;
+}
+
+int FAACAPI faacEncSetLadder(faacEncHandle hpEncoder, faacEncHandle *rungs,
+                             unsigned int numRungs)
+{
+    faacEncStruct* hEncoder = (faacEncStruct*)hpEncoder;
+    unsigned int i;
+
+    /* only before the first frame, and not pipelined */
+    if (hEncoder->frameNum || hEncoder->pipe)
+        return 0;
+
+    for (i = 0; i < numRungs; i++)
+    {
+        faacEncStruct *rung = (faacEncStruct*)rungs[i];
+
+        /* the same channel elements and transform */
+        if (!rung || rung == hEncoder || rung->frameNum
+            || rung->sampleRate != hEncoder->sampleRate
+            || rung->numChannels != hEncoder->numChannels
+            || rung->frameLen != hEncoder->frameLen
+            || rung->config.aacObjectType != hEncoder->config.aacObjectType
+            || rung->config.useLfe != hEncoder->config.useLfe)
+            return 0;
+    }
+
+    if (hEncoder->ladder)
+        FreeMemory(hEncoder->ladder);
+    hEncoder->ladder = NULL;
+    hEncoder->ladderRungs = 0;
+
+    if (numRungs)
+    {
+        hEncoder->ladder = (faacEncHandle*)AllocMemory(numRungs * sizeof(faacEncHandle));
+        if (!hEncoder->ladder)
+            return 0;
+        for (i = 0; i < numRungs; i++)
+            hEncoder->ladder[i] = rungs[i];
+        hEncoder->ladderRungs = numRungs;
+    }
+
+    return 1;
+}
+
+unsigned long FAACAPI faacEncGetFootprint(faacEncHandle hpEncoder)
+{
+    faacEncStruct* hEncoder = (faacEncStruct*)hpEncoder;
+    unsigned long bytes = sizeof(faacEncStruct);
+    unsigned int buffers;
+
+    bytes += hEncoder->numChannels * (sizeof(CoderInfo) + sizeof(ChannelInfo)
+                                      + sizeof(PsyInfo));
+
+    /* input, spectrum and overlap */
+    buffers = 4 + 2 + 1;
+    if (hEncoder->codeBuffer)
+    {
+        buffers++;
+        bytes += ADTS_FRAMESIZE + 1;
+    }
+    bytes += hEncoder->numChannels * buffers * FRAME_LEN * sizeof(faac_real);
+
+    bytes += hEncoder->gpsyInfo.memory;
+    bytes += hEncoder->ladderRungs * sizeof(faacEncHandle);
+
+    return bytes;
+}
+
+int FAACAPI faacEncReset(faacEncHandle hpEncoder)
+{
+    faacEncStruct* hEncoder = (faacEncStruct*)hpEncoder;
+    unsigned int channel;
+
+    /* drop a pipelined frame */
+    PoolWait(hEncoder->pipe);
+    hEncoder->codePending = 0;
+
+    hEncoder->frameNum = 0;
+    hEncoder->flushFrame = 0;
+    hEncoder->codeFrameNum = 0;
+
+    for (channel = 0; channel < hEncoder->numChannels; channel++)
+    {
+        CoderInfo *coderInfo = &hEncoder->coderInfo[channel];
+
+        coderInfo->prev_window_shape = SINE_WINDOW;
+        coderInfo->window_shape = SINE_WINDOW;
+        coderInfo->block_type = ONLY_LONG_WINDOW;
+        coderInfo->desired_block_type = ONLY_LONG_WINDOW;
+        coderInfo->groups.n = 1;
+        coderInfo->groups.len[0] = 1;
+
+        SetMemory(hEncoder->sampleBuff[channel], 0, FRAME_LEN*sizeof(faac_real));
+        SetMemory(hEncoder->nextSampleBuff[channel], 0, FRAME_LEN*sizeof(faac_real));
+        SetMemory(hEncoder->next2SampleBuff[channel], 0, FRAME_LEN*sizeof(faac_real));
+        SetMemory(hEncoder->next3SampleBuff[channel], 0, FRAME_LEN*sizeof(faac_real));
+        if (hEncoder->spareSampleBuff[channel])
+            SetMemory(hEncoder->spareSampleBuff[channel], 0, FRAME_LEN*sizeof(faac_real));
+
+        SetMemory(hEncoder->overlapBuff[channel], 0, FRAME_LEN*sizeof(faac_real));
+    }
+
+    hEncoder->psymodel->PsyReset(&hEncoder->gpsyInfo, hEncoder->psyInfo, hEncoder->numChannels);
+
+    /* rate control starts over */
+    hEncoder->aacquantCfg.quality = hEncoder->config.quantqual;
+#ifdef DRM
+    hEncoder->rateScale = 0;
+#endif
+
+    for (channel = 0; channel < hEncoder->ladderRungs; channel++)
+        faacEncReset(hEncoder->ladder[channel]);
+
+    return 1;
+}
+
 int FAACAPI faacEncClose(faacEncHandle hpEncoder)
 {
     faacEncStruct* hEncoder = (faacEncStruct*)hpEncoder;
     unsigned int channel;
 
+    PoolDestroy(hEncoder->pipe);
+    PoolDestroy(hEncoder->pool);
+
     /* Deinitialize coder functions */
     hEncoder->psymodel->PsyEnd(&hEncoder->gpsyInfo, hEncoder->psyInfo, hEncoder->numChannels);
 
     FilterBankEnd(hEncoder);
 
-    fft_terminate(&hEncoder->fft_tables);
+    TablesRelease(hEncoder->tables);
 
     /* Free remaining buffer memory */
     for (channel = 0; channel < hEncoder->numChannels; channel++)
@@ -347,7 +837,14 @@ int FAACAPI faacEncClose(faacEncHandle hpEncoder)
 			FreeMemory (hEncoder->next2SampleBuff[channel]);
 		if (hEncoder->next3SampleBuff[channel])
 			FreeMemory (hEncoder->next3SampleBuff[channel]);
+		if (hEncoder->spareSampleBuff[channel])
+			FreeMemory (hEncoder->spareSampleBuff[channel]);
     }
+    if (hEncoder->codeBuffer)
+        FreeMemory(hEncoder->codeBuffer);
+    if (hEncoder->ladder)
+        FreeMemory(hEncoder->ladder);
+    FreeChannels(hEncoder);
 
     /* Free handle */
     if (hEncoder)
@@ -358,73 +855,57 @@ int FAACAPI faacEncClose(faacEncHandle hpEncoder)
     return 0;
 }
 
-int FAACAPI faacEncEncode(faacEncHandle hpEncoder,
-                          int32_t *inputBuffer,
-                          unsigned int samplesInput,
-                          unsigned char *outputBuffer,
-                          unsigned int bufferSize
-                          )
+/* Load one frame of input for every channel into next3SampleBuff.
+   Either inputBuffer (interleaved, in config.inputFormat) or planarInput
+   (one float array per channel) is used. */
+static int LoadInput(faacEncStruct *hEncoder,
+                     int32_t *inputBuffer,
+                     const float *const *planarInput,
+                     unsigned int samplesPerChannel)
 {
-    faacEncStruct* hEncoder = (faacEncStruct*)hpEncoder;
-    unsigned int channel, i;
-    int sb, frameBytes;
-    unsigned int offset;
-    BitStream *bitStream; /* bitstream used for writing the frame to */
-#ifdef DRM
-    int desbits, diff;
-    double fix;
-#endif
-
-    /* local copy's of parameters */
-    ChannelInfo *channelInfo = hEncoder->channelInfo;
-    CoderInfo *coderInfo = hEncoder->coderInfo;
     unsigned int numChannels = hEncoder->numChannels;
-    unsigned int useLfe = hEncoder->config.useLfe;
-    unsigned int useTns = hEncoder->config.useTns;
-    unsigned int jointmode = hEncoder->config.jointmode;
-    unsigned int bandWidth = hEncoder->config.bandWidth;
-    unsigned int shortctl = hEncoder->config.shortctl;
-    int maxqual = hEncoder->config.outputFormat ? MAXQUALADTS : MAXQUAL;
-
-    /* Increase frame number */
-    hEncoder->frameNum++;
-
-    if (samplesInput == 0)
-        hEncoder->flushFrame++;
-
-    /* After 4 flush frames all samples have been encoded,
-       return 0 bytes written */
-    if (hEncoder->flushFrame > 4)
-        return 0;
-
-    /* Determine the channel configuration */
-    GetChannelInfo(channelInfo, numChannels, useLfe);
+    unsigned int channel, i;
 
-    /* Update current sample buffers */
     for (channel = 0; channel < numChannels; channel++)
 	{
-		double *tmp;
-
-
-		if (!hEncoder->sampleBuff[channel])
-			hEncoder->sampleBuff[channel] = (double*)AllocMemory(FRAME_LEN*sizeof(double));
+		faac_real *tmp;
 
 		tmp = hEncoder->sampleBuff[channel];
 
         hEncoder->sampleBuff[channel]		= hEncoder->nextSampleBuff[channel];
         hEncoder->nextSampleBuff[channel]	= hEncoder->next2SampleBuff[channel];
         hEncoder->next2SampleBuff[channel]	= hEncoder->next3SampleBuff[channel];
-		hEncoder->next3SampleBuff[channel]	= tmp;
+		/* in pipelined mode the oldest buffer may still be filtered,
+		   fill the spare one instead */
+		if (hEncoder->spareSampleBuff[channel])
+		{
+			hEncoder->next3SampleBuff[channel] = hEncoder->spareSampleBuff[channel];
+			hEncoder->spareSampleBuff[channel] = tmp;
+		}
+		else
+			hEncoder->next3SampleBuff[channel]	= tmp;
 
-        if (samplesInput == 0)
+        if (samplesPerChannel == 0)
         {
             /* start flushing*/
-            for (i = 0; i < FRAME_LEN; i++)
+            for (i = 0; i < hEncoder->frameLen; i++)
                 hEncoder->next3SampleBuff[channel][i] = 0.0;
         }
+        else if (planarInput)
+        {
+            /* channel remapping is done by picking the source array */
+            const float *input_channel = planarInput[hEncoder->config.channel_map[channel]];
+            faac_real *output = hEncoder->next3SampleBuff[channel];
+
+            for (i = 0; i < samplesPerChannel; i++)
+                output[i] = input_channel[i];
+
+            for (; i < hEncoder->frameLen; i++)
+                output[i] = 0.0;
+        }
         else
         {
-			int samples_per_channel = samplesInput/numChannels;
+			int samples_per_channel = samplesPerChannel;
 
             /* handle the various input formats and channel remapping */
             switch( hEncoder->config.inputFormat )
@@ -435,7 +916,7 @@ int FAACAPI faacEncEncode(faacEncHandle hpEncoder,
 
 						for (i = 0; i < samples_per_channel; i++)
 						{
-							hEncoder->next3SampleBuff[channel][i] = (double)*input_channel;
+							hEncoder->next3SampleBuff[channel][i] = (faac_real)*input_channel;
 							input_channel += numChannels;
 						}
 					}
@@ -459,7 +940,7 @@ int FAACAPI faacEncEncode(faacEncHandle hpEncoder,
 
 						for (i = 0; i < samples_per_channel; i++)
 						{
-							hEncoder->next3SampleBuff[channel][i] = (double)*input_channel;
+							hEncoder->next3SampleBuff[channel][i] = (faac_real)*input_channel;
 							input_channel += numChannels;
 						}
 					}
@@ -470,153 +951,269 @@ int FAACAPI faacEncEncode(faacEncHandle hpEncoder,
                     break;
             }
 
-            for (i = (int)(samplesInput/numChannels); i < FRAME_LEN; i++)
+            for (i = samplesPerChannel; i < hEncoder->frameLen; i++)
                 hEncoder->next3SampleBuff[channel][i] = 0.0;
 		}
+    }
 
-		/* Psychoacoustics */
+    return 0;
+}
+
+/* The per channel stages of a frame run as one job per channel element
+   (SCE, CPE or LFE). A job only touches the state of its own channels,
+   so the result does not depend on how jobs are scheduled. */
+
+/* one past the last channel of an element */
+static unsigned int ElementEnd(faacEncStruct *hEncoder, int index)
+{
+    unsigned int channel = hEncoder->element[index];
+
+    return channel + (hEncoder->channelInfo[channel].cpe ? 2 : 1);
+}
+
+static void PsyJob(void *arg, int index)
+{
+    faacEncStruct *hEncoder = (faacEncStruct *)arg;
+    ChannelInfo *channelInfo = hEncoder->channelInfo;
+    unsigned int channel = hEncoder->element[index];
+    unsigned int end = ElementEnd(hEncoder, index);
+
+    for (; channel < end; channel++)
+    {
 		/* Update buffers and run FFT on new samples */
 		/* LFE psychoacoustic can run without it */
 		if (!channelInfo[channel].lfe || channelInfo[channel].cpe)
-		{
 			hEncoder->psymodel->PsyBufferUpdate(
-					&hEncoder->fft_tables,
+					hEncoder->mdctInfo,
 					&hEncoder->gpsyInfo,
 					&hEncoder->psyInfo[channel],
 					hEncoder->next3SampleBuff[channel],
-					bandWidth,
+					hEncoder->config.bandWidth,
 					hEncoder->srInfo->cb_width_short,
 					hEncoder->srInfo->num_cb_short);
-		}
     }
+}
 
-    if (hEncoder->frameNum <= 3) /* Still filling up the buffers */
-        return 0;
+/* Filterbank of a channel, MDCT with overlap and add into freqBuff */
+static void Transform(faacEncStruct *hEncoder, unsigned int channel)
+{
+    FilterBank(hEncoder,
+        &hEncoder->coderInfo[channel],
+        hEncoder->codeSampleBuff[channel],
+        hEncoder->freqBuff[channel],
+        hEncoder->overlapBuff[channel],
+        MOVERLAPPED);
+}
 
-    /* Psychoacoustics */
-    hEncoder->psymodel->PsyCalculate(channelInfo, &hEncoder->gpsyInfo, hEncoder->psyInfo,
-        hEncoder->srInfo->cb_width_long, hEncoder->srInfo->num_cb_long,
-        hEncoder->srInfo->cb_width_short,
-        hEncoder->srInfo->num_cb_short, numChannels, (double)hEncoder->aacquantCfg.quality / DEFQUAL);
+/* Scalefactor bands, window groups and TNS of the spectrum in freqBuff */
+static void SpectrumBands(faacEncStruct *hEncoder, unsigned int channel)
+{
+    ChannelInfo *channelInfo = hEncoder->channelInfo;
+    CoderInfo *coderInfo = hEncoder->coderInfo;
+    unsigned int offset;
+    int sb;
 
-    hEncoder->psymodel->BlockSwitch(coderInfo, hEncoder->psyInfo, numChannels);
+    channelInfo[channel].msInfo.is_present = 0;
 
-    /* force block type */
-    if (shortctl == SHORTCTL_NOSHORT)
-    {
-		for (channel = 0; channel < numChannels; channel++)
-		{
-			coderInfo[channel].block_type = ONLY_LONG_WINDOW;
-		}
+    if (coderInfo[channel].block_type == ONLY_SHORT_WINDOW) {
+        coderInfo[channel].sfbn = hEncoder->aacquantCfg.max_cbs;
+
+        offset = 0;
+        for (sb = 0; sb < coderInfo[channel].sfbn; sb++) {
+            coderInfo[channel].sfb_offset[sb] = offset;
+            offset += hEncoder->srInfo->cb_width_short[sb];
+        }
+        coderInfo[channel].sfb_offset[sb] = offset;
+        BlocGroup(hEncoder->freqBuff[channel], coderInfo + channel, &hEncoder->aacquantCfg);
+    } else {
+        coderInfo[channel].sfbn = hEncoder->aacquantCfg.max_cbl;
+
+        coderInfo[channel].groups.n = 1;
+        coderInfo[channel].groups.len[0] = 1;
+
+        offset = 0;
+        for (sb = 0; sb < coderInfo[channel].sfbn; sb++) {
+            coderInfo[channel].sfb_offset[sb] = offset;
+            offset += hEncoder->srInfo->cb_width_long[sb];
+        }
+        coderInfo[channel].sfb_offset[sb] = offset;
     }
-    else if ((hEncoder->frameNum <= 4) || (shortctl == SHORTCTL_NOLONG))
-    {
-		for (channel = 0; channel < numChannels; channel++)
-		{
-			coderInfo[channel].block_type = ONLY_SHORT_WINDOW;
-		}
+
+    /* Perform TNS analysis and filtering */
+    if ((!channelInfo[channel].lfe) && (hEncoder->config.useTns)) {
+        TnsEncode(&(coderInfo[channel].tnsInfo),
+                  coderInfo[channel].sfbn,
+                  coderInfo[channel].sfbn,
+                  coderInfo[channel].block_type,
+                  coderInfo[channel].sfb_offset,
+                  hEncoder->freqBuff[channel]);
+    } else {
+        coderInfo[channel].tnsInfo.tnsDataPresent = 0;      /* TNS not used for LFE */
     }
 
-    /* AAC Filterbank, MDCT with overlap and add */
-    for (channel = 0; channel < numChannels; channel++) {
-        FilterBank(hEncoder,
-            &coderInfo[channel],
-            hEncoder->sampleBuff[channel],
-            hEncoder->freqBuff[channel],
-            hEncoder->overlapBuff[channel],
-            MOVERLAPPED);
+    // reduce LFE bandwidth
+    if (!channelInfo[channel].cpe && channelInfo[channel].lfe)
+    {
+        coderInfo[channel].sfbn = 3;
     }
+}
 
-    for (channel = 0; channel < numChannels; channel++) {
-        channelInfo[channel].msInfo.is_present = 0;
+static void SpectrumJob(void *arg, int index)
+{
+    faacEncStruct *hEncoder = (faacEncStruct *)arg;
+    unsigned int channel = hEncoder->element[index];
+    unsigned int end = ElementEnd(hEncoder, index);
 
-        if (coderInfo[channel].block_type == ONLY_SHORT_WINDOW) {
-            coderInfo[channel].sfbn = hEncoder->aacquantCfg.max_cbs;
+    for (; channel < end; channel++)
+    {
+        Transform(hEncoder, channel);
+        SpectrumBands(hEncoder, channel);
+    }
+}
 
-            offset = 0;
-            for (sb = 0; sb < coderInfo[channel].sfbn; sb++) {
-                coderInfo[channel].sfb_offset[sb] = offset;
-                offset += hEncoder->srInfo->cb_width_short[sb];
-            }
-            coderInfo[channel].sfb_offset[sb] = offset;
-            BlocGroup(hEncoder->freqBuff[channel], coderInfo + channel, &hEncoder->aacquantCfg);
-        } else {
-            coderInfo[channel].sfbn = hEncoder->aacquantCfg.max_cbl;
+/* Ladder encoding: the rungs get a copy of the spectrum and the block
+   type before TNS and stereo coding change it */
+static void LadderSpectrumJob(void *arg, int index)
+{
+    faacEncStruct *hEncoder = (faacEncStruct *)arg;
+    unsigned int channel = hEncoder->element[index];
+    unsigned int end = ElementEnd(hEncoder, index);
+    unsigned int i;
 
-            coderInfo[channel].groups.n = 1;
-            coderInfo[channel].groups.len[0] = 1;
+    for (; channel < end; channel++)
+    {
+        CoderInfo *coderInfo = &hEncoder->coderInfo[channel];
 
-            offset = 0;
-            for (sb = 0; sb < coderInfo[channel].sfbn; sb++) {
-                coderInfo[channel].sfb_offset[sb] = offset;
-                offset += hEncoder->srInfo->cb_width_long[sb];
-            }
-            coderInfo[channel].sfb_offset[sb] = offset;
+        Transform(hEncoder, channel);
+
+        for (i = 0; i < hEncoder->ladderRungs; i++)
+        {
+            faacEncStruct *rung = hEncoder->ladder[i];
+            CoderInfo *rungInfo = &rung->coderInfo[channel];
+
+            memcpy(rung->freqBuff[channel], hEncoder->freqBuff[channel],
+                   hEncoder->frameLen * sizeof(faac_real));
+            rungInfo->block_type = coderInfo->block_type;
+            rungInfo->window_shape = coderInfo->window_shape;
+            rungInfo->prev_window_shape = coderInfo->prev_window_shape;
+            SpectrumBands(rung, channel);
         }
-    }
 
-    /* Perform TNS analysis and filtering */
-    for (channel = 0; channel < numChannels; channel++) {
-        if ((!channelInfo[channel].lfe) && (useTns)) {
-            TnsEncode(&(coderInfo[channel].tnsInfo),
-                      coderInfo[channel].sfbn,
-                      coderInfo[channel].sfbn,
-                      coderInfo[channel].block_type,
-                      coderInfo[channel].sfb_offset,
-                      hEncoder->freqBuff[channel]);
-        } else {
-            coderInfo[channel].tnsInfo.tnsDataPresent = 0;      /* TNS not used for LFE */
-        }
-    }
-
-    for (channel = 0; channel < numChannels; channel++) {
-      // reduce LFE bandwidth
-		if (!channelInfo[channel].cpe && channelInfo[channel].lfe)
-		{
-                    coderInfo[channel].sfbn = 3;
-		}
-	}
+        SpectrumBands(hEncoder, channel);
+    }
+}
 
-    AACstereo(coderInfo, channelInfo, hEncoder->freqBuff, numChannels,
-              (double)hEncoder->aacquantCfg.quality/DEFQUAL, jointmode);
+static void QuantJob(void *arg, int index)
+{
+    faacEncStruct *hEncoder = (faacEncStruct *)arg;
+    unsigned int channel = hEncoder->element[index];
+    unsigned int end = ElementEnd(hEncoder, index);
 
-#ifdef DRM
-    /* loop the quantization until the desired bit-rate is reached */
-    diff = 1; /* to enter while loop */
-    hEncoder->aacquantCfg.quality = 120; /* init quality setting */
-    while (diff > 0) { /* if too many bits, do it again */
-#endif
-    for (channel = 0; channel < numChannels; channel++) {
-        BlocQuant(&coderInfo[channel], hEncoder->freqBuff[channel],
+    for (; channel < end; channel++)
+    {
+        BlocQuant(&hEncoder->coderInfo[channel], hEncoder->freqBuff[channel],
                   &(hEncoder->aacquantCfg));
     }
+}
 
+/* Stereo coding, quantization and bitstream of the spectrum in freqBuff */
+static int CodeSpectrum(faacEncStruct *hEncoder,
+                        unsigned char *outputBuffer,
+                        unsigned int bufferSize)
+{
+    unsigned int channel;
+    int frameBytes;
+    BitStream bitStream; /* bitstream used for writing the frame to */
 #ifdef DRM
-    /* Write the AAC bitstream */
-    bitStream = OpenBitStream(bufferSize, outputBuffer);
-    WriteBitstream(hEncoder, coderInfo, channelInfo, bitStream, numChannels);
+    int desbits, bits, pass;
+    double quality, lastQuality, fitQuality = 0;
+    BlocLevels levels;
+#endif
 
-    /* Close the bitstream and return the number of bytes written */
-    frameBytes = CloseBitStream(bitStream);
+    /* local copy's of parameters */
+    ChannelInfo *channelInfo = hEncoder->channelInfo;
+    CoderInfo *coderInfo = hEncoder->coderInfo;
+    unsigned int numChannels = hEncoder->numChannels;
+    unsigned int jointmode = hEncoder->config.jointmode;
+    int maxqual = hEncoder->config.outputFormat ? MAXQUALADTS : MAXQUAL;
+
+    AACstereo(coderInfo, channelInfo, hEncoder->freqBuff, numChannels,
+              (double)hEncoder->aacquantCfg.quality/DEFQUAL, jointmode,
+              hEncoder->frameLen / MAX_SHORT_WINDOWS);
 
-    /* now calculate desired bits and compare with actual encoded bits */
-    desbits = (int) ((double) numChannels * (hEncoder->config.bitRate * FRAME_LEN)
+#ifdef DRM
+    /* Quantize until the frame fits the bitrate. The quality of every
+       pass is predicted from the levels of the bands, scaled by the bits
+       of the pass before, or of the last frame for the first pass. A
+       frame that fits with much room is coded once more at a higher
+       quality. */
+    desbits = (int) ((double) numChannels * (hEncoder->config.bitRate * hEncoder->frameLen)
             / hEncoder->sampleRate);
 
-    diff = ((frameBytes - 1 /* CRC */) * 8) - desbits;
+    SetMemory(&levels, 0, sizeof(levels));
+    for (channel = 0; channel < numChannels; channel++)
+    {
+        if (channelInfo[channel].present)
+            BlocLevel(&coderInfo[channel], hEncoder->freqBuff[channel],
+                      &hEncoder->aacquantCfg, &levels);
+        BlocSave(&coderInfo[channel]);
+    }
+
+    quality = DRMMAXQUAL;
+    if (hEncoder->rateScale)
+        quality = RateQuality(&levels, hEncoder->rateScale, desbits * RATEFILL);
 
-    /* do linear correction according to relative difference */
-    fix = (double) desbits / ((frameBytes - 1 /* CRC */) * 8);
+    for (pass = 1;; pass++)
+    {
+        double est;
 
-    /* speed up convergence. A value of 0.92 gives approx up to 10 iterations */
-    if (fix > 0.92)
-        fix = 0.92;
+        if (pass > 1)
+        {
+            for (channel = 0; channel < numChannels; channel++)
+                BlocRestore(&coderInfo[channel]);
+        }
+        hEncoder->aacquantCfg.quality = quality;
+#endif
+    PoolRun(hEncoder->pool, QuantJob, hEncoder, hEncoder->numElements);
 
-    hEncoder->aacquantCfg.quality *= fix;
+#ifdef DRM
+    /* Write the AAC bitstream */
+    OpenBitStream(&bitStream, bufferSize, outputBuffer);
+    WriteBitstream(hEncoder, coderInfo, channelInfo, &bitStream, numChannels);
 
-    /* quality should not go lower than 1, set diff to exit loop */
-    if (hEncoder->aacquantCfg.quality <= 1)
-        diff = -1;
+    /* Close the bitstream and return the number of bytes written */
+    frameBytes = CloseBitStream(&bitStream);
+    bits = (frameBytes - 1 /* CRC */) * 8;
+
+    est = BlocBits(&levels, quality);
+    if (est > 0)
+        hEncoder->rateScale = bits / est;
+
+    if (bits <= desbits)
+    {
+        /* good enough, or the best fitting quality coded again */
+        if (pass > 1 || quality >= DRMMAXQUAL || bits >= desbits * RATEMINFILL
+            || est <= 0)
+            break;
+        fitQuality = quality;
+        quality = RateQuality(&levels, hEncoder->rateScale, desbits * RATEFILL);
+        continue;
+    }
+
+    /* quality should not go lower than 1 */
+    if (quality <= 1)
+        break;
+
+    lastQuality = quality;
+    if (est > 0)
+        quality = RateQuality(&levels, hEncoder->rateScale, desbits * RATEFILL);
+    /* at least a small step down, so the loop ends */
+    if (quality > lastQuality * 0.98)
+        quality = lastQuality * 0.98;
+    if (quality < fitQuality)
+        quality = fitQuality;
+    if (quality < 1)
+        quality = 1;
     }
 #endif
 
@@ -637,18 +1234,18 @@ int FAACAPI faacEncEncode(faacEncHandle hpEncoder,
     }
 #ifndef DRM
     /* Write the AAC bitstream */
-    bitStream = OpenBitStream(bufferSize, outputBuffer);
+    OpenBitStream(&bitStream, bufferSize, outputBuffer);
 
-    if (WriteBitstream(hEncoder, coderInfo, channelInfo, bitStream, numChannels) < 0)
+    if (WriteBitstream(hEncoder, coderInfo, channelInfo, &bitStream, numChannels) < 0)
         return -1;
 
     /* Close the bitstream and return the number of bytes written */
-    frameBytes = CloseBitStream(bitStream);
+    frameBytes = CloseBitStream(&bitStream);
 
     /* Adjust quality to get correct average bitrate */
     if (hEncoder->config.bitRate)
     {
-        int desbits = numChannels * (hEncoder->config.bitRate * FRAME_LEN)
+        int desbits = numChannels * (hEncoder->config.bitRate * hEncoder->frameLen)
             / hEncoder->sampleRate;
         double fix = (double)desbits / (double)(frameBytes * 8);
 
@@ -674,12 +1271,261 @@ int FAACAPI faacEncEncode(faacEncHandle hpEncoder,
     return frameBytes;
 }
 
+/* Filterbank, quantization and bitstream of frame codeFrameNum */
+static int CodeFrame(faacEncStruct *hEncoder,
+                     unsigned char *outputBuffer,
+                     unsigned int bufferSize)
+{
+    /* Filterbank and TNS */
+    PoolRun(hEncoder->pool, SpectrumJob, hEncoder, hEncoder->numElements);
+
+    return CodeSpectrum(hEncoder, outputBuffer, bufferSize);
+}
+
+/* CodeFrame() for hEncoder and all rungs of its ladder */
+static int CodeLadder(faacEncStruct *hEncoder,
+                      unsigned char *outputBuffer,
+                      unsigned int bufferSize)
+{
+    unsigned int i;
+
+    for (i = 0; i < hEncoder->ladderRungs; i++)
+    {
+        faacEncStruct *rung = hEncoder->ladder[i];
+
+        SetupChannels(rung);
+        rung->frameNum = hEncoder->frameNum;
+        rung->codeFrameNum = hEncoder->codeFrameNum;
+        rung->lookahead = hEncoder->lookahead;
+    }
+
+    PoolRun(hEncoder->pool, LadderSpectrumJob, hEncoder, hEncoder->numElements);
+
+    for (i = 0; i < hEncoder->ladderRungs; i++)
+    {
+        faacEncStruct *rung = hEncoder->ladder[i];
+
+        hEncoder->ladderBytes[i] = CodeSpectrum(rung, hEncoder->ladderBuffer[i],
+                                                hEncoder->ladderSize[i]);
+        if (hEncoder->ladderBytes[i] < 0)
+            return -1;
+    }
+
+    return CodeSpectrum(hEncoder, outputBuffer, bufferSize);
+}
+
+/* coding stage of a pipelined frame */
+static void CodeJob(void *arg, int index)
+{
+    faacEncStruct *hEncoder = (faacEncStruct *)arg;
+
+    (void)index;
+    hEncoder->codeBytes = CodeFrame(hEncoder, hEncoder->codeBuffer, ADTS_FRAMESIZE + 1);
+}
+
+static int EncodeFrame(faacEncStruct *hEncoder,
+                       int32_t *inputBuffer,
+                       const float *const *planarInput,
+                       unsigned int samplesPerChannel,
+                       unsigned char *outputBuffer,
+                       unsigned int bufferSize)
+{
+    unsigned int channel;
+    int frameBytes = 0;
+
+    /* local copy's of parameters */
+    CoderInfo *coderInfo = hEncoder->coderInfo;
+    unsigned int numChannels = hEncoder->numChannels;
+    unsigned int shortctl = hEncoder->config.shortctl;
+
+    if (samplesPerChannel > hEncoder->frameLen)
+        return -1;
+
+    if (!hEncoder->frameNum)
+    {
+        hEncoder->lookahead = Lookahead(hEncoder);
+        hEncoder->gpsyInfo.lowDelay = (hEncoder->lookahead == 1);
+    }
+
+    /* Increase frame number */
+    hEncoder->frameNum++;
+
+    if (samplesPerChannel == 0)
+        hEncoder->flushFrame++;
+
+    /* After lookahead + 1 flush frames all samples have been encoded,
+       only a pipelined frame can be left */
+    if (hEncoder->flushFrame <= hEncoder->lookahead + 1)
+    {
+        /* Update current sample buffers */
+        if (LoadInput(hEncoder, inputBuffer, planarInput, samplesPerChannel) < 0)
+            return -1;
+
+        /* Psychoacoustics, on this thread if the pool is busy with the
+           pipelined frame. LD has no block switching to decide. */
+        if (hEncoder->config.aacObjectType != LD)
+            PoolRun(hEncoder->pipe ? NULL : hEncoder->pool, PsyJob, hEncoder,
+                    hEncoder->numElements);
+    }
+
+    /* Return the pipelined frame */
+    if (hEncoder->pipe)
+    {
+        PoolWait(hEncoder->pipe);
+        if (hEncoder->codePending)
+        {
+            hEncoder->codePending = 0;
+            frameBytes = hEncoder->codeBytes;
+            if (frameBytes > (int)bufferSize)
+                frameBytes = -1;
+            else if (frameBytes > 0)
+                memcpy(outputBuffer, hEncoder->codeBuffer, frameBytes);
+        }
+    }
+
+    if (hEncoder->flushFrame > hEncoder->lookahead + 1)
+        return frameBytes;
+    if (hEncoder->frameNum <= hEncoder->lookahead) /* Still filling up the buffers */
+        return frameBytes;
+
+    /* Determine the channel configuration */
+    SetupChannels(hEncoder);
+
+    /* Psychoacoustics, there is nothing to decide without lookahead */
+    if (hEncoder->lookahead)
+    {
+        hEncoder->psymodel->PsyCalculate(hEncoder->channelInfo, &hEncoder->gpsyInfo, hEncoder->psyInfo,
+            hEncoder->srInfo->cb_width_long, hEncoder->srInfo->num_cb_long,
+            hEncoder->srInfo->cb_width_short,
+            hEncoder->srInfo->num_cb_short, numChannels, (double)hEncoder->aacquantCfg.quality / DEFQUAL);
+
+        hEncoder->psymodel->BlockSwitch(coderInfo, hEncoder->psyInfo, numChannels);
+    }
+
+    /* force block type */
+    if (shortctl == SHORTCTL_NOSHORT
+        || (!hEncoder->lookahead && shortctl != SHORTCTL_NOLONG))
+    {
+		for (channel = 0; channel < numChannels; channel++)
+		{
+			coderInfo[channel].block_type = ONLY_LONG_WINDOW;
+		}
+    }
+    else if ((hEncoder->frameNum <= hEncoder->lookahead + 1) || (shortctl == SHORTCTL_NOLONG))
+    {
+		for (channel = 0; channel < numChannels; channel++)
+		{
+			coderInfo[channel].block_type = ONLY_SHORT_WINDOW;
+		}
+    }
+
+    /* Hand the frame to the coding stage */
+    hEncoder->codeFrameNum = hEncoder->frameNum;
+    for (channel = 0; channel < numChannels; channel++)
+    {
+        switch (hEncoder->lookahead)
+        {
+        case 0:
+            hEncoder->codeSampleBuff[channel] = hEncoder->next3SampleBuff[channel];
+            break;
+        case 1:
+            hEncoder->codeSampleBuff[channel] = hEncoder->next2SampleBuff[channel];
+            break;
+        default:
+            hEncoder->codeSampleBuff[channel] = hEncoder->sampleBuff[channel];
+            break;
+        }
+    }
+
+    if (hEncoder->pipe)
+    {
+        hEncoder->codePending = 1;
+        PoolPost(hEncoder->pipe, CodeJob, hEncoder, 1);
+        return frameBytes;
+    }
+
+    if (hEncoder->ladderBuffer)
+        return CodeLadder(hEncoder, outputBuffer, bufferSize);
+
+    return CodeFrame(hEncoder, outputBuffer, bufferSize);
+}
+
+int FAACAPI faacEncEncode(faacEncHandle hpEncoder,
+                          int32_t *inputBuffer,
+                          unsigned int samplesInput,
+                          unsigned char *outputBuffer,
+                          unsigned int bufferSize
+                          )
+{
+    faacEncStruct* hEncoder = (faacEncStruct*)hpEncoder;
+
+    return EncodeFrame(hEncoder, inputBuffer, NULL,
+                       samplesInput / hEncoder->numChannels,
+                       outputBuffer, bufferSize);
+}
+
+int FAACAPI faacEncEncodeLadder(faacEncHandle hpEncoder,
+                                int32_t *inputBuffer,
+                                unsigned int samplesInput,
+                                unsigned char *outputBuffer,
+                                unsigned int bufferSize,
+                                unsigned char **rungBuffers,
+                                const unsigned int *rungBufferSizes,
+                                int *rungBytes
+                                )
+{
+    faacEncStruct* hEncoder = (faacEncStruct*)hpEncoder;
+    unsigned int i;
+    int frameBytes;
+
+    if (!hEncoder->ladderRungs)
+        return EncodeFrame(hEncoder, inputBuffer, NULL,
+                           samplesInput / hEncoder->numChannels,
+                           outputBuffer, bufferSize);
+
+    if (!rungBuffers || !rungBufferSizes || !rungBytes)
+        return -1;
+
+    /* the rungs return a frame whenever hEncoder does */
+    for (i = 0; i < hEncoder->ladderRungs; i++)
+        rungBytes[i] = 0;
+
+    hEncoder->ladderBuffer = rungBuffers;
+    hEncoder->ladderSize = rungBufferSizes;
+    hEncoder->ladderBytes = rungBytes;
+
+    frameBytes = EncodeFrame(hEncoder, inputBuffer, NULL,
+                             samplesInput / hEncoder->numChannels,
+                             outputBuffer, bufferSize);
+
+    hEncoder->ladderBuffer = NULL;
+    hEncoder->ladderSize = NULL;
+    hEncoder->ladderBytes = NULL;
+
+    return frameBytes;
+}
+
+int FAACAPI faacEncEncodePlanar(faacEncHandle hpEncoder,
+                                const float *const *channels,
+                                unsigned int samplesPerChannel,
+                                unsigned char *outputBuffer,
+                                unsigned int bufferSize
+                                )
+{
+    faacEncStruct* hEncoder = (faacEncStruct*)hpEncoder;
+
+    if (samplesPerChannel && !channels)
+        return -1;
+
+    return EncodeFrame(hEncoder, NULL, channels, samplesPerChannel,
+                       outputBuffer, bufferSize);
+}
+
 
-#ifdef DRM
 /* Scalefactorband data table for 960 transform length */
 /* all parameters which are different from the 1024 transform length table are
    marked with an "x" */
-static SR_INFO srInfo[12+1] =
+static SR_INFO srInfo960[12+1] =
 {
     { 96000, 40/*x*/, 12,
         {
@@ -782,7 +1628,7 @@ static SR_INFO srInfo[12+1] =
     },
     { -1 }
 };
-#else
+
 /* Scalefactorband data table for 1024 transform length */
 static SR_INFO srInfo[12+1] =
 {
@@ -887,4 +1733,76 @@ static SR_INFO srInfo[12+1] =
     },
     { -1 }
 };
+
+#ifndef DRM
+/* Scalefactorband data for the 512 sample AAC-LD transform, there are
+   tables for 48, 32 and 24 kHz only. There are no short blocks. */
+static SR_INFO srInfoLD[12+1] =
+{
+    { 96000, 0, 0 }, { 88200, 0, 0 }, { 64000, 0, 0 },
+    { 48000, 36, 0,
+        {
+            4,  4,  4,  4,  4,  4,  4,  4,  4,  4,  4,  4,  4,  4,  4,  8,  8,  8,
+            8,  8, 12, 12, 12, 12, 16, 20, 24, 28, 32, 32, 32, 32, 32, 32, 32, 52
+        }
+    }, { 44100, 36, 0,
+        {
+            4,  4,  4,  4,  4,  4,  4,  4,  4,  4,  4,  4,  4,  4,  4,  8,  8,  8,
+            8,  8, 12, 12, 12, 12, 16, 20, 24, 28, 32, 32, 32, 32, 32, 32, 32, 52
+        }
+    }, { 32000, 37, 0,
+        {
+            4,  4,  4,  4,  4,  4,  4,  4,  4,  4,  4,  4,  4,  4,  8,  8,  8,  8,
+            8, 12, 12, 12, 12, 16, 16, 16, 20, 24, 24, 28, 32, 32, 32, 32, 32, 32,
+            32
+        }
+    }, { 24000, 31, 0,
+        {
+            4,  4,  4,  4,  4,  4,  4,  4,  4,  4,  4,  8,  8,  8, 12, 12, 12, 16,
+            20, 24, 28, 32, 32, 32, 32, 32, 32, 32, 32, 32, 32
+        }
+    }, { 22050, 31, 0,
+        {
+            4,  4,  4,  4,  4,  4,  4,  4,  4,  4,  4,  8,  8,  8, 12, 12, 12, 16,
+            20, 24, 28, 32, 32, 32, 32, 32, 32, 32, 32, 32, 32
+        }
+    },
+    { 16000, 0, 0 }, { 12000, 0, 0 }, { 11025, 0, 0 }, { 8000, 0, 0 },
+    { -1 }
+};
+
+/* The same for the 480 sample transform */
+static SR_INFO srInfoLD480[12+1] =
+{
+    { 96000, 0, 0 }, { 88200, 0, 0 }, { 64000, 0, 0 },
+    { 48000, 35, 0,
+        {
+            4,  4,  4,  4,  4,  4,  4,  4,  4,  4,  4,  4,  4,  4,  8,  8,  8,  8,
+            8, 12, 12, 12, 12, 12, 16, 16, 24, 28, 32, 32, 32, 32, 32, 32, 48
+        }
+    }, { 44100, 35, 0,
+        {
+            4,  4,  4,  4,  4,  4,  4,  4,  4,  4,  4,  4,  4,  4,  8,  8,  8,  8,
+            8, 12, 12, 12, 12, 12, 16, 16, 24, 28, 32, 32, 32, 32, 32, 32, 48
+        }
+    }, { 32000, 37, 0,
+        {
+            4,  4,  4,  4,  4,  4,  4,  4,  4,  4,  4,  4,  4,  4,  4,  4,  8,  8,
+            8,  8,  8,  8, 12, 12, 12, 16, 16, 20, 24, 32, 32, 32, 32, 32, 32, 32,
+            32
+        }
+    }, { 24000, 30, 0,
+        {
+            4,  4,  4,  4,  4,  4,  4,  4,  4,  4,  4,  8,  8,  8, 12, 12, 12, 16,
+            20, 24, 28, 32, 32, 32, 32, 32, 32, 32, 32, 32
+        }
+    }, { 22050, 30, 0,
+        {
+            4,  4,  4,  4,  4,  4,  4,  4,  4,  4,  4,  8,  8,  8, 12, 12, 12, 16,
+            20, 24, 28, 32, 32, 32, 32, 32, 32, 32, 32, 32
+        }
+    },
+    { 16000, 0, 0 }, { 12000, 0, 0 }, { 11025, 0, 0 }, { 8000, 0, 0 },
+    { -1 }
+};
 #endif
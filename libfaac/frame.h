@@ -36,6 +36,9 @@ extern "C" {
 #include "blockswitch.h"
 #include "fft.h"
 #include "quantize.h"
+#include "mdct.h"
+#include "pool.h"
+#include "tables.h"
 
 #pragma pack(push, 1)
 
@@ -51,35 +54,45 @@ typedef struct {
 
     unsigned int usedBytes;
 
+    /* samples per channel in a frame, FRAME_LEN or 512 for LD, or 960
+       and 480 with frameLengthFlag; the sample buffers are FRAME_LEN long
+       either way */
+    unsigned int frameLen;
+    int frameLengthFlag;
+
     /* frame number */
     unsigned int frameNum;
     unsigned int flushFrame;
 
+    /* channel elements (SCE, CPE, LFE), by their first channel */
+    int numElements;
+    int element[MAX_CHANNELS];
+
     /* Scalefactorband data */
     SR_INFO *srInfo;
 
     /* sample buffers of current next and next next frame*/
-    double *sampleBuff[MAX_CHANNELS];
-    double *nextSampleBuff[MAX_CHANNELS];
-    double *next2SampleBuff[MAX_CHANNELS];
-    double *next3SampleBuff[MAX_CHANNELS];
-
-    /* Filterbank buffers */
-    double *sin_window_long;
-    double *sin_window_short;
-    double *kbd_window_long;
-    double *kbd_window_short;
-    double *freqBuff[MAX_CHANNELS];
-    double *overlapBuff[MAX_CHANNELS];
-
-    double *msSpectrum[MAX_CHANNELS];
-
-    /* Channel and Coder data for all channels */
-    CoderInfo coderInfo[MAX_CHANNELS];
-    ChannelInfo channelInfo[MAX_CHANNELS];
-
-    /* Psychoacoustics data */
-    PsyInfo psyInfo[MAX_CHANNELS];
+    faac_real *sampleBuff[MAX_CHANNELS];
+    faac_real *nextSampleBuff[MAX_CHANNELS];
+    faac_real *next2SampleBuff[MAX_CHANNELS];
+    faac_real *next3SampleBuff[MAX_CHANNELS];
+
+    /* Filterbank buffers, the windows are in the shared tables */
+    faac_real *sin_window_long;
+    faac_real *sin_window_short;
+    faac_real *kbd_window_long;
+    faac_real *kbd_window_short;
+    faac_real *freqBuff[MAX_CHANNELS];
+    faac_real *overlapBuff[MAX_CHANNELS];
+
+    faac_real *msSpectrum[MAX_CHANNELS];
+
+    /* Channel and Coder data, numChannels entries each */
+    CoderInfo *coderInfo;
+    ChannelInfo *channelInfo;
+
+    /* Psychoacoustics data, numChannels entries */
+    PsyInfo *psyInfo;
     GlobalPsyInfo gpsyInfo;
 
     /* Configuration data */
@@ -90,8 +103,51 @@ typedef struct {
     /* quantizer specific config */
     AACQuantCfg aacquantCfg;
 
+    /* tables shared with the other encoders of the process */
+    SharedTables *tables;
+
     /* FFT Tables */
-    FFT_Tables	fft_tables;
+    FFT_Tables	*fft_tables;
+
+    /* MDCT shared by filterbank and psychoacoustics */
+    MDCTInfo *mdctInfo;
+
+    /* worker threads for the channel elements, NULL when single threaded */
+    WorkerPool *pool;
+
+    /* Frame in the coding stage (filterbank to bitstream) and its
+       samples. Equal to frameNum and sampleBuff, except in pipelined
+       mode where the stage runs on pipe while the next frame is loaded
+       and analysed. */
+    unsigned int codeFrameNum;
+    faac_real *codeSampleBuff[MAX_CHANNELS];
+
+    /* pipelined mode only */
+    WorkerPool *pipe;
+    faac_real *spareSampleBuff[MAX_CHANNELS]; /* fifth input buffer */
+    unsigned char *codeBuffer;  /* bitstream of the coded frame */
+    int codeBytes;              /* its size, or -1 on error */
+    int codePending;            /* codeBuffer not returned yet */
+
+    /* Frames the coded frame lags behind the newest input: 3, 1 in low
+       delay mode, 0 in low delay mode without block switching. Fixed at
+       the first frame. */
+    int lowDelay;
+    unsigned int lookahead;
+
+#ifdef DRM
+    /* rate control: frame bits per BlocBits() of the last pass */
+    double rateScale;
+#endif
+
+    /* Ladder encoding: encoders coding the spectra of this one at other
+       rates, see faacEncSetLadder(). Their output buffers are set during
+       faacEncEncodeLadder() only. */
+    faacEncHandle *ladder;
+    unsigned int ladderRungs;
+    unsigned char **ladderBuffer;
+    const unsigned int *ladderSize;
+    int *ladderBytes;
 } faacEncStruct;
 
 #pragma pack(pop)
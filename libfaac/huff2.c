@@ -19,15 +19,12 @@
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <limits.h>
 #include "coder.h"
 #include "huffdata.h"
 #include "huff2.h"
 #include "bitstream.h"
 
-#ifdef DRM
-static int vcb11;
-#endif
-
 static int escape(int x, int *code)
 {
     int preflen = 0;
@@ -67,6 +64,8 @@ static int escape(int x, int *code)
 #endif
 
 #define arrlen(array) (sizeof(array) / sizeof(*array))
+/* trellis states of a book in huffsect(), one per bit of a count word */
+#define SECTSTATES 5
 
 static int huffcode(int *qs /* quantized spectrum */,
                     int len,
@@ -357,37 +356,37 @@ static int huffcode(int *qs /* quantized spectrum */,
         /* VCB11: check which codebook should be used using max escape sequence */
         /* 8.5.3.1.3, table 157 */
         if (maxesc <= 15)
-            vcb11 = 16;
+            coder->vcb11 = 16;
         else if (maxesc <= 31)
-            vcb11 = 17;
+            coder->vcb11 = 17;
         else if (maxesc <= 47)
-            vcb11 = 18;
+            coder->vcb11 = 18;
         else if (maxesc <= 63)
-            vcb11 = 19;
+            coder->vcb11 = 19;
         else if (maxesc <= 95)
-            vcb11 = 20;
+            coder->vcb11 = 20;
         else if (maxesc <= 127)
-            vcb11 = 21;
+            coder->vcb11 = 21;
         else if (maxesc <= 159)
-            vcb11 = 22;
+            coder->vcb11 = 22;
         else if (maxesc <= 191)
-            vcb11 = 23;
+            coder->vcb11 = 23;
         else if (maxesc <= 223)
-            vcb11 = 24;
+            coder->vcb11 = 24;
         else if (maxesc <= 255)
-            vcb11 = 25;
+            coder->vcb11 = 25;
         else if (maxesc <= 319)
-            vcb11 = 26;
+            coder->vcb11 = 26;
         else if (maxesc <= 383)
-            vcb11 = 27;
+            coder->vcb11 = 27;
         else if (maxesc <= 511)
-            vcb11 = 28;
+            coder->vcb11 = 28;
         else if (maxesc <= 767)
-            vcb11 = 29;
+            coder->vcb11 = 29;
         else if (maxesc <= 1023)
-            vcb11 = 30;
+            coder->vcb11 = 30;
         else if (maxesc <= 2047)
-            vcb11 = 31;
+            coder->vcb11 = 31;
         /* else: codebook 11 -> it is already 11 */
 #endif
         break;
@@ -403,13 +402,59 @@ static int huffcode(int *qs /* quantized spectrum */,
 }
 
 
+/* the packed lengths of the book pairs, by the first book */
+static const struct {
+    const uint32_t *len; /* centered packed lengths */
+    int dim, radix;
+} hpair[10] = {
+    {0}, {hlen0102 + 40, 4, 3}, {0}, {hlen0304 + 312, 4, 5}, {0},
+    {hlen0506 + 40, 2, 9}, {0}, {hlen0708 + 112, 2, 15}, {0},
+    {hlen0910 + 312, 2, 25}
+};
+
+/* bits of the band in both books of the pair starting at book, sign bits
+   included: the packed lengths of its codewords added up, the first
+   book's in the low 16 bits */
+static uint32_t huffbits(const int *qs, int len, int book)
+{
+    const uint32_t *tab = hpair[book].len;
+    int radix = hpair[book].radix;
+    uint32_t bits = 0;
+    int cnt;
+
+    if (hpair[book].dim == 4)
+    {
+        for (cnt = 0; cnt < len; cnt += 4)
+            bits += tab[((qs[cnt] * radix + qs[cnt + 1]) * radix
+                         + qs[cnt + 2]) * radix + qs[cnt + 3]];
+    }
+    else
+    {
+        for (cnt = 0; cnt < len; cnt += 2)
+            bits += tab[qs[cnt] * radix + qs[cnt + 1]];
+    }
+
+    return bits;
+}
+
+void huffsectinit(CoderInfo *coder, HuffSect *sect)
+{
+    int band;
+
+    sect->band0 = coder->bandcnt;
+    for (band = 0; band < coder->sfbn; band++)
+        sect->qs[band] = 0;
+}
+
 int huffbook(CoderInfo *coder,
+             HuffSect *sect,
              int *qs /* quantized spectrum */,
              int len)
 {
     int cnt;
     int maxq = 0;
-    int bookmin, lenmin;
+    int bookmin;
+    uint32_t bits;
 
     for (cnt = 0; cnt < len; cnt++)
     {
@@ -418,52 +463,194 @@ int huffbook(CoderInfo *coder,
             maxq = q;
     }
 
-#define BOOKMIN(n)bookmin=n;lenmin=huffcode(qs,len,bookmin,0);if(huffcode(qs,len,bookmin+1,0)<lenmin)bookmin++;
-
     if (maxq < 1)
-    {
         bookmin = HCB_ZERO;
-        lenmin = 0;
-    }
     else if (maxq < 2)
-    {
-        BOOKMIN(1);
-    }
+        bookmin = 1;
     else if (maxq < 3)
-    {
-        BOOKMIN(3);
-    }
+        bookmin = 3;
     else if (maxq < 5)
-    {
-        BOOKMIN(5);
-    }
+        bookmin = 5;
     else if (maxq < 8)
-    {
-        BOOKMIN(7);
-    }
+        bookmin = 7;
     else if (maxq < 13)
+        bookmin = 9;
+    else
+        bookmin = HCB_ESC;
+
+#ifndef DRM
+    /* the bits in every book the band fits, huffsect() chooses. Only the
+       bands that need it are coded in the escape book, BlocQuant() limits
+       the scalefactors of those. Their bits are the same in any section. */
+    if (bookmin > HCB_ZERO)
     {
-        BOOKMIN(9);
+        int band = coder->bandcnt - sect->band0;
+        int book;
+
+        for (book = 0; book < bookmin; book++)
+            sect->bits[band][book] = -1;
+        for (book = bookmin; book < HCB_ESC; book += 2)
+        {
+            bits = huffbits(qs, len, book);
+            sect->bits[band][book] = bits & 0xffff;
+            sect->bits[band][book + 1] = bits >> 16;
+        }
+        sect->bits[band][HCB_ESC] = (bookmin == HCB_ESC) ? 0 : -1;
+        sect->qs[band] = qs;
+        sect->len[band] = len;
     }
-    else
+#else
+    /* both books of the pair in one pass, the first one on a tie */
+    if (bookmin > HCB_ZERO && bookmin < HCB_ESC)
     {
-        bookmin = HCB_ESC;
+        bits = huffbits(qs, len, bookmin);
+        if ((bits >> 16) < (bits & 0xffff))
+            bookmin++;
     }
 
-#ifdef DRM
-    vcb11 = 0;
+    coder->vcb11 = 0;
     huffcode(qs, len, bookmin, coder);
-    if (vcb11)
-        bookmin = vcb11;
-#else
-    if (bookmin > HCB_ZERO)
-        huffcode(qs, len, bookmin, coder);
+    if (coder->vcb11)
+        bookmin = coder->vcb11;
 #endif
     coder->book[coder->bandcnt] = bookmin;
 
     return 0;
 }
 
+/* Choose the books of a window group for the fewest bits of section and
+   spectral data. Trellis over the bands: the states of book k are the
+   cheapest ways to code the bands so far with the last one in book k, its
+   section still open with a length of run modulo maxcnt, which sets when
+   the next count word is due. Only the states that can still lead to the
+   fewest bits are kept, cheapest first: each one costs less than a count
+   word over the first and is further from its next count word than the
+   cheaper ones. Bands not coded by huffbook() keep their book.
+   DRM keeps the book of every band, sections in its escape books have no
+   length. */
+void huffsect(CoderInfo *coder, HuffSect *sect)
+{
+#ifndef DRM
+    int *book = coder->book + sect->band0;
+    int cost[HCB_NONE][SECTSTATES], run[HCB_NONE][SECTSTATES], cnt[HCB_NONE];
+    /* state of the band before in the same book, -1 for a new section */
+    signed char from[NSFB_LONG][HCB_NONE][SECTSTATES];
+    int last[NSFB_LONG]; /* book of the cheapest state after the band */
+    int maxcnt = 31, cntbits = 5;
+    int band, k, s;
+
+    if (coder->block_type == ONLY_SHORT_WINDOW)
+    {
+        maxcnt = 7;
+        cntbits = 3;
+    }
+
+    for (k = 0; k < HCB_NONE; k++)
+        cnt[k] = 0;
+
+    for (band = 0; band < coder->sfbn; band++)
+    {
+        /* a new section starts after the cheapest band before */
+        int start = band ? cost[last[band - 1]][0] : 0;
+
+        last[band] = -1;
+        for (k = 0; k < HCB_NONE; k++)
+        {
+            int newcost[SECTSTATES + 1], newrun[SECTSTATES + 1], newfrom[SECTSTATES + 1];
+            int bits, n;
+
+            if (sect->qs[band])
+                bits = (k <= HCB_ESC) ? sect->bits[band][k] : -1;
+            else
+                bits = (k == book[band]) ? 0 : -1;
+
+            if (bits < 0)
+            {
+                cnt[k] = 0;
+                continue;
+            }
+
+            for (n = 0; n < cnt[k]; n++)
+            {
+                newrun[n] = (run[k][n] + 1) % maxcnt;
+                /* another count word every maxcnt bands */
+                newcost[n] = cost[k][n] + bits + (newrun[n] ? 0 : cntbits);
+                newfrom[n] = n;
+            }
+            newcost[n] = start + LEN_CB + cntbits + bits;
+            newrun[n] = 1;
+            newfrom[n] = -1;
+            n++;
+
+            /* mostly one section open, cheaper than a new one by a count
+               word at least */
+            if (n == 2 && newcost[0] + cntbits <= newcost[1])
+                n = 1;
+
+            /* the cheapest first, on a tie the one further from a count
+               word, then the longer section */
+            cnt[k] = 0;
+            while (n)
+            {
+                int i, min = 0;
+
+                for (i = 1; i < n; i++)
+                {
+                    if (newcost[i] != newcost[min])
+                    {
+                        if (newcost[i] < newcost[min])
+                            min = i;
+                    }
+                    else if (newrun[i] != newrun[min])
+                    {
+                        if (newrun[i] < newrun[min])
+                            min = i;
+                    }
+                    else if (newfrom[min] < 0)
+                        min = i;
+                }
+
+                if (!cnt[k] || (newcost[min] < cost[k][0] + cntbits &&
+                                newrun[min] < run[k][cnt[k] - 1]))
+                {
+                    cost[k][cnt[k]] = newcost[min];
+                    run[k][cnt[k]] = newrun[min];
+                    from[band][k][cnt[k]] = newfrom[min];
+                    cnt[k]++;
+                }
+
+                n--;
+                newcost[min] = newcost[n];
+                newrun[min] = newrun[n];
+                newfrom[min] = newfrom[n];
+            }
+
+            if (last[band] < 0 || cost[k][0] < cost[last[band]][0])
+                last[band] = k;
+        }
+    }
+
+    k = last[coder->sfbn - 1];
+    s = 0;
+    for (band = coder->sfbn - 1; band >= 0; band--)
+    {
+        book[band] = k;
+        s = from[band][k][s];
+        if (s < 0 && band)
+        {
+            k = last[band - 1];
+            s = 0;
+        }
+    }
+
+    for (band = 0; band < coder->sfbn; band++)
+    {
+        if (sect->qs[band])
+            huffcode(sect->qs[band], sect->len[band], book[band], coder);
+    }
+#endif
+}
+
 int writebooks(CoderInfo *coder, BitStream *stream, int write)
 {
     int bits = 0;
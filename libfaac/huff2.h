@@ -28,8 +28,21 @@ enum {
     HCB_NONE
 };
 
+/* the bands of a window group huffbook() has seen, the codewords are
+   written by huffsect() once the sections are chosen */
+typedef struct
+{
+    int band0;                          /* first band of the group */
+    int *qs[NSFB_LONG];                 /* quantized band, 0 if not coded */
+    int len[NSFB_LONG];
+    int bits[NSFB_LONG][HCB_ESC + 1];   /* bits in each book, -1 if unusable */
+} HuffSect;
+
+void huffsectinit(CoderInfo *coder, HuffSect *sect);
 int huffbook(CoderInfo *coderInfo,
-             int *qs /* quantized spectrum */,
+             HuffSect *sect,
+             int *qs /* quantized spectrum, kept until huffsect() */,
              int len);
+void huffsect(CoderInfo *coder, HuffSect *sect);
 int writebooks(CoderInfo *coder, BitStream *stream, int writeFlag);
 int writesf(CoderInfo *coder, BitStream *bitStream, int writeFlag);
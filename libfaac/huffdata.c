@@ -232,3 +232,230 @@ hcode32_t book12[121] = {
  {19,524275},
 };
 
+
+/* codeword lengths of two books, sign bits included, book n in the low and
+   book n + 1 in the high 16 bits; indexed by the signed values in base
+   2 * maxq + 1, the all zero codeword is in the middle */
+const uint32_t hlen0102[81] = {
+ 0x0009000b,0x00070009,0x0009000b,0x0008000a,0x00060007,0x0008000a,0x0009000b,0x00080009,
+ 0x0009000b,0x0008000a,0x00060007,0x0007000a,0x00060007,0x00050005,0x00060007,0x00070009,
+ 0x00060007,0x0008000a,0x0009000b,0x00070009,0x0008000b,0x00080009,0x00060007,0x00080009,
+ 0x0009000b,0x00070009,0x0009000b,0x00080009,0x00060007,0x00070009,0x00060007,0x00050005,
+ 0x00060007,0x00070009,0x00060007,0x00080009,0x00060007,0x00050005,0x00060007,0x00050005,
+ 0x00030001,0x00050005,0x00060007,0x00050005,0x00060007,0x00080009,0x00060007,0x00070009,
+ 0x00060007,0x00050005,0x00060007,0x00080009,0x00060007,0x00080009,0x0009000b,0x00070009,
+ 0x0009000b,0x00080009,0x00060007,0x00080009,0x0008000b,0x00070009,0x0009000b,0x0008000a,
+ 0x00060007,0x00070009,0x00060007,0x00040005,0x00060007,0x00080009,0x00060007,0x0007000a,
+ 0x0009000b,0x00070009,0x0009000b,0x0007000a,0x00060007,0x00080009,0x0009000b,0x00070009,
+ 0x0009000b,
+};
+
+const uint32_t hlen0304[625] = {
+ 0x000f0013,0x000e0010,0x000e000f,0x000e0010,0x000f0013,0x000f0013,0x000d000f,0x000d000d,
+ 0x000d000f,0x000f0013,0x000f0013,0x000d000f,0x000d000d,0x000d000f,0x000f0013,0x000f0013,
+ 0x000d000f,0x000d000d,0x000d000f,0x000f0013,0x000f0013,0x000e0010,0x000e000f,0x000e0010,
+ 0x000f0013,0x000f0013,0x000d0010,0x000d000f,0x000d0010,0x000f0013,0x000d0012,0x000b000e,
+ 0x000a000c,0x000b000e,0x000d0012,0x000d0011,0x000a000d,0x000a000a,0x000a000d,0x000d0011,
+ 0x000d0012,0x000b000e,0x000a000c,0x000b000e,0x000d0012,0x000f0013,0x000d0010,0x000d000f,
+ 0x000d0010,0x000f0013,0x000f0013,0x000d0011,0x000d000f,0x000d0011,0x000f0013,0x000d0012,
+ 0x000a000e,0x000a000b,0x000a000e,0x000d0012,0x000d0011,0x000a000c,0x00090009,0x000a000c,
+ 0x000d0011,0x000d0012,0x000a000e,0x000a000b,0x000a000e,0x000d0012,0x000f0013,0x000d0011,
+ 0x000d000f,0x000d0011,0x000f0013,0x000f0013,0x000d0010,0x000d000f,0x000d0010,0x000f0013,
+ 0x000d0012,0x000b000e,0x000a000c,0x000b000e,0x000d0012,0x000d0011,0x000a000d,0x000a000a,
+ 0x000a000d,0x000d0011,0x000d0012,0x000b000e,0x000a000c,0x000b000e,0x000d0012,0x000f0013,
+ 0x000d0010,0x000d000f,0x000d0010,0x000f0013,0x000f0013,0x000e0010,0x000e000f,0x000e0010,
+ 0x000f0013,0x000f0013,0x000d000f,0x000d000d,0x000d000f,0x000f0013,0x000f0013,0x000d000f,
+ 0x000d000d,0x000d000f,0x000f0013,0x000f0013,0x000d000f,0x000d000d,0x000d000f,0x000f0013,
+ 0x000f0013,0x000e0010,0x000e000f,0x000e0010,0x000f0013,0x000e0010,0x000d000f,0x000d000d,
+ 0x000d000f,0x000e0010,0x000d0010,0x000b000d,0x000a000b,0x000b000d,0x000d0010,0x000d0010,
+ 0x000b000d,0x000a000b,0x000b000d,0x000d0010,0x000d0010,0x000b000d,0x000a000b,0x000b000d,
+ 0x000d0010,0x000e0010,0x000d000f,0x000d000d,0x000d000f,0x000e0010,0x000d000f,0x000b000d,
+ 0x000b000c,0x000b000d,0x000d000f,0x000b000e,0x0008000b,0x00070009,0x0008000b,0x000b000e,
+ 0x000b000e,0x0007000a,0x00060007,0x0007000a,0x000b000e,0x000b000e,0x0008000b,0x00070009,
+ 0x0008000b,0x000b000e,0x000d000f,0x000b000d,0x000b000c,0x000b000d,0x000d000f,0x000d000f,
+ 0x000b000d,0x000a000c,0x000b000d,0x000d000f,0x000b000d,0x0007000a,0x00060008,0x0007000a,
+ 0x000b000d,0x000a000c,0x00070008,0x00050005,0x00070008,0x000a000c,0x000b000d,0x0007000a,
+ 0x00060008,0x0007000a,0x000b000d,0x000d000f,0x000b000d,0x000a000c,0x000b000d,0x000d000f,
+ 0x000d000f,0x000b000d,0x000b000c,0x000b000d,0x000d000f,0x000b000e,0x0008000b,0x00070009,
+ 0x0008000b,0x000b000e,0x000b000e,0x0007000a,0x00060007,0x0007000a,0x000b000e,0x000b000e,
+ 0x0008000b,0x00070009,0x0008000b,0x000b000e,0x000d000f,0x000b000d,0x000b000c,0x000b000d,
+ 0x000d000f,0x000e0010,0x000d000f,0x000d000d,0x000d000f,0x000e0010,0x000d0010,0x000b000d,
+ 0x000a000b,0x000b000d,0x000d0010,0x000d0010,0x000b000d,0x000a000b,0x000b000d,0x000d0010,
+ 0x000d0010,0x000b000d,0x000a000b,0x000b000d,0x000d0010,0x000e0010,0x000d000f,0x000d000d,
+ 0x000d000f,0x000e0010,0x000e000f,0x000d000d,0x000d000d,0x000d000d,0x000e000f,0x000d000e,
+ 0x000b000c,0x000a000b,0x000b000c,0x000d000e,0x000d000f,0x000a000c,0x000a000a,0x000a000c,
+ 0x000d000f,0x000d000e,0x000b000c,0x000a000b,0x000b000c,0x000d000e,0x000e000f,0x000d000d,
+ 0x000d000d,0x000d000d,0x000e000f,0x000d000d,0x000a000c,0x000a000b,0x000a000c,0x000d000d,
+ 0x000b000c,0x00070009,0x00070008,0x00070009,0x000b000c,0x000a000b,0x00070008,0x00060005,
+ 0x00070008,0x000a000b,0x000b000c,0x00070009,0x00070008,0x00070009,0x000b000c,0x000d000d,
+ 0x000a000c,0x000a000b,0x000a000c,0x000d000d,0x000d000c,0x000a000b,0x000a000a,0x000a000b,
+ 0x000d000c,0x000a000a,0x00060007,0x00060005,0x00060007,0x000a000a,0x00090009,0x00060005,
+ 0x00040001,0x00060005,0x00090009,0x000a000a,0x00060007,0x00060005,0x00060007,0x000a000a,
+ 0x000d000c,0x000a000b,0x000a000a,0x000a000b,0x000d000c,0x000d000d,0x000a000c,0x000a000b,
+ 0x000a000c,0x000d000d,0x000b000c,0x00070009,0x00070008,0x00070009,0x000b000c,0x000a000b,
+ 0x00070008,0x00060005,0x00070008,0x000a000b,0x000b000c,0x00070009,0x00070008,0x00070009,
+ 0x000b000c,0x000d000d,0x000a000c,0x000a000b,0x000a000c,0x000d000d,0x000e000f,0x000d000d,
+ 0x000d000d,0x000d000d,0x000e000f,0x000d000e,0x000b000c,0x000a000b,0x000b000c,0x000d000e,
+ 0x000d000f,0x000a000c,0x000a000a,0x000a000c,0x000d000f,0x000d000e,0x000b000c,0x000a000b,
+ 0x000b000c,0x000d000e,0x000e000f,0x000d000d,0x000d000d,0x000d000d,0x000e000f,0x000e0010,
+ 0x000d000f,0x000d000d,0x000d000f,0x000e0010,0x000d0010,0x000b000d,0x000a000b,0x000b000d,
+ 0x000d0010,0x000d0010,0x000b000d,0x000a000b,0x000b000d,0x000d0010,0x000d0010,0x000b000d,
+ 0x000a000b,0x000b000d,0x000d0010,0x000e0010,0x000d000f,0x000d000d,0x000d000f,0x000e0010,
+ 0x000d000f,0x000b000d,0x000b000c,0x000b000d,0x000d000f,0x000b000e,0x0008000b,0x00070009,
+ 0x0008000b,0x000b000e,0x000b000e,0x0007000a,0x00060007,0x0007000a,0x000b000e,0x000b000e,
+ 0x0008000b,0x00070009,0x0008000b,0x000b000e,0x000d000f,0x000b000d,0x000b000c,0x000b000d,
+ 0x000d000f,0x000d000f,0x000b000d,0x000a000c,0x000b000d,0x000d000f,0x000b000d,0x0007000a,
+ 0x00060008,0x0007000a,0x000b000d,0x000a000c,0x00070008,0x00050005,0x00070008,0x000a000c,
+ 0x000b000d,0x0007000a,0x00060008,0x0007000a,0x000b000d,0x000d000f,0x000b000d,0x000a000c,
+ 0x000b000d,0x000d000f,0x000d000f,0x000b000d,0x000b000c,0x000b000d,0x000d000f,0x000b000e,
+ 0x0008000b,0x00070009,0x0008000b,0x000b000e,0x000b000e,0x0007000a,0x00060007,0x0007000a,
+ 0x000b000e,0x000b000e,0x0008000b,0x00070009,0x0008000b,0x000b000e,0x000d000f,0x000b000d,
+ 0x000b000c,0x000b000d,0x000d000f,0x000e0010,0x000d000f,0x000d000d,0x000d000f,0x000e0010,
+ 0x000d0010,0x000b000d,0x000a000b,0x000b000d,0x000d0010,0x000d0010,0x000b000d,0x000a000b,
+ 0x000b000d,0x000d0010,0x000d0010,0x000b000d,0x000a000b,0x000b000d,0x000d0010,0x000e0010,
+ 0x000d000f,0x000d000d,0x000d000f,0x000e0010,0x000f0013,0x000e0010,0x000e000f,0x000e0010,
+ 0x000f0013,0x000f0013,0x000d000f,0x000d000d,0x000d000f,0x000f0013,0x000f0013,0x000d000f,
+ 0x000d000d,0x000d000f,0x000f0013,0x000f0013,0x000d000f,0x000d000d,0x000d000f,0x000f0013,
+ 0x000f0013,0x000e0010,0x000e000f,0x000e0010,0x000f0013,0x000f0013,0x000d0010,0x000d000f,
+ 0x000d0010,0x000f0013,0x000d0012,0x000b000e,0x000a000c,0x000b000e,0x000d0012,0x000d0011,
+ 0x000a000d,0x000a000a,0x000a000d,0x000d0011,0x000d0012,0x000b000e,0x000a000c,0x000b000e,
+ 0x000d0012,0x000f0013,0x000d0010,0x000d000f,0x000d0010,0x000f0013,0x000f0013,0x000d0011,
+ 0x000d000f,0x000d0011,0x000f0013,0x000d0012,0x000a000e,0x000a000b,0x000a000e,0x000d0012,
+ 0x000d0011,0x000a000c,0x00090009,0x000a000c,0x000d0011,0x000d0012,0x000a000e,0x000a000b,
+ 0x000a000e,0x000d0012,0x000f0013,0x000d0011,0x000d000f,0x000d0011,0x000f0013,0x000f0013,
+ 0x000d0010,0x000d000f,0x000d0010,0x000f0013,0x000d0012,0x000b000e,0x000a000c,0x000b000e,
+ 0x000d0012,0x000d0011,0x000a000d,0x000a000a,0x000a000d,0x000d0011,0x000d0012,0x000b000e,
+ 0x000a000c,0x000b000e,0x000d0012,0x000f0013,0x000d0010,0x000d000f,0x000d0010,0x000f0013,
+ 0x000f0013,0x000e0010,0x000e000f,0x000e0010,0x000f0013,0x000f0013,0x000d000f,0x000d000d,
+ 0x000d000f,0x000f0013,0x000f0013,0x000d000f,0x000d000d,0x000d000f,0x000f0013,0x000f0013,
+ 0x000d000f,0x000d000d,0x000d000f,0x000f0013,0x000f0013,0x000e0010,0x000e000f,0x000e0010,
+ 0x000f0013,
+};
+
+const uint32_t hlen0506[81] = {
+ 0x000b000d,0x000a000c,0x0009000b,0x0009000b,0x0009000a,0x0009000b,0x0009000b,0x000a000c,
+ 0x000b000d,0x000a000c,0x0009000b,0x0008000a,0x00070009,0x00070008,0x00070009,0x0008000a,
+ 0x0009000b,0x000a000c,0x0009000c,0x0008000a,0x00060009,0x00060008,0x00060007,0x00060008,
+ 0x00060009,0x0008000a,0x0009000b,0x0009000b,0x00070009,0x00060008,0x00040005,0x00040004,
+ 0x00040005,0x00060008,0x00070009,0x0009000b,0x0009000a,0x00070008,0x00060007,0x00040004,
+ 0x00040001,0x00040004,0x00060007,0x00070008,0x0009000b,0x0009000b,0x00070009,0x00060008,
+ 0x00040005,0x00040004,0x00040005,0x00060008,0x00070009,0x0009000b,0x0009000b,0x0008000a,
+ 0x00060009,0x00060008,0x00060007,0x00060008,0x00060009,0x0008000a,0x0009000b,0x000a000c,
+ 0x0009000b,0x0008000a,0x00070009,0x00070008,0x00070009,0x0007000a,0x0008000b,0x000a000c,
+ 0x000b000d,0x000a000c,0x0009000c,0x0009000b,0x0009000a,0x0009000a,0x0009000b,0x000a000c,
+ 0x000b000d,
+};
+
+const uint32_t hlen0708[225] = {
+ 0x000c000e,0x000b000e,0x000b000d,0x000b000d,0x000a000c,0x000a000c,0x000a000c,0x000b000c,
+ 0x000a000c,0x000a000c,0x000a000c,0x000b000d,0x000b000d,0x000b000e,0x000c000e,0x000b000e,
+ 0x000b000e,0x000a000d,0x000a000c,0x000a000c,0x0009000b,0x0009000b,0x000a000b,0x0009000b,
+ 0x0009000b,0x000a000c,0x000a000c,0x000a000d,0x000b000e,0x000b000e,0x000c000d,0x000a000d,
+ 0x000a000c,0x0009000c,0x0009000b,0x0008000b,0x0009000a,0x0009000a,0x0009000a,0x0008000b,
+ 0x0009000b,0x0009000c,0x000a000c,0x000a000d,0x000c000d,0x000b000d,0x000a000c,0x0009000c,
+ 0x0009000c,0x0008000b,0x0008000b,0x0008000a,0x00080009,0x0008000a,0x0008000b,0x0008000b,
+ 0x0009000c,0x0009000c,0x000a000c,0x000b000d,0x000a000c,0x000a000c,0x0009000b,0x0008000b,
+ 0x0008000a,0x0007000a,0x00070009,0x00070008,0x00070009,0x0007000a,0x0008000a,0x0008000b,
+ 0x0009000b,0x000a000c,0x000a000c,0x000a000c,0x0009000b,0x0009000b,0x0008000a,0x0007000a,
+ 0x00060009,0x00060008,0x00060007,0x00060008,0x00060009,0x0007000a,0x0008000a,0x0009000b,
+ 0x0009000b,0x000a000c,0x000a000b,0x0009000b,0x0009000a,0x0008000a,0x00070009,0x00060008,
+ 0x00050006,0x00050004,0x00050006,0x00060008,0x00070009,0x0008000a,0x0009000a,0x0009000b,
+ 0x000a000b,0x000b000c,0x000a000b,0x0009000a,0x00080009,0x00070008,0x00060007,0x00050004,
+ 0x00050001,0x00050004,0x00060007,0x00070008,0x00080009,0x0009000a,0x000a000b,0x000b000c,
+ 0x000a000b,0x0009000b,0x0009000a,0x0008000a,0x00070009,0x00060008,0x00050006,0x00050004,
+ 0x00050006,0x00060008,0x00070009,0x0008000a,0x0009000a,0x0009000b,0x000a000b,0x000a000c,
+ 0x0009000b,0x0009000b,0x0008000a,0x0007000a,0x00060009,0x00060008,0x00060007,0x00060008,
+ 0x00060009,0x0007000a,0x0008000a,0x0009000b,0x0009000b,0x000a000c,0x000a000c,0x000a000c,
+ 0x0009000b,0x0008000b,0x0008000a,0x0007000a,0x00070009,0x00070008,0x00070009,0x0007000a,
+ 0x0008000a,0x0008000b,0x0009000b,0x000a000c,0x000a000c,0x000b000d,0x000a000c,0x0009000c,
+ 0x0009000c,0x0008000b,0x0008000b,0x0008000a,0x00080009,0x0008000a,0x0008000b,0x0008000b,
+ 0x0009000c,0x0009000c,0x000a000c,0x000b000d,0x000c000d,0x000a000d,0x000a000c,0x0009000c,
+ 0x0009000b,0x0008000b,0x0009000a,0x0009000a,0x0009000a,0x0008000b,0x0009000b,0x0009000c,
+ 0x000a000c,0x000a000d,0x000c000d,0x000b000e,0x000b000e,0x000a000d,0x000a000c,0x000a000c,
+ 0x0009000b,0x0009000b,0x000a000b,0x0009000b,0x0009000b,0x000a000c,0x000a000c,0x000a000d,
+ 0x000b000e,0x000b000e,0x000c000e,0x000b000e,0x000b000d,0x000b000d,0x000a000c,0x000a000c,
+ 0x000a000c,0x000b000c,0x000a000c,0x000a000c,0x000a000c,0x000b000d,0x000b000d,0x000b000e,
+ 0x000c000e,
+};
+
+const uint32_t hlen0910[625] = {
+ 0x000e0011,0x000e0010,0x000e0010,0x000e0010,0x000d0010,0x000d000f,0x000c000f,0x000c000f,
+ 0x000c000f,0x000c000e,0x000c000e,0x000c000e,0x000c000e,0x000c000e,0x000c000e,0x000c000e,
+ 0x000c000f,0x000c000f,0x000c000f,0x000d000f,0x000d0010,0x000e0010,0x000e0010,0x000e0010,
+ 0x000e0011,0x000e0011,0x000d0011,0x000d0010,0x000d0010,0x000d000f,0x000c000f,0x000c000f,
+ 0x000c000f,0x000c000e,0x000c000e,0x000b000e,0x000c000d,0x000c000d,0x000c000d,0x000b000e,
+ 0x000c000e,0x000c000e,0x000c000f,0x000c000f,0x000c000f,0x000d000f,0x000d0010,0x000d0010,
+ 0x000d0011,0x000e0011,0x000e0011,0x000d0010,0x000d0010,0x000d0010,0x000c000f,0x000c000f,
+ 0x000c000f,0x000c000e,0x000b000e,0x000b000e,0x000b000d,0x000b000d,0x000b000d,0x000b000d,
+ 0x000b000d,0x000b000e,0x000b000e,0x000c000e,0x000c000f,0x000c000f,0x000c000f,0x000d0010,
+ 0x000d0010,0x000d0010,0x000e0011,0x000e0010,0x000d0010,0x000d0010,0x000c000f,0x000c000f,
+ 0x000c000e,0x000b000e,0x000b000e,0x000b000e,0x000b000d,0x000b000d,0x000b000c,0x000b000c,
+ 0x000b000c,0x000b000d,0x000b000d,0x000b000e,0x000b000e,0x000b000e,0x000c000e,0x000c000f,
+ 0x000c000f,0x000d0010,0x000d0010,0x000e0010,0x000d0010,0x000d000f,0x000c0010,0x000c000f,
+ 0x000c000f,0x000b000e,0x000b000e,0x000a000d,0x000a000d,0x000a000d,0x000a000c,0x000a000c,
+ 0x000a000c,0x000a000c,0x000a000c,0x000a000d,0x000a000d,0x000a000d,0x000b000e,0x000b000e,
+ 0x000c000f,0x000c000f,0x000c0010,0x000d000f,0x000d0010,0x000d000f,0x000d000f,0x000c000f,
+ 0x000c000f,0x000b000f,0x000b000f,0x000b000e,0x000a000e,0x000a000d,0x000a000d,0x000a000c,
+ 0x000a000c,0x000a000c,0x000a000c,0x000a000c,0x000a000d,0x000a000d,0x000a000e,0x000b000e,
+ 0x000b000f,0x000b000f,0x000c000f,0x000c000f,0x000d000f,0x000d000f,0x000d000f,0x000c000f,
+ 0x000c000f,0x000b000e,0x000b000e,0x000b000e,0x000a000e,0x000a000d,0x0009000d,0x0009000d,
+ 0x0009000c,0x0009000b,0x000a000c,0x0009000b,0x0009000c,0x0009000d,0x0009000d,0x000a000d,
+ 0x000a000e,0x000b000e,0x000b000e,0x000b000e,0x000c000f,0x000c000f,0x000d000f,0x000d000f,
+ 0x000c000f,0x000c000e,0x000b000e,0x000a000d,0x000a000e,0x000a000d,0x0009000d,0x0009000d,
+ 0x0009000c,0x0008000b,0x0009000b,0x0009000b,0x0009000b,0x0008000b,0x0009000c,0x0009000d,
+ 0x0009000d,0x000a000d,0x000a000e,0x000a000d,0x000b000e,0x000c000e,0x000c000f,0x000d000f,
+ 0x000c000f,0x000c000e,0x000b000e,0x000b000e,0x000a000d,0x000a000d,0x0009000d,0x0009000c,
+ 0x0008000c,0x0008000b,0x0008000b,0x0008000a,0x0008000a,0x0008000a,0x0008000b,0x0008000b,
+ 0x0008000c,0x0009000c,0x0009000d,0x000a000d,0x000a000d,0x000b000e,0x000b000e,0x000c000e,
+ 0x000c000f,0x000c000f,0x000c000e,0x000b000e,0x000b000d,0x000a000d,0x000a000d,0x0009000c,
+ 0x0009000c,0x0008000b,0x0007000b,0x0007000a,0x00070009,0x00070009,0x00070009,0x0007000a,
+ 0x0007000b,0x0008000b,0x0009000c,0x0009000c,0x000a000d,0x000a000d,0x000b000d,0x000b000e,
+ 0x000c000e,0x000c000f,0x000c000e,0x000c000e,0x000b000e,0x000b000d,0x000a000c,0x000a000c,
+ 0x0009000c,0x0008000b,0x0008000a,0x0007000a,0x00070009,0x00060008,0x00070007,0x00060008,
+ 0x00070009,0x0007000a,0x0008000a,0x0008000b,0x0009000c,0x000a000c,0x000a000c,0x000b000d,
+ 0x000b000e,0x000c000e,0x000c000e,0x000d000e,0x000c000e,0x000c000d,0x000b000c,0x000a000c,
+ 0x000a000c,0x0009000b,0x0009000a,0x0008000a,0x00070009,0x00060008,0x00060006,0x00060004,
+ 0x00060006,0x00060008,0x00070009,0x0008000a,0x0009000a,0x0009000b,0x000a000c,0x000a000c,
+ 0x000b000c,0x000c000d,0x000c000e,0x000d000e,0x000d000e,0x000c000e,0x000c000d,0x000b000d,
+ 0x000b000c,0x000b000c,0x000a000b,0x0009000b,0x0008000a,0x00070009,0x00070007,0x00060004,
+ 0x00060001,0x00060004,0x00070007,0x00070009,0x0008000a,0x0009000b,0x000a000b,0x000b000c,
+ 0x000b000c,0x000b000d,0x000c000d,0x000c000e,0x000d000e,0x000d000e,0x000c000e,0x000c000d,
+ 0x000b000c,0x000a000c,0x000a000c,0x0009000b,0x0009000a,0x0008000a,0x00070009,0x00060008,
+ 0x00060006,0x00060004,0x00060006,0x00060008,0x00070009,0x0008000a,0x0009000a,0x0009000b,
+ 0x000a000c,0x000a000c,0x000b000c,0x000c000d,0x000c000e,0x000d000e,0x000c000e,0x000c000e,
+ 0x000b000e,0x000b000d,0x000a000c,0x000a000c,0x0009000c,0x0008000b,0x0008000a,0x0007000a,
+ 0x00070009,0x00060008,0x00070007,0x00060008,0x00070009,0x0007000a,0x0008000a,0x0008000b,
+ 0x0009000c,0x000a000c,0x000a000c,0x000b000d,0x000b000e,0x000c000e,0x000c000e,0x000c000f,
+ 0x000c000e,0x000b000e,0x000b000d,0x000a000d,0x000a000d,0x0009000c,0x0009000c,0x0008000b,
+ 0x0007000b,0x0007000a,0x00070009,0x00070009,0x00070009,0x0007000a,0x0007000b,0x0008000b,
+ 0x0009000c,0x0009000c,0x000a000d,0x000a000d,0x000b000d,0x000b000e,0x000c000e,0x000c000f,
+ 0x000c000f,0x000c000e,0x000b000e,0x000b000e,0x000a000d,0x000a000d,0x0009000d,0x0009000c,
+ 0x0008000c,0x0008000b,0x0008000b,0x0008000a,0x0008000a,0x0008000a,0x0008000b,0x0008000b,
+ 0x0008000c,0x0009000c,0x0009000d,0x000a000d,0x000a000d,0x000b000e,0x000b000e,0x000c000e,
+ 0x000c000f,0x000d000f,0x000c000f,0x000c000e,0x000b000e,0x000a000d,0x000a000e,0x000a000d,
+ 0x0009000d,0x0009000d,0x0009000c,0x0008000b,0x0009000b,0x0009000b,0x0009000b,0x0008000b,
+ 0x0009000c,0x0009000d,0x0009000d,0x000a000d,0x000a000e,0x000a000d,0x000b000e,0x000c000e,
+ 0x000c000f,0x000d000f,0x000d000f,0x000c000f,0x000c000f,0x000b000e,0x000b000e,0x000b000e,
+ 0x000a000e,0x000a000d,0x0009000d,0x0009000d,0x0009000c,0x0009000b,0x000a000c,0x0009000b,
+ 0x0009000c,0x0009000d,0x0009000d,0x000a000d,0x000a000e,0x000b000e,0x000b000e,0x000b000e,
+ 0x000c000f,0x000c000f,0x000d000f,0x000d000f,0x000d000f,0x000c000f,0x000c000f,0x000b000f,
+ 0x000b000f,0x000b000e,0x000a000e,0x000a000d,0x000a000d,0x000a000c,0x000a000c,0x000a000c,
+ 0x000a000c,0x000a000c,0x000a000d,0x000a000d,0x000a000e,0x000b000e,0x000b000f,0x000b000f,
+ 0x000c000f,0x000c000f,0x000d000f,0x000d000f,0x000d0010,0x000d000f,0x000c0010,0x000c000f,
+ 0x000c000f,0x000b000e,0x000b000e,0x000a000d,0x000a000d,0x000a000d,0x000a000c,0x000a000c,
+ 0x000a000c,0x000a000c,0x000a000c,0x000a000d,0x000a000d,0x000a000d,0x000b000e,0x000b000e,
+ 0x000c000f,0x000c000f,0x000c0010,0x000d000f,0x000d0010,0x000e0010,0x000d0010,0x000d0010,
+ 0x000c000f,0x000c000f,0x000c000e,0x000b000e,0x000b000e,0x000b000e,0x000b000d,0x000b000d,
+ 0x000b000c,0x000b000c,0x000b000c,0x000b000d,0x000b000d,0x000b000e,0x000b000e,0x000b000e,
+ 0x000c000e,0x000c000f,0x000c000f,0x000d0010,0x000d0010,0x000e0010,0x000e0011,0x000d0010,
+ 0x000d0010,0x000d0010,0x000c000f,0x000c000f,0x000c000f,0x000c000e,0x000b000e,0x000b000e,
+ 0x000b000d,0x000b000d,0x000b000d,0x000b000d,0x000b000d,0x000b000e,0x000b000e,0x000c000e,
+ 0x000c000f,0x000c000f,0x000c000f,0x000d0010,0x000d0010,0x000d0010,0x000e0011,0x000e0011,
+ 0x000d0011,0x000d0010,0x000d0010,0x000d000f,0x000c000f,0x000c000f,0x000c000f,0x000c000e,
+ 0x000c000e,0x000b000e,0x000c000d,0x000c000d,0x000c000d,0x000b000e,0x000c000e,0x000c000e,
+ 0x000c000f,0x000c000f,0x000c000f,0x000d000f,0x000d0010,0x000d0010,0x000d0011,0x000e0011,
+ 0x000e0011,0x000e0010,0x000e0010,0x000e0010,0x000d0010,0x000d000f,0x000c000f,0x000c000f,
+ 0x000c000f,0x000c000e,0x000c000e,0x000c000e,0x000c000e,0x000c000e,0x000c000e,0x000c000e,
+ 0x000c000f,0x000c000f,0x000c000f,0x000d000f,0x000d0010,0x000e0010,0x000e0010,0x000e0010,
+ 0x000e0011,
+};
@@ -39,3 +39,10 @@ extern hcode16_t book09[169];
 extern hcode16_t book10[169];
 extern hcode16_t book11[289];
 extern hcode32_t book12[121];
+
+/* packed lengths of the book pairs 1/2 to 9/10, see huffdata.c */
+extern const uint32_t hlen0102[81];
+extern const uint32_t hlen0304[625];
+extern const uint32_t hlen0506[81];
+extern const uint32_t hlen0708[225];
+extern const uint32_t hlen0910[625];
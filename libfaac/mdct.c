@@ -0,0 +1,173 @@
+/****************************************************************************
+    MDCT with precomputed twiddle factors
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+****************************************************************************/
+
+#include <math.h>
+#include "mdct.h"
+#include "util.h"
+
+void MDCTInit(MDCTInfo *mdctInfo, FFT_Tables *fft_tables, const CPUKernels *kernels,
+              int frameLen)
+{
+    int size, i;
+
+    mdctInfo->fft_tables = fft_tables;
+    mdctInfo->kernels = kernels;
+
+    mdctInfo->len[MDCT_LONG] = 2 * frameLen;
+    mdctInfo->len[MDCT_SHORT] = 2 * frameLen / MAX_SHORT_WINDOWS;
+
+    for (size = 0; size < MDCT_SIZES; size++)
+    {
+        int N = mdctInfo->len[size];
+        double freq = 2.0 * M_PI / N;
+
+        /* the FFT size with N/4 points */
+        for (i = 0; i < MAXLOGM; i++)
+        {
+            if (fft_tables->nfft[i] >= (N >> 2))
+                break;
+        }
+        mdctInfo->logm[size] = i;
+
+        mdctInfo->twr[size] = (faac_real*)AllocMemory((N >> 1) * sizeof(faac_real));
+        mdctInfo->twi[size] = (faac_real*)AllocMemory((N >> 1) * sizeof(faac_real));
+
+        for (i = 0; i < (N >> 2); i++)
+        {
+            mdctInfo->twr[size][2 * i] = cos(freq * (i + 0.125));
+            mdctInfo->twr[size][2 * i + 1] = cos(freq * (i + 0.125));
+            mdctInfo->twi[size][2 * i] = sin(freq * (i + 0.125));
+            mdctInfo->twi[size][2 * i + 1] = -sin(freq * (i + 0.125));
+        }
+    }
+}
+
+void MDCTEnd(MDCTInfo *mdctInfo)
+{
+    int size;
+
+    for (size = 0; size < MDCT_SIZES; size++)
+    {
+        if (mdctInfo->twr[size]) FreeMemory(mdctInfo->twr[size]);
+        if (mdctInfo->twi[size]) FreeMemory(mdctInfo->twi[size]);
+        mdctInfo->twr[size] = NULL;
+        mdctInfo->twi[size] = NULL;
+    }
+}
+
+void MDCT(MDCTInfo *mdctInfo, faac_real *data, int N)
+{
+    /* N/4 interleaved complex values */
+    faac_real x[BLOCK_LEN_LONG];
+    faac_real y[BLOCK_LEN_LONG];
+    int size = (N == mdctInfo->len[MDCT_SHORT]) ? MDCT_SHORT : MDCT_LONG;
+    const faac_real *twr = mdctInfo->twr[size];
+    const faac_real *twi = mdctInfo->twi[size];
+    int i, n;
+
+    /* calculate real and imaginary parts of g(n) or G(p) */
+    for (i = 0; i < (N >> 3); i++) {
+        n = (N >> 1) - 1 - 2 * i;
+        x[2 * i] = data [(N >> 2) + n] + data [N + (N >> 2) - 1 - n]; /* second form of e(n) */
+        n = 2 * i;
+        x[2 * i + 1] = data [(N >> 2) + n] - data [(N >> 2) - 1 - n]; /* first form of e(n) */
+    }
+    for (; i < (N >> 2); i++) {
+        n = (N >> 1) - 1 - 2 * i;
+        x[2 * i] = data [(N >> 2) + n] - data [(N >> 2) - 1 - n]; /* first form of e(n) */
+        n = 2 * i;
+        x[2 * i + 1] = data [(N >> 2) + n] + data [N + (N >> 2) - 1 - n]; /* second form of e(n) */
+    }
+
+    /* pre-twiddle */
+    mdctInfo->kernels->cmul(x, twr, twi, N >> 2);
+
+    /* complex FFT of length N/4 */
+    cfft(mdctInfo->fft_tables, y, x, mdctInfo->logm[size]);
+
+    /* post-twiddle */
+    mdctInfo->kernels->cmul(y, twr, twi, N >> 2);
+
+    /* get output data */
+    for (i = 0; i < (N >> 2); i++) {
+        faac_real tempr = 2. * y[2 * i];
+        faac_real tempi = 2. * y[2 * i + 1];
+
+        data [2 * i] = -tempr;   /* first half even */
+        data [(N >> 1) - 1 - 2 * i] = tempi;  /* first half odd */
+        data [(N >> 1) + 2 * i] = -tempi;  /* second half even */
+        data [N - 1 - 2 * i] = tempr;  /* second half odd */
+    }
+}
+
+void MDCTShort(MDCTInfo *mdctInfo, faac_real *out, const faac_real *in,
+               const faac_real *first_window, const faac_real *window)
+{
+    const int N = mdctInfo->len[MDCT_SHORT];
+    /* N/4 complex values of every block, as eight real parts followed by
+       eight imaginary parts */
+    faac_real x[MAX_SHORT_WINDOWS * BLOCK_LEN_SHORT];
+    faac_real y[MAX_SHORT_WINDOWS * BLOCK_LEN_SHORT];
+    const faac_real *twr = mdctInfo->twr[MDCT_SHORT];
+    const faac_real *twi = mdctInfo->twi[MDCT_SHORT];
+    int i, k, n, a, b;
+
+    /* window and fold every block as in MDCT() */
+    for (k = 0; k < MAX_SHORT_WINDOWS; k++)
+    {
+        const faac_real *data = in + k * (N >> 1);
+        const faac_real *w = k ? window : first_window;
+
+        for (i = 0; i < (N >> 3); i++) {
+            n = (N >> 1) - 1 - 2 * i;
+            a = (N >> 2) + n;
+            b = N + (N >> 2) - 1 - n;
+            x[16 * i + k] = data[a] * w[a] + data[b] * w[b];
+            n = 2 * i;
+            a = (N >> 2) + n;
+            b = (N >> 2) - 1 - n;
+            x[16 * i + 8 + k] = data[a] * w[a] - data[b] * w[b];
+        }
+        for (; i < (N >> 2); i++) {
+            n = (N >> 1) - 1 - 2 * i;
+            a = (N >> 2) + n;
+            b = (N >> 2) - 1 - n;
+            x[16 * i + k] = data[a] * w[a] - data[b] * w[b];
+            n = 2 * i;
+            a = (N >> 2) + n;
+            b = N + (N >> 2) - 1 - n;
+            x[16 * i + 8 + k] = data[a] * w[a] + data[b] * w[b];
+        }
+    }
+
+    mdctInfo->kernels->cmul8(x, twr, twi, N >> 2);
+    cfft8(mdctInfo->fft_tables, y, x, mdctInfo->logm[MDCT_SHORT]);
+    mdctInfo->kernels->cmul8(y, twr, twi, N >> 2);
+
+    for (k = 0; k < MAX_SHORT_WINDOWS; k++)
+    {
+        faac_real *data = out + k * (N >> 1);
+
+        for (i = 0; i < (N >> 2); i++) {
+            faac_real tempr = 2. * y[16 * i + k];
+            faac_real tempi = 2. * y[16 * i + 8 + k];
+
+            data [2 * i] = -tempr;
+            data [(N >> 1) - 1 - 2 * i] = tempi;
+        }
+    }
+}
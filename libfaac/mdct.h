@@ -0,0 +1,63 @@
+/****************************************************************************
+    MDCT with precomputed twiddle factors
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+****************************************************************************/
+
+#ifndef MDCT_H
+#define MDCT_H
+
+#include "coder.h"
+#include "fft.h"
+#include "cpu.h"
+
+enum {
+    MDCT_LONG,
+    MDCT_SHORT,
+    MDCT_SIZES
+};
+
+typedef struct
+{
+    FFT_Tables *fft_tables;
+    const CPUKernels *kernels;
+
+    /* transform length N and log2 of its N/4 point FFT */
+    int len[MDCT_SIZES];
+    int logm[MDCT_SIZES];
+
+    /* pre/post twiddles exp(-i * 2*pi/N * (k + 1/8)), k < N/4, in the
+       split layout of CPUKernels.cmul */
+    faac_real *twr[MDCT_SIZES];
+    faac_real *twi[MDCT_SIZES];
+} MDCTInfo;
+
+/* the long transform has N = 2*frameLen, the short one an eighth of it;
+   fft_tables must have the sizes of frameLen */
+void MDCTInit(MDCTInfo *mdctInfo, FFT_Tables *fft_tables, const CPUKernels *kernels,
+              int frameLen);
+void MDCTEnd(MDCTInfo *mdctInfo);
+
+/* in place MDCT of N = len[MDCT_LONG] or len[MDCT_SHORT] samples,
+   the N/2 coefficients are returned in data[0..N/2-1] */
+void MDCT(MDCTInfo *mdctInfo, faac_real *data, int N);
+
+/* MDCT of all MAX_SHORT_WINDOWS short blocks of a frame at once. With
+   the block length L = len[MDCT_SHORT]/2, block k is in[k*L .. (k+2)*L-1]
+   multiplied by window (first_window for block 0), its L coefficients
+   go to out + k*L. out may point at in. */
+void MDCTShort(MDCTInfo *mdctInfo, faac_real *out, const faac_real *in,
+               const faac_real *first_window, const faac_real *window);
+
+#endif
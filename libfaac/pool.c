@@ -0,0 +1,225 @@
+/****************************************************************************
+    Worker threads for running independent encoder jobs in parallel
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+****************************************************************************/
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <stdlib.h>
+#include "pool.h"
+#include "util.h"
+
+#ifdef HAVE_PTHREAD
+
+#include <pthread.h>
+
+struct WorkerPool
+{
+    pthread_mutex_t lock;
+    pthread_cond_t start;   /* signalled when a batch is posted */
+    pthread_cond_t done;    /* signalled when the last job of a batch ends */
+    pthread_t *threads;
+    int numThreads;
+    int quit;
+
+    /* current batch, protected by lock */
+    PoolJob job;
+    void *arg;
+    int count;      /* number of jobs */
+    int next;       /* next job to hand out */
+    int pending;    /* jobs not finished yet */
+};
+
+/* run jobs of the current batch until none is left, called with lock held */
+static void RunJobs(WorkerPool *pool)
+{
+    while (pool->next < pool->count)
+    {
+        int index = pool->next++;
+
+        pthread_mutex_unlock(&pool->lock);
+        pool->job(pool->arg, index);
+        pthread_mutex_lock(&pool->lock);
+
+        if (--pool->pending == 0)
+            pthread_cond_signal(&pool->done);
+    }
+}
+
+static void *Worker(void *arg)
+{
+    WorkerPool *pool = (WorkerPool *)arg;
+
+    pthread_mutex_lock(&pool->lock);
+    for (;;)
+    {
+        while (!pool->quit && pool->next >= pool->count)
+            pthread_cond_wait(&pool->start, &pool->lock);
+        if (pool->quit)
+            break;
+        RunJobs(pool);
+    }
+    pthread_mutex_unlock(&pool->lock);
+
+    return NULL;
+}
+
+WorkerPool *PoolCreate(int numThreads)
+{
+    WorkerPool *pool;
+    int i;
+
+    if (numThreads < 2)
+        return NULL;
+
+    pool = (WorkerPool *)AllocMemory(sizeof(WorkerPool));
+    SetMemory(pool, 0, sizeof(WorkerPool));
+    pool->threads = (pthread_t *)AllocMemory((numThreads - 1) * sizeof(pthread_t));
+    pthread_mutex_init(&pool->lock, NULL);
+    pthread_cond_init(&pool->start, NULL);
+    pthread_cond_init(&pool->done, NULL);
+
+    for (i = 0; i < numThreads - 1; i++)
+    {
+        if (pthread_create(&pool->threads[i], NULL, Worker, pool))
+            break;
+        pool->numThreads++;
+    }
+
+    if (!pool->numThreads)
+    {
+        PoolDestroy(pool);
+        return NULL;
+    }
+
+    return pool;
+}
+
+void PoolDestroy(WorkerPool *pool)
+{
+    int i;
+
+    if (!pool)
+        return;
+
+    pthread_mutex_lock(&pool->lock);
+    pool->quit = 1;
+    pthread_cond_broadcast(&pool->start);
+    pthread_mutex_unlock(&pool->lock);
+
+    for (i = 0; i < pool->numThreads; i++)
+        pthread_join(pool->threads[i], NULL);
+
+    pthread_cond_destroy(&pool->done);
+    pthread_cond_destroy(&pool->start);
+    pthread_mutex_destroy(&pool->lock);
+    FreeMemory(pool->threads);
+    FreeMemory(pool);
+}
+
+/* post a batch, called with lock held */
+static void StartJobs(WorkerPool *pool, PoolJob job, void *arg, int count)
+{
+    pool->job = job;
+    pool->arg = arg;
+    pool->count = count;
+    pool->next = 0;
+    pool->pending = count;
+    pthread_cond_broadcast(&pool->start);
+}
+
+void PoolRun(WorkerPool *pool, PoolJob job, void *arg, int count)
+{
+    int i;
+
+    if (!pool || count < 2)
+    {
+        for (i = 0; i < count; i++)
+            job(arg, i);
+        return;
+    }
+
+    pthread_mutex_lock(&pool->lock);
+    StartJobs(pool, job, arg, count);
+    RunJobs(pool);
+    while (pool->pending)
+        pthread_cond_wait(&pool->done, &pool->lock);
+    pthread_mutex_unlock(&pool->lock);
+}
+
+void PoolPost(WorkerPool *pool, PoolJob job, void *arg, int count)
+{
+    int i;
+
+    if (!pool)
+    {
+        for (i = 0; i < count; i++)
+            job(arg, i);
+        return;
+    }
+
+    pthread_mutex_lock(&pool->lock);
+    while (pool->pending)
+        pthread_cond_wait(&pool->done, &pool->lock);
+    StartJobs(pool, job, arg, count);
+    pthread_mutex_unlock(&pool->lock);
+}
+
+void PoolWait(WorkerPool *pool)
+{
+    if (!pool)
+        return;
+
+    pthread_mutex_lock(&pool->lock);
+    while (pool->pending)
+        pthread_cond_wait(&pool->done, &pool->lock);
+    pthread_mutex_unlock(&pool->lock);
+}
+
+#else /* !HAVE_PTHREAD */
+
+WorkerPool *PoolCreate(int numThreads)
+{
+    (void)numThreads;
+    return NULL;
+}
+
+void PoolDestroy(WorkerPool *pool)
+{
+    (void)pool;
+}
+
+void PoolRun(WorkerPool *pool, PoolJob job, void *arg, int count)
+{
+    int i;
+
+    (void)pool;
+    for (i = 0; i < count; i++)
+        job(arg, i);
+}
+
+void PoolPost(WorkerPool *pool, PoolJob job, void *arg, int count)
+{
+    PoolRun(pool, job, arg, count);
+}
+
+void PoolWait(WorkerPool *pool)
+{
+    (void)pool;
+}
+
+#endif /* HAVE_PTHREAD */
@@ -0,0 +1,40 @@
+/****************************************************************************
+    Worker threads for running independent encoder jobs in parallel
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+****************************************************************************/
+
+#ifndef POOL_H
+#define POOL_H
+
+typedef struct WorkerPool WorkerPool;
+
+/* called once for every index of a batch */
+typedef void (*PoolJob)(void *arg, int index);
+
+/* numThreads includes the calling thread. Returns NULL when no extra
+   thread can be started, PoolRun() then runs everything in order. */
+WorkerPool *PoolCreate(int numThreads);
+void PoolDestroy(WorkerPool *pool);
+
+/* run job(arg, 0) .. job(arg, count - 1) on the workers and the calling
+   thread, return when all of them have finished */
+void PoolRun(WorkerPool *pool, PoolJob job, void *arg, int count);
+
+/* the same on the workers only: start the jobs and return at once,
+   PoolWait() returns when they have finished */
+void PoolPost(WorkerPool *pool, PoolJob job, void *arg, int count);
+void PoolWait(WorkerPool *pool);
+
+#endif
@@ -20,38 +20,21 @@
 
 #include <math.h>
 #include <stdio.h>
+#include <string.h>
 #include "quantize.h"
 #include "huff2.h"
 
-#ifdef HAVE_IMMINTRIN_H
-# include <immintrin.h>
-#endif
-
-#ifdef __SSE2__
-# ifdef __GNUC__
-#  include <cpuid.h>
-# endif
-#endif
-
-#ifdef _MSC_VER
-# include <immintrin.h>
-# include <intrin.h>
-# define __SSE2__
-# define bit_SSE2 (1 << 26)
-#endif
-
 #ifdef __GNUC__
 #define GCC_VERSION (__GNUC__ * 10000 \
                      + __GNUC_MINOR__ * 100 \
                      + __GNUC_PATCHLEVEL__)
 #endif
 
-#define MAGIC_NUMBER  0.4054
 #define NOISEFLOOR 0.4
 
 // band sound masking
-static void bmask(CoderInfo *coderInfo, double *xr0, double *bandqual,
-                  int gnum, double quality)
+static void bmask(CoderInfo *coderInfo, faac_real *xr0, double *bandqual,
+                  int gnum, double quality, int frameLen)
 {
   int sfb, start, end, cnt;
   int *cb_offset = coderInfo->sfb_offset;
@@ -60,9 +43,10 @@ static void bmask(CoderInfo *coderInfo, double *xr0, double *bandqual,
   double powm = 0.4;
   double totenrg = 0.0;
   int gsize = coderInfo->groups.len[gnum];
-  double *xr;
+  faac_real *xr;
   int win;
   int enrgcnt = 0;
+  int shortLen = frameLen / MAX_SHORT_WINDOWS;
 
 
   for (sfb = 0; sfb < coderInfo->sfbn; sfb++)
@@ -79,7 +63,7 @@ static void bmask(CoderInfo *coderInfo, double *xr0, double *bandqual,
               enrgcnt++;
           }
 
-          xr += BLOCK_LEN_SHORT;
+          xr += shortLen;
       }
   }
 
@@ -111,14 +95,14 @@ static void bmask(CoderInfo *coderInfo, double *xr0, double *bandqual,
             if (maxe < e)
                 maxe = e;
         }
-        xr += BLOCK_LEN_SHORT;
+        xr += shortLen;
     }
     maxe *= gsize;
 
 #define NOISETONE 0.2
     if (coderInfo->block_type == ONLY_SHORT_WINDOW)
     {
-        last = BLOCK_LEN_SHORT;
+        last = shortLen;
         avgenrg = totenrg / last;
         avgenrg *= end - start;
 
@@ -129,7 +113,7 @@ static void bmask(CoderInfo *coderInfo, double *xr0, double *bandqual,
     }
     else
     {
-        last = BLOCK_LEN_LONG;
+        last = frameLen;
         avgenrg = totenrg / last;
         avgenrg *= end - start;
 
@@ -143,13 +127,14 @@ static void bmask(CoderInfo *coderInfo, double *xr0, double *bandqual,
   }
 }
 
-enum {MAXSHORTBAND = 36};
 // use band quality levels to quantize a group of windows
 static void qlevel(CoderInfo *coderInfo,
-                   const double *xr0,
+                   const faac_real *xr0,
                    const double *bandqual,
                    int gnum,
-                   int pnslevel
+                   int pnslevel,
+                   const CPUKernels *kernels,
+                   int shortLen
                   )
 {
     int sb, cnt;
@@ -161,20 +146,11 @@ static void qlevel(CoderInfo *coderInfo,
 #endif
     int gsize = coderInfo->groups.len[gnum];
     double pnsthr = 0.1 * pnslevel;
-#ifdef __SSE2__
-    int cpuid[4];
-    int sse2 = 0;
-
-    cpuid[3] = 0;
-# ifdef __GNUC__
-    __cpuid(1, cpuid[0], cpuid[1], cpuid[2], cpuid[3]);
-# endif
-# ifdef _MSC_VER
-    __cpuid(cpuid, 1);
-# endif
-    if (cpuid[3] & bit_SSE2)
-        sse2 = 1;
-#endif
+    int xitab[FRAME_LEN]; /* the quantized group, band after band */
+    int *xi = xitab;
+    HuffSect sect;
+
+    huffsectinit(coderInfo, &sect);
 
     for (sb = 0; sb < coderInfo->sfbn; sb++)
     {
@@ -182,10 +158,9 @@ static void qlevel(CoderInfo *coderInfo,
       int sfac;
       double rmsx;
       double etot;
-      int xitab[8 * MAXSHORTBAND];
-      int *xi;
+      int *xiband;
       int start, end;
-      const double *xr;
+      const faac_real *xr;
       int win;
 
       if (coderInfo->book[coderInfo->bandcnt] != HCB_NONE)
@@ -206,7 +181,7 @@ static void qlevel(CoderInfo *coderInfo,
               double e = xr[cnt] * xr[cnt];
               etot += e;
           }
-          xr += BLOCK_LEN_SHORT;
+          xr += shortLen;
       }
       etot /= (double)gsize;
       rmsx = sqrt(etot / (end - start));
@@ -236,59 +211,26 @@ static void qlevel(CoderInfo *coderInfo,
 
       xr = xr0 + start;
       end -= start;
-      xi = xitab;
+      xiband = xi;
       for (win = 0; win < gsize; win++)
       {
-#ifdef __SSE2__
-          if (sse2)
-          {
-              for (cnt = 0; cnt < end; cnt += 4)
-              {
-                  __m128 x = {xr[cnt], xr[cnt + 1], xr[cnt + 2], xr[cnt + 3]};
-
-                  x = _mm_max_ps(x, _mm_sub_ps((__m128){0, 0, 0, 0}, x));
-                  x = _mm_mul_ps(x, (__m128){sfacfix, sfacfix, sfacfix, sfacfix});
-                  x = _mm_mul_ps(x, _mm_sqrt_ps(x));
-                  x = _mm_sqrt_ps(x);
-                  x = _mm_add_ps(x, (__m128){MAGIC_NUMBER, MAGIC_NUMBER, MAGIC_NUMBER, MAGIC_NUMBER});
-
-                  *(__m128i*)(xi + cnt) = _mm_cvttps_epi32(x);
-              }
-              for (cnt = 0; cnt < end; cnt++)
-              {
-                  if (xr[cnt] < 0)
-                      xi[cnt] = -xi[cnt];
-              }
-              xi += cnt;
-              xr += BLOCK_LEN_SHORT;
-              continue;
-          }
-#endif
-
-          for (cnt = 0; cnt < end; cnt++)
-          {
-              double tmp = fabs(xr[cnt]);
-
-              tmp *= sfacfix;
-              tmp = sqrt(tmp * sqrt(tmp));
-
-              xi[cnt] = (int)(tmp + MAGIC_NUMBER);
-              if (xr[cnt] < 0)
-                  xi[cnt] = -xi[cnt];
-          }
-          xi += cnt;
-          xr += BLOCK_LEN_SHORT;
+          kernels->quantize(xr, xi, end, sfacfix);
+          xi += end;
+          xr += shortLen;
       }
-      huffbook(coderInfo, xitab, gsize * end);
+      huffbook(coderInfo, &sect, xiband, gsize * end);
       coderInfo->sf[coderInfo->bandcnt++] += SF_OFFSET - sfac;
     }
+
+    huffsect(coderInfo, &sect);
 }
 
-int BlocQuant(CoderInfo *coder, double *xr, AACQuantCfg *aacquantCfg)
+int BlocQuant(CoderInfo *coder, faac_real *xr, AACQuantCfg *aacquantCfg)
 {
     double bandlvl[MAX_SCFAC_BANDS];
+    int shortLen = aacquantCfg->frameLen / MAX_SHORT_WINDOWS;
     int cnt;
-    double *gxr;
+    faac_real *gxr;
 
     coder->global_gain = 0;
 
@@ -298,6 +240,7 @@ int BlocQuant(CoderInfo *coder, double *xr, AACQuantCfg *aacquantCfg)
     coder->iLenReordSpData = 0; /* init length of reordered spectral data */
     coder->iLenLongestCW = 0; /* init length of longest codeword */
     coder->cur_cw = 0; /* init codeword counter */
+    coder->all_sfb = coder->sfbn; /* bands per window group */
 #endif
 
     {
@@ -308,18 +251,22 @@ int BlocQuant(CoderInfo *coder, double *xr, AACQuantCfg *aacquantCfg)
         for (cnt = 0; cnt < coder->groups.n; cnt++)
         {
             bmask(coder, gxr, bandlvl, cnt,
-                  (double)aacquantCfg->quality/DEFQUAL);
-            qlevel(coder, gxr, bandlvl, cnt, aacquantCfg->pnslevel);
-            gxr += coder->groups.len[cnt] * BLOCK_LEN_SHORT;
+                  (double)aacquantCfg->quality/DEFQUAL, aacquantCfg->frameLen);
+            qlevel(coder, gxr, bandlvl, cnt, aacquantCfg->pnslevel,
+                   aacquantCfg->kernels, shortLen);
+            gxr += coder->groups.len[cnt] * shortLen;
         }
 
+        /* the scalefactor of the first spectral band, the noise energies
+           are coded apart */
         coder->global_gain = 0;
         for (cnt = 0; cnt < coder->bandcnt; cnt++)
         {
             int book = coder->book[cnt];
             if (!book)
                 continue;
-            if ((book != HCB_INTENSITY) && (book != HCB_INTENSITY2))
+            if ((book != HCB_INTENSITY) && (book != HCB_INTENSITY2)
+                && (book != HCB_PNS))
             {
                 coder->global_gain = coder->sf[cnt];
                 break;
@@ -362,10 +309,99 @@ int BlocQuant(CoderInfo *coder, double *xr, AACQuantCfg *aacquantCfg)
     return 0;
 }
 
+#ifdef DRM
+/* BlocQuant() only codes the bands AACstereo() left at HCB_NONE, keep
+   them free for another pass */
+void BlocSave(CoderInfo *coder)
+{
+    int cnt = coder->groups.n * coder->sfbn;
+
+    memcpy(coder->stereo_sf, coder->sf, cnt * sizeof(coder->sf[0]));
+    memcpy(coder->stereo_book, coder->book, cnt * sizeof(coder->book[0]));
+}
+
+void BlocRestore(CoderInfo *coder)
+{
+    int cnt = coder->groups.n * coder->sfbn;
+
+    memcpy(coder->sf, coder->stereo_sf, cnt * sizeof(coder->sf[0]));
+    memcpy(coder->book, coder->stereo_book, cnt * sizeof(coder->book[0]));
+}
+
+/* Count the lines of every band BlocQuant() would code by the level it
+   quantizes the band rms to at DEFQUAL, bandqual^0.75 */
+void BlocLevel(CoderInfo *coder, faac_real *xr, AACQuantCfg *aacquantCfg,
+               BlocLevels *levels)
+{
+    double bandlvl[MAX_SCFAC_BANDS];
+    int shortLen = aacquantCfg->frameLen / MAX_SHORT_WINDOWS;
+    int bandcnt = 0;
+    int cnt, sb;
+
+    for (cnt = 0; cnt < coder->groups.n; cnt++)
+    {
+        int gsize = coder->groups.len[cnt];
+
+        bmask(coder, xr, bandlvl, cnt, 1.0, aacquantCfg->frameLen);
+        for (sb = 0; sb < coder->sfbn; sb++, bandcnt++)
+        {
+            int start = coder->sfb_offset[sb];
+            int end = coder->sfb_offset[sb + 1];
+            const faac_real *gxr = xr;
+            double etot = 0.0;
+            int win, l, bin;
+
+            if (coder->book[bandcnt] != HCB_NONE || !bandlvl[sb])
+                continue;
+
+            for (win = 0; win < gsize; win++)
+            {
+                for (l = start; l < end; l++)
+                    etot += gxr[l] * gxr[l];
+                gxr += shortLen;
+            }
+            if (etot < (NOISEFLOOR * NOISEFLOOR) * gsize * (end - start))
+                continue;
+
+            bin = lrint(0.75 * log2(bandlvl[sb]) * RATEBINS) + RATELEVELS / 2;
+            if (bin < 0)
+                bin = 0;
+            if (bin >= RATELEVELS)
+                bin = RATELEVELS - 1;
+            levels->lines[bin] += gsize * (end - start);
+        }
+        xr += gsize * shortLen;
+    }
+}
+
+/* Bits of the spectral data at quality, up to a factor. The rms level
+   grows as quality^0.75, but the lines below it come in as well, and
+   the bits grow about as log2(1 + level * quality/DEFQUAL) per line. */
+double BlocBits(const BlocLevels *levels, double quality)
+{
+    double scale = quality / DEFQUAL;
+    double bits = 0.0;
+    int bin;
+
+    for (bin = 0; bin < RATELEVELS; bin++)
+    {
+        if (levels->lines[bin])
+        {
+            double level = exp2((double)(bin - RATELEVELS / 2) / RATEBINS) * scale;
+
+            bits += levels->lines[bin] * log2(1.0 + level);
+        }
+    }
+
+    return bits;
+}
+#endif
+
 void CalcBW(unsigned *bw, int rate, SR_INFO *sr, AACQuantCfg *aacquantCfg)
 {
     // find max short frame band
-    int max = *bw * (BLOCK_LEN_SHORT << 1) / rate;
+    int len = aacquantCfg->frameLen;
+    int max = *bw * (len / MAX_SHORT_WINDOWS << 1) / rate;
     int cnt;
     int l;
 
@@ -377,11 +413,12 @@ void CalcBW(unsigned *bw, int rate, SR_INFO *sr, AACQuantCfg *aacquantCfg)
         l += sr->cb_width_short[cnt];
     }
     aacquantCfg->max_cbs = cnt;
-    if (aacquantCfg->pnslevel)
-        *bw = (double)l * rate / (BLOCK_LEN_SHORT << 1);
+    // LD tables have no short bands
+    if (aacquantCfg->pnslevel && sr->num_cb_short)
+        *bw = (double)l * rate / (len / MAX_SHORT_WINDOWS << 1);
 
     // find max long frame band
-    max = *bw * (BLOCK_LEN_LONG << 1) / rate;
+    max = *bw * (len << 1) / rate;
     l = 0;
     for (cnt = 0; cnt < sr->num_cb_long; cnt++)
     {
@@ -392,12 +429,12 @@ void CalcBW(unsigned *bw, int rate, SR_INFO *sr, AACQuantCfg *aacquantCfg)
     aacquantCfg->max_cbl = cnt;
     aacquantCfg->max_l = l;
 
-    *bw = (double)l * rate / (BLOCK_LEN_LONG << 1);
+    *bw = (double)l * rate / (len << 1);
 }
 
 enum {MINSFB = 2};
 
-static void calce(double *xr, int *bands, double e[NSFB_SHORT], int maxsfb,
+static void calce(faac_real *xr, int *bands, double e[NSFB_SHORT], int maxsfb,
                   int maxl)
 {
     int sfb;
@@ -428,7 +465,7 @@ static void resete(double min[NSFB_SHORT], double max[NSFB_SHORT],
 static int groups = 0;
 static int frames = 0;
 #endif
-void BlocGroup(double *xr, CoderInfo *coderInfo, AACQuantCfg *cfg)
+void BlocGroup(faac_real *xr, CoderInfo *coderInfo, AACQuantCfg *cfg)
 {
     int win, sfb;
     double e[NSFB_SHORT];
@@ -467,7 +504,8 @@ void BlocGroup(double *xr, CoderInfo *coderInfo, AACQuantCfg *cfg)
     {
         int fast = 0;
 
-        calce(xr + win * BLOCK_LEN_SHORT, coderInfo->sfb_offset, e, maxsfb, maxl);
+        calce(xr + win * (cfg->frameLen / MAX_SHORT_WINDOWS), coderInfo->sfb_offset,
+              e, maxsfb, maxl);
         for (sfb = MINSFB; sfb < maxsfb; sfb++)
         {
             if (min[sfb] > e[sfb])
@@ -22,6 +22,7 @@
 #define QUANTIZE_H
 
 #include "coder.h"
+#include "cpu.h"
 
 typedef struct
 {
@@ -29,9 +30,13 @@ typedef struct
     int max_cbl;
     int max_cbs;
     int max_l;
+    int frameLen;   /* long block length */
     int pnslevel;
+    const CPUKernels *kernels;
 } AACQuantCfg;
 
+#define MAGIC_NUMBER  0.4054
+
 enum {
     DEFQUAL = 100,
     MAXQUAL = 5000,
@@ -40,9 +45,24 @@ enum {
     SF_OFFSET = 100,
 };
 
-int BlocQuant(CoderInfo *coderInfo, double *xr, AACQuantCfg *aacquantCfg);
+int BlocQuant(CoderInfo *coderInfo, faac_real *xr, AACQuantCfg *aacquantCfg);
 void CalcBW(unsigned *bw, int rate, SR_INFO *sr, AACQuantCfg *aacquantCfg);
-void BlocGroup(double *xr, CoderInfo *coderInfo, AACQuantCfg *aacquantCfg);
+void BlocGroup(faac_real *xr, CoderInfo *coderInfo, AACQuantCfg *aacquantCfg);
 void BlocStat(void);
+#ifdef DRM
+/* spectral lines of a frame by the quantized level of their band at
+   DEFQUAL, RATEBINS per octave */
+enum {RATEBINS = 4, RATELEVELS = 24 * RATEBINS};
+typedef struct
+{
+    double lines[RATELEVELS];
+} BlocLevels;
+
+void BlocSave(CoderInfo *coderInfo);
+void BlocRestore(CoderInfo *coderInfo);
+void BlocLevel(CoderInfo *coderInfo, faac_real *xr, AACQuantCfg *aacquantCfg,
+               BlocLevels *levels);
+double BlocBits(const BlocLevels *levels, double quality);
+#endif
 
 #endif
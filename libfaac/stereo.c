@@ -23,8 +23,8 @@
 
 
 static void stereo(CoderInfo *cl, CoderInfo *cr,
-                   double *sl0, double *sr0, int *sfcnt,
-                   int wstart, int wend, double phthr
+                   faac_real *sl0, faac_real *sr0, int *sfcnt,
+                   int wstart, int wend, int shortLen, double phthr
                   )
 {
     int sfb;
@@ -59,8 +59,8 @@ static void stereo(CoderInfo *cl, CoderInfo *cr,
         enrgs = enrgd = enrgl = enrgr = 0.0;
         for (win = wstart; win < wend; win++)
         {
-            double *sl = sl0 + win * BLOCK_LEN_SHORT;
-            double *sr = sr0 + win * BLOCK_LEN_SHORT;
+            faac_real *sl = sl0 + win * shortLen;
+            faac_real *sr = sr0 + win * shortLen;
 
             for (l = start; l < end; l++)
             {
@@ -115,8 +115,8 @@ static void stereo(CoderInfo *cl, CoderInfo *cr,
 
             for (win = wstart; win < wend; win++)
             {
-                double *sl = sl0 + win * BLOCK_LEN_SHORT;
-                double *sr = sr0 + win * BLOCK_LEN_SHORT;
+                faac_real *sl = sl0 + win * shortLen;
+                faac_real *sr = sr0 + win * shortLen;
                 for (l = start; l < end; l++)
                 {
                     if (hcb == HCB_INTENSITY)
@@ -133,8 +133,8 @@ static void stereo(CoderInfo *cl, CoderInfo *cr,
 }
 
 static void midside(CoderInfo *coder, ChannelInfo *channel,
-                    double *sl0, double *sr0, int *sfcnt,
-                    int wstart, int wend,
+                    faac_real *sl0, faac_real *sr0, int *sfcnt,
+                    int wstart, int wend, int shortLen,
                     double thrmid, double thrside
                    )
 {
@@ -165,8 +165,8 @@ static void midside(CoderInfo *coder, ChannelInfo *channel,
         enrgs = enrgd = enrgl = enrgr = 0.0;
         for (win = wstart; win < wend; win++)
         {
-            double *sl = sl0 + win * BLOCK_LEN_SHORT;
-            double *sr = sr0 + win * BLOCK_LEN_SHORT;
+            faac_real *sl = sl0 + win * shortLen;
+            faac_real *sr = sr0 + win * shortLen;
 
             for (l = start; l < end; l++)
             {
@@ -203,8 +203,8 @@ static void midside(CoderInfo *coder, ChannelInfo *channel,
             {
                 for (win = wstart; win < wend; win++)
                 {
-                    double *sl = sl0 + win * BLOCK_LEN_SHORT;
-                    double *sr = sr0 + win * BLOCK_LEN_SHORT;
+                    faac_real *sl = sl0 + win * shortLen;
+                    faac_real *sr = sr0 + win * shortLen;
                     for (l = start; l < end; l++)
                     {
                         if (phase == PH_IN)
@@ -229,8 +229,8 @@ static void midside(CoderInfo *coder, ChannelInfo *channel,
         {
             for (win = wstart; win < wend; win++)
             {
-                double *sl = sl0 + win * BLOCK_LEN_SHORT;
-                double *sr = sr0 + win * BLOCK_LEN_SHORT;
+                faac_real *sl = sl0 + win * shortLen;
+                faac_real *sr = sr0 + win * shortLen;
                 for (l = start; l < end; l++)
                 {
                     if (enrgl < enrgr)
@@ -249,10 +249,11 @@ static void midside(CoderInfo *coder, ChannelInfo *channel,
 
 void AACstereo(CoderInfo *coder,
                ChannelInfo *channel,
-               double *s[MAX_CHANNELS],
+               faac_real *s[MAX_CHANNELS],
                int maxchan,
                double quality,
-               int mode
+               int mode,
+               int shortLen
               )
 {
     int chn;
@@ -360,10 +361,11 @@ void AACstereo(CoderInfo *coder,
             switch(mode) {
             case JOINT_MS:
                 midside(coder + chn, channel + chn, s[chn], s[rch], &sfcnt,
-                        start, end, thrmid, thrside);
+                        start, end, shortLen, thrmid, thrside);
                 break;
             case JOINT_IS:
-                stereo(coder + chn, coder + rch, s[chn], s[rch], &sfcnt, start, end, isthr);
+                stereo(coder + chn, coder + rch, s[chn], s[rch], &sfcnt, start, end,
+                       shortLen, isthr);
                 break;
             }
             start = end;
@@ -22,8 +22,9 @@
 
 void AACstereo(CoderInfo *coder,
                ChannelInfo *channel,
-               double *s[MAX_CHANNELS],
+               faac_real *s[MAX_CHANNELS],
                int maxchan,
                double quality,
-               int mode
+               int mode,
+               int shortLen   /* short block length */
               );
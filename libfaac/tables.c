@@ -0,0 +1,154 @@
+/****************************************************************************
+    Tables shared by all encoder instances
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+****************************************************************************/
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <math.h>
+#include <stdlib.h>
+#include "tables.h"
+#include "filtbank.h"
+#include "util.h"
+
+#ifdef HAVE_PTHREAD
+#include <pthread.h>
+
+static pthread_mutex_t tablesLock = PTHREAD_MUTEX_INITIALIZER;
+
+static void Lock(void) { pthread_mutex_lock(&tablesLock); }
+static void Unlock(void) { pthread_mutex_unlock(&tablesLock); }
+
+#elif defined(_WIN32)
+#include <windows.h>
+
+static volatile LONG tablesLock = 0;
+
+static void Lock(void)
+{
+    while (InterlockedCompareExchange(&tablesLock, 1, 0))
+        Sleep(0);
+}
+static void Unlock(void) { InterlockedExchange(&tablesLock, 0); }
+
+#else
+
+static void Lock(void) {}
+static void Unlock(void) {}
+
+#endif
+
+/* tables in use, one entry per transform length */
+static SharedTables *tablesList = NULL;
+
+static void TablesFree(SharedTables *tables)
+{
+    MDCTEnd(&tables->mdctInfo);
+    fft_terminate(&tables->fft_tables);
+
+    if (tables->sin_window_long) FreeMemory(tables->sin_window_long);
+    if (tables->sin_window_short) FreeMemory(tables->sin_window_short);
+    if (tables->kbd_window_long) FreeMemory(tables->kbd_window_long);
+    if (tables->kbd_window_short) FreeMemory(tables->kbd_window_short);
+    if (tables->hann_window_short) FreeMemory(tables->hann_window_short);
+
+    FreeMemory(tables);
+}
+
+static SharedTables *TablesBuild(int frameLen)
+{
+    SharedTables *tables = (SharedTables *)AllocMemory(sizeof(SharedTables));
+    int shortLen = frameLen / MAX_SHORT_WINDOWS;
+    int i;
+
+    if (!tables)
+        return NULL;
+    SetMemory(tables, 0, sizeof(SharedTables));
+    tables->frameLen = frameLen;
+
+    CPUKernelsInit(&tables->kernels);
+    fft_initialize(&tables->fft_tables, &tables->kernels, frameLen);
+    MDCTInit(&tables->mdctInfo, &tables->fft_tables, &tables->kernels, frameLen);
+
+    FilterBankWindows(tables);
+
+    tables->hann_window_short = (faac_real *)AllocMemory(2 * shortLen * sizeof(faac_real));
+    if (!tables->hann_window_short)
+    {
+        TablesFree(tables);
+        return NULL;
+    }
+    for (i = 0; i < shortLen * 2; i++)
+        tables->hann_window_short[i] = 0.5 * (1 - cos(2.0 * M_PI * (i + 0.5) /
+                                                      (shortLen * 2)));
+
+    return tables;
+}
+
+SharedTables *TablesAcquire(int frameLen)
+{
+    SharedTables *tables;
+
+    Lock();
+
+    for (tables = tablesList; tables; tables = tables->next)
+    {
+        if (tables->frameLen == frameLen)
+            break;
+    }
+
+    if (!tables)
+    {
+        tables = TablesBuild(frameLen);
+        if (tables)
+        {
+            tables->next = tablesList;
+            tablesList = tables;
+        }
+    }
+
+    if (tables)
+        tables->refs++;
+
+    Unlock();
+
+    return tables;
+}
+
+void TablesRelease(SharedTables *tables)
+{
+    SharedTables **link;
+
+    if (!tables)
+        return;
+
+    Lock();
+
+    if (--tables->refs)
+    {
+        Unlock();
+        return;
+    }
+
+    for (link = &tablesList; *link != tables; link = &(*link)->next)
+        ;
+    *link = tables->next;
+
+    Unlock();
+
+    TablesFree(tables);
+}
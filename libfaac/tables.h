@@ -0,0 +1,55 @@
+/****************************************************************************
+    Tables shared by all encoder instances
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+****************************************************************************/
+
+#ifndef TABLES_H
+#define TABLES_H
+
+#include "coder.h"
+#include "cpu.h"
+#include "fft.h"
+#include "mdct.h"
+
+/* Everything that only depends on the transform length. Built on first
+   use, shared by the encoders of the process and never written after. */
+typedef struct SharedTables
+{
+    int frameLen;
+    int refs;
+
+    /* CPU specific kernels, used by the transforms below, the filterbank
+       windowing and the quantizer */
+    CPUKernels kernels;
+    FFT_Tables fft_tables;
+    MDCTInfo mdctInfo;
+
+    /* filterbank windows, rising half */
+    faac_real *sin_window_long;
+    faac_real *sin_window_short;
+    faac_real *kbd_window_long;
+    faac_real *kbd_window_short;
+
+    /* whole short Hann window of the psychoacoustic transform */
+    faac_real *hann_window_short;
+
+    struct SharedTables *next;
+} SharedTables;
+
+/* take a reference on the tables for frameLen, NULL if out of memory */
+SharedTables *TablesAcquire(int frameLen);
+void TablesRelease(SharedTables *tables);
+
+#endif
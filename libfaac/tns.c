@@ -62,20 +62,20 @@ static unsigned short tnsMaxOrderShortMainLow = 7;
 /*************************/
 static void Autocorrelation(int maxOrder,        /* Maximum autocorr order */
                      int dataSize,        /* Size of the data array */
-                     double* data,        /* Data array */
+                     faac_real* data,     /* Data array */
                      double* rArray);     /* Autocorrelation array */
 
 static double LevinsonDurbin(int maxOrder,        /* Maximum filter order */
                       int dataSize,        /* Size of the data array */
-                      double* data,        /* Data array */
+                      faac_real* data,     /* Data array */
                       double* kArray);     /* Reflection coeff array */
 
 static void StepUp(int fOrder, double* kArray, double* aArray);
 
 static void QuantizeReflectionCoeffs(int fOrder,int coeffRes,double* rArray,int* indexArray);
 static int TruncateCoeffs(int fOrder,double threshold,double* kArray);
-static void TnsFilter(int length,double* spec,TnsFilterData* filter);
-static void TnsInvFilter(int length,double* spec,TnsFilterData* filter);
+static void TnsFilter(int length,faac_real* spec,TnsFilterData* filter);
+static void TnsInvFilter(int length,faac_real* spec,TnsFilterData* filter);
 
 
 /*****************************************************/
@@ -133,7 +133,7 @@ void TnsEncode(TnsInfo* tnsInfo,       /* TNS info */
                int maxSfb,              /* max_sfb */
                enum WINDOW_TYPE blockType,   /* block type */
                int* sfbOffsetTable,     /* Scalefactor band offset table */
-               double* spec)            /* Spectral data array */
+               faac_real* spec)         /* Spectral data array */
 {
     int numberOfWindows,windowSize;
     int startBand,stopBand,order;    /* Bands over which to apply TNS */
@@ -221,7 +221,7 @@ void TnsEncodeFilterOnly(TnsInfo* tnsInfo,           /* TNS info */
                          int maxSfb,                 /* max_sfb */
                          enum WINDOW_TYPE blockType, /* block type */
                          int* sfbOffsetTable,        /* Scalefactor band offset table */
-                         double* spec)               /* Spectral data array */
+                         faac_real* spec)            /* Spectral data array */
 {
     int numberOfWindows,windowSize;
     int startBand,stopBand;    /* Bands over which to apply TNS */
@@ -282,7 +282,7 @@ void TnsDecodeFilterOnly(TnsInfo* tnsInfo,           /* TNS info */
                          int maxSfb,                 /* max_sfb */
                          enum WINDOW_TYPE blockType, /* block type */
                          int* sfbOffsetTable,        /* Scalefactor band offset table */
-                         double* spec)               /* Spectral data array */
+                         faac_real* spec)            /* Spectral data array */
 {
     int numberOfWindows,windowSize;
     int startBand,stopBand;    /* Bands over which to apply TNS */
@@ -340,7 +340,7 @@ void TnsDecodeFilterOnly(TnsInfo* tnsInfo,           /* TNS info */
 /*   Not that the order and direction are specified  */
 /*   withing the TNS_FILTER_DATA structure.          */
 /*****************************************************/
-static void TnsFilter(int length,double* spec,TnsFilterData* filter)
+static void TnsFilter(int length,faac_real* spec,TnsFilterData* filter)
 {
     int i,j,k=0;
     int order=filter->order;
@@ -391,14 +391,12 @@ static void TnsFilter(int length,double* spec,TnsFilterData* filter)
 /*   Not that the order and direction are specified     */
 /*   withing the TNS_FILTER_DATA structure.             */
 /********************************************************/
-static void TnsInvFilter(int length,double* spec,TnsFilterData* filter)
+static void TnsInvFilter(int length,faac_real* spec,TnsFilterData* filter)
 {
     int i,j,k=0;
     int order=filter->order;
     double* a=filter->aCoeffs;
-    double* temp;
-
-    temp = (double *)AllocMemory(length * sizeof (double));
+    faac_real temp[BLOCK_LEN_LONG];    /* length never exceeds one long window */
 
     /* Determine loop parameters for given direction */
     if (filter->direction) {
@@ -441,7 +439,6 @@ static void TnsInvFilter(int length,double* spec,TnsFilterData* filter)
             }
         }
     }
-    if (temp) FreeMemory(temp);
 }
 
 
@@ -497,7 +494,7 @@ static void QuantizeReflectionCoeffs(int fOrder,
 /*****************************************************/
 static void Autocorrelation(int maxOrder,        /* Maximum autocorr order */
                      int dataSize,        /* Size of the data array */
-                     double* data,        /* Data array */
+                     faac_real* data,     /* Data array */
                      double* rArray)      /* Autocorrelation array */
 {
     int order,index;
@@ -521,7 +518,7 @@ static void Autocorrelation(int maxOrder,        /* Maximum autocorr order */
 /*****************************************************/
 static double LevinsonDurbin(int fOrder,          /* Filter order */
                       int dataSize,        /* Size of the data array */
-                      double* data,        /* Data array */
+                      faac_real* data,     /* Data array */
                       double* kArray)      /* Reflection coeff array */
 {
     int order,i;
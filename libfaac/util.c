@@ -21,7 +21,6 @@
 #include <math.h>
 
 #include "util.h"
-#include "coder.h"  // FRAME_LEN
 
 /* Returns the sample rate index */
 int GetSRIndex(unsigned int sampleRate)
@@ -42,10 +41,10 @@ int GetSRIndex(unsigned int sampleRate)
 }
 
 /* Returns the maximum bitrate for that sampling frequency */
-unsigned int MaxBitrate(unsigned long sampleRate)
+unsigned int MaxBitrate(unsigned long sampleRate, int frameLen)
 {
     /* max ADTS frame size 8k */
-    return 0x2000 * 8 * (double)sampleRate/(double)FRAME_LEN;
+    return 0x2000 * 8 * (double)sampleRate/(double)frameLen;
 }
 
 /* Returns the minimum bitrate per channel for that sampling frequency */
@@ -75,7 +74,7 @@ unsigned int BitAllocation(double pe, int short_block)
 }
 
 /* Returns the maximum bit reservoir size */
-unsigned int MaxBitresSize(unsigned long bitRate, unsigned long sampleRate)
+unsigned int MaxBitresSize(unsigned long bitRate, unsigned long sampleRate, int frameLen)
 {
-    return 6144 - (unsigned int)((double)bitRate/(double)sampleRate*(double)FRAME_LEN);
+    return 6144 - (unsigned int)((double)bitRate/(double)sampleRate*(double)frameLen);
 }
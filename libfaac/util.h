@@ -47,9 +47,9 @@ extern "C" {
 
 int GetSRIndex(unsigned int sampleRate);
 int GetMaxPredSfb(int samplingRateIdx);
-unsigned int MaxBitrate(unsigned long sampleRate);
+unsigned int MaxBitrate(unsigned long sampleRate, int frameLen);
 unsigned int MinBitrate();
-unsigned int MaxBitresSize(unsigned long bitRate, unsigned long sampleRate);
+unsigned int MaxBitresSize(unsigned long bitRate, unsigned long sampleRate, int frameLen);
 unsigned int BitAllocation(double pe, int short_block);
 
 #ifdef __cplusplus
@@ -0,0 +1,161 @@
+/****************************************************************************
+    Test: no heap allocation after the first frame
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+****************************************************************************/
+
+/*
+ * The library is linked statically with malloc(), calloc() and realloc()
+ * wrapped (ld --wrap), so every allocation it makes is counted. Once the
+ * first faacEncEncode() call returned, the encoder must not allocate any
+ * more, with long and short blocks, single threaded, on worker threads and
+ * pipelined, up to the end of the flush.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <faac.h>
+
+#include "signal.h"
+
+void *__real_malloc(size_t size);
+void *__real_calloc(size_t n, size_t size);
+void *__real_realloc(void *ptr, size_t size);
+
+static volatile int counting;
+static volatile long allocs;
+
+void *__wrap_malloc(size_t size)
+{
+    if (counting)
+        allocs++;
+    return __real_malloc(size);
+}
+
+void *__wrap_calloc(size_t n, size_t size)
+{
+    if (counting)
+        allocs++;
+    return __real_calloc(n, size);
+}
+
+void *__wrap_realloc(void *ptr, size_t size)
+{
+    if (counting)
+        allocs++;
+    return __real_realloc(ptr, size);
+}
+
+typedef struct
+{
+    const char *name;
+    int signal;
+    int shortctl;
+    int tns;
+    int threads;
+    int pipeline;
+} testcase_t;
+
+static const testcase_t cases[] = {
+    {"long and short blocks", SIGNAL_MUSIC, SHORTCTL_NORMAL, 0, 1, 0},
+    {"short blocks only", SIGNAL_CLICKS, SHORTCTL_NOLONG, 1, 1, 0},
+    {"long blocks, tns", SIGNAL_TONES, SHORTCTL_NOSHORT, 1, 1, 0},
+    {"long and short blocks, 4 threads", SIGNAL_MUSIC, SHORTCTL_NORMAL, 1, 4, 0},
+    {"short blocks only, 4 threads", SIGNAL_CLICKS, SHORTCTL_NOLONG, 0, 4, 0},
+    {"long and short blocks, pipelined", SIGNAL_MUSIC, SHORTCTL_NORMAL, 0, 1, 1},
+};
+
+enum {RATE = 44100, CHANNELS = 2, FRAMES = 40};
+
+/* allocations after the first frame, -1 if the case can not run here,
+   -2 if encoding failed */
+static long run(const testcase_t *tc)
+{
+    faacEncHandle enc;
+    faacEncConfigurationPtr config;
+    unsigned long inputSamples, maxBytes;
+    float *pcm;
+    unsigned char *out;
+    long pos = 0, result = -1;
+    int frame;
+
+    counting = 0;
+    allocs = 0;
+
+    enc = faacEncOpen(RATE, CHANNELS, &inputSamples, &maxBytes);
+    if (!enc)
+        return -1;
+
+    config = faacEncGetCurrentConfiguration(enc);
+    config->inputFormat = FAAC_INPUT_FLOAT;
+    config->outputFormat = ADTS_STREAM;
+    config->shortctl = tc->shortctl;
+    config->useTns = tc->tns;
+    config->quantqual = 100;
+    pcm = malloc(inputSamples * sizeof(*pcm));
+    out = malloc(maxBytes);
+
+    if (!pcm || !out || !faacEncSetConfiguration(enc, config)
+        || (tc->threads > 1 && !faacEncSetThreads(enc, tc->threads))
+        || (tc->pipeline && !faacEncSetPipeline(enc, 1)))
+        goto end;
+
+    result = -2;
+    for (frame = 0; frame < FRAMES; frame++)
+    {
+        int n = inputSamples / CHANNELS;
+
+        signal_make(tc->signal, pcm, n, CHANNELS, RATE, pos);
+        pos += n;
+        if (faacEncEncode(enc, (int32_t *)pcm, inputSamples, out, maxBytes) < 0)
+            goto end;
+        counting = 1;
+    }
+    /* flush */
+    while (faacEncEncode(enc, NULL, 0, out, maxBytes) > 0)
+        ;
+
+    counting = 0;
+    result = allocs;
+
+end:
+    counting = 0;
+    free(pcm);
+    free(out);
+    faacEncClose(enc);
+
+    return result;
+}
+
+int main(void)
+{
+    unsigned int i;
+    int failed = 0;
+
+    for (i = 0; i < sizeof(cases) / sizeof(cases[0]); i++)
+    {
+        long n = run(&cases[i]);
+
+        if (n == -1)
+            printf("%s: skipped\n", cases[i].name);
+        else if (n == -2)
+            printf("%s: encoding failed\n", cases[i].name);
+        else
+            printf("%s: %ld allocations after the first frame\n", cases[i].name, n);
+        if (n > 0 || n == -2)
+            failed = 1;
+    }
+
+    return failed;
+}
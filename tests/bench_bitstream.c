@@ -0,0 +1,179 @@
+/****************************************************************************
+    Benchmark: bits per second of the bitstream writer
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+****************************************************************************/
+
+/*
+ * Writes frames of FRAMEBITS bits with PutBit() and with a copy of the
+ * byte by byte writer the bit cache replaced, and prints millions of bits
+ * and of calls per second of each. The fields are drawn beforehand from
+ * three mixes of lengths: side information, Huffman codewords and long
+ * escape fields. Both writers must give the same bytes.
+ */
+
+#include <stdio.h>
+#include <string.h>
+
+#include "bitstream.h"
+#include "util.h"
+#include "bench.h"
+
+enum {FIELDS = 4096, FRAMEBITS = 6144, FRAMEBYTES = FRAMEBITS / 8 + 8};
+
+typedef struct
+{
+    const char *name;
+    int minlen, maxlen;
+} mix_t;
+
+static const mix_t mixes[] = {
+    {"side info, 1-8 bits", 1, 8},
+    {"codewords, 1-19 bits", 1, 19},
+    {"escapes, 16-32 bits", 16, 32},
+};
+
+static unsigned long data[FIELDS];
+static int len[FIELDS];
+
+/* the writer before the bit cache, every byte zeroed when it is begun */
+static void old_WriteByte(BitStream *bitStream, unsigned long data, int numBit)
+{
+    long numUsed, idx;
+
+    idx = (bitStream->currentBit / BYTE_NUMBIT) % bitStream->size;
+    numUsed = bitStream->currentBit % BYTE_NUMBIT;
+    if (numUsed == 0)
+        bitStream->data[idx] = 0;
+    bitStream->data[idx] |= (data & ((1<<numBit)-1)) <<
+        (BYTE_NUMBIT-numUsed-numBit);
+    bitStream->currentBit += numBit;
+    bitStream->numBit = bitStream->currentBit;
+}
+
+static void old_PutBit(BitStream *bitStream, unsigned long data, int numBit)
+{
+    int num, maxNum, curNum;
+    unsigned long bits;
+
+    if (numBit == 0)
+        return;
+
+    num = 0;
+    maxNum = BYTE_NUMBIT - bitStream->currentBit % BYTE_NUMBIT;
+    while (num < numBit) {
+        curNum = min(numBit-num,maxNum);
+        bits = data>>(numBit-num-curNum);
+        old_WriteByte(bitStream, bits, curNum);
+        num += curNum;
+        maxNum = BYTE_NUMBIT;
+    }
+}
+
+/* one frame from field *next on, the number of bytes; counts the calls
+   and bits */
+static int frame(int old, unsigned char *buf, int *next, long *calls,
+                 long *total)
+{
+    BitStream bs;
+    int i = *next;
+    long bits = 0;
+
+    OpenBitStream(&bs, FRAMEBYTES, buf);
+    while (bits < FRAMEBITS)
+    {
+        if (old)
+            old_PutBit(&bs, data[i], len[i]);
+        else
+            PutBit(&bs, data[i], len[i]);
+        bits += len[i];
+        i = (i + 1) % FIELDS;
+        (*calls)++;
+    }
+    *next = i;
+    *total += bits;
+
+    if (old)
+        return (bs.numBit + 7) / 8;
+    return CloseBitStream(&bs);
+}
+
+int main(void)
+{
+    static unsigned char buf[2][FRAMEBYTES];
+    uint32_t seed = 1;
+    unsigned int m;
+    int failed = 0;
+    int i;
+
+    printf("%-22s %12s %12s %12s %12s\n", "fields", "old Mbit/s",
+           "new Mbit/s", "old Mcall/s", "new Mcall/s");
+
+    for (m = 0; m < sizeof(mixes) / sizeof(mixes[0]); m++)
+    {
+        double mbits[2], mcalls[2];
+        int old, next;
+
+        for (i = 0; i < FIELDS; i++)
+        {
+            int span = mixes[m].maxlen - mixes[m].minlen + 1;
+
+            seed = seed * 1664525 + 1013904223;
+            len[i] = mixes[m].minlen + (seed >> 8) % span;
+            seed = seed * 1664525 + 1013904223;
+            data[i] = seed & (len[i] < 32 ? (1ul << len[i]) - 1 : 0xfffffffful);
+        }
+
+        /* the same bytes for some frames */
+        for (next = 0, i = 0; i < 64; i++)
+        {
+            long calls = 0, total = 0;
+            int from = next, n0, n1;
+
+            n0 = frame(0, buf[0], &next, &calls, &total);
+            n1 = frame(1, buf[1], &from, &calls, &total);
+            if (n0 != n1 || memcmp(buf[0], buf[1], n0))
+            {
+                printf("%s: the writers differ\n", mixes[m].name);
+                failed = 1;
+                break;
+            }
+        }
+
+        /* each for at least 0.2 s */
+        for (old = 0; old < 2; old++)
+        {
+            long count = 64, calls = 0, total = 0, f;
+            double start = bench_clock(), elapsed;
+
+            next = 0;
+            do
+            {
+                for (f = 0; f < count; f++)
+                    frame(old, buf[old], &next, &calls, &total);
+                count *= 2;
+                elapsed = bench_clock() - start;
+            }
+            while (elapsed < 0.2);
+
+            mbits[old] = total / elapsed * 1e-6;
+            mcalls[old] = calls / elapsed * 1e-6;
+        }
+
+        printf("%-22s %12.0f %12.0f %12.1f %12.1f\n", mixes[m].name,
+               mbits[1], mbits[0], mcalls[1], mcalls[0]);
+    }
+
+    return failed;
+}
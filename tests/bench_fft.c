@@ -0,0 +1,298 @@
+/****************************************************************************
+    Benchmark: the radix-4 FFT against the radix-2 FFT it replaced
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+****************************************************************************/
+
+/*
+ * Times the old split array radix-2 fft(), the new fft() and cfft() at
+ * logm 6 (short windows) and 9 (long windows) in ns per call, on the
+ * kernels of the CPU. The fft() times include copying the input back, the
+ * transforms work in place. It also prints the largest error of each
+ * against a plain DFT in double and the largest difference between the old
+ * and the new one, relative to the largest output value.
+ */
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "fft.h"
+#include "bench.h"
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+enum {SIZE = 1 << MAXLOGM};
+
+static const int logms[] = {6, 9};
+
+/* the radix-2 FFT before the radix-4 one, tables built up front */
+typedef struct
+{
+    float *costbl[MAXLOGM + 1];
+    float *negsintbl[MAXLOGM + 1];
+    unsigned short *reordertbl[MAXLOGM + 1];
+} old_tables;
+
+static void old_initialize(old_tables *t, int logm)
+{
+    int size = 1 << logm;
+    int i;
+
+    t->costbl[logm] = malloc((size / 2) * sizeof(*t->costbl[0]));
+    t->negsintbl[logm] = malloc((size / 2) * sizeof(*t->negsintbl[0]));
+    t->reordertbl[logm] = malloc(size * sizeof(*t->reordertbl[0]));
+
+    for (i = 0; i < (size >> 1); i++)
+    {
+        double theta = 2.0 * M_PI * ((double) i) / (double) size;
+        t->costbl[logm][i] = cos(theta);
+        t->negsintbl[logm][i] = -sin(theta);
+    }
+
+    for (i = 0; i < size; i++)
+    {
+        int reversed = 0;
+        int b0;
+        int tmp = i;
+
+        for (b0 = 0; b0 < logm; b0++)
+        {
+            reversed = (reversed << 1) | (tmp & 1);
+            tmp >>= 1;
+        }
+        t->reordertbl[logm][i] = reversed;
+    }
+}
+
+static void old_terminate(old_tables *t, int logm)
+{
+    free(t->costbl[logm]);
+    free(t->negsintbl[logm]);
+    free(t->reordertbl[logm]);
+}
+
+static void old_reorder(old_tables *t, faac_real *x, int logm)
+{
+    unsigned short *r = t->reordertbl[logm];
+    int size = 1 << logm;
+    int i;
+
+    for (i = 0; i < size; i++)
+    {
+        int j = r[i];
+        faac_real tmp;
+
+        if (j <= i)
+            continue;
+
+        tmp = x[i];
+        x[i] = x[j];
+        x[j] = tmp;
+    }
+}
+
+static void old_fft_proc(faac_real *xr, faac_real *xi,
+                         float *refac, float *imfac, int size)
+{
+    int step, shift, pos;
+    int exp, estep;
+
+    estep = size;
+    for (step = 1; step < size; step *= 2)
+    {
+        int x1;
+        int x2 = 0;
+        estep >>= 1;
+        for (pos = 0; pos < size; pos += (2 * step))
+        {
+            x1 = x2;
+            x2 += step;
+            exp = 0;
+            for (shift = 0; shift < step; shift++)
+            {
+                faac_real v2r, v2i;
+
+                v2r = xr[x2] * refac[exp] - xi[x2] * imfac[exp];
+                v2i = xr[x2] * imfac[exp] + xi[x2] * refac[exp];
+
+                xr[x2] = xr[x1] - v2r;
+                xr[x1] += v2r;
+
+                xi[x2] = xi[x1] - v2i;
+
+                xi[x1] += v2i;
+
+                exp += estep;
+
+                x1++;
+                x2++;
+            }
+        }
+    }
+}
+
+static void old_fft(old_tables *t, faac_real *xr, faac_real *xi, int logm)
+{
+    old_reorder(t, xr, logm);
+    old_reorder(t, xi, logm);
+
+    old_fft_proc(xr, xi, t->costbl[logm], t->negsintbl[logm], 1 << logm);
+}
+
+/* largest |a - b| over n complex values, a interleaved, b split */
+static double maxdiff(const double *a, const faac_real *re, const faac_real *im,
+                      int stride, int n)
+{
+    double m = 0;
+    int i;
+
+    for (i = 0; i < n; i++)
+    {
+        double dr = fabs(a[2 * i] - re[i * stride]);
+        double di = fabs(a[2 * i + 1] - im[i * stride]);
+
+        if (dr > m)
+            m = dr;
+        if (di > m)
+            m = di;
+    }
+
+    return m;
+}
+
+int main(void)
+{
+    static faac_real re[SIZE], im[SIZE], xr[SIZE], xi[SIZE];
+    static faac_real in[2 * SIZE], out[2 * SIZE], oldr[SIZE], oldi[SIZE];
+    static double ref[2 * SIZE], oldc[2 * SIZE];
+    CPUKernels kernels;
+    FFT_Tables tables;
+    old_tables old;
+    unsigned int l;
+    int i, k;
+
+    CPUKernelsInit(&kernels);
+    fft_initialize(&tables, &kernels, 1024);
+
+    printf("%-5s %10s %10s %10s %12s %12s %12s %12s\n", "logm",
+           "old fft", "new fft", "cfft", "old error", "new error",
+           "cfft error", "old - new");
+
+    for (l = 0; l < sizeof(logms) / sizeof(logms[0]); l++)
+    {
+        int logm = logms[l];
+        int n = 1 << logm;
+        double ns[3], peak = 0;
+        double eold, enew, ecfft, change;
+        int t;
+
+        old_initialize(&old, logm);
+
+        srand(1);
+        for (i = 0; i < n; i++)
+        {
+            re[i] = in[2 * i] = rand() / (double)RAND_MAX - 0.5;
+            im[i] = in[2 * i + 1] = rand() / (double)RAND_MAX - 0.5;
+        }
+
+        /* plain DFT in double */
+        for (k = 0; k < n; k++)
+        {
+            double sr = 0, si = 0;
+
+            for (i = 0; i < n; i++)
+            {
+                double a = -2 * M_PI * (double)((long)i * k % n) / n;
+
+                sr += re[i] * cos(a) - im[i] * sin(a);
+                si += re[i] * sin(a) + im[i] * cos(a);
+            }
+            ref[2 * k] = sr;
+            ref[2 * k + 1] = si;
+            if (fabs(sr) > peak)
+                peak = fabs(sr);
+            if (fabs(si) > peak)
+                peak = fabs(si);
+        }
+
+        memcpy(oldr, re, n * sizeof(*re));
+        memcpy(oldi, im, n * sizeof(*im));
+        old_fft(&old, oldr, oldi, logm);
+        memcpy(xr, re, n * sizeof(*re));
+        memcpy(xi, im, n * sizeof(*im));
+        fft(&tables, xr, xi, logm);
+        cfft(&tables, out, in, logm);
+
+        eold = maxdiff(ref, oldr, oldi, 1, n) / peak;
+        enew = maxdiff(ref, xr, xi, 1, n) / peak;
+        ecfft = maxdiff(ref, out, out + 1, 2, n) / peak;
+        for (i = 0; i < n; i++)
+        {
+            oldc[2 * i] = oldr[i];
+            oldc[2 * i + 1] = oldi[i];
+        }
+        change = maxdiff(oldc, xr, xi, 1, n) / peak;
+
+        /* each for at least 0.2 s */
+        for (t = 0; t < 3; t++)
+        {
+            long reps = 0, count = 64;
+            double start = bench_clock(), elapsed;
+
+            do
+            {
+                long r;
+
+                for (r = 0; r < count; r++)
+                {
+                    switch (t)
+                    {
+                    case 0:
+                        memcpy(xr, re, n * sizeof(*re));
+                        memcpy(xi, im, n * sizeof(*im));
+                        old_fft(&old, xr, xi, logm);
+                        break;
+                    case 1:
+                        memcpy(xr, re, n * sizeof(*re));
+                        memcpy(xi, im, n * sizeof(*im));
+                        fft(&tables, xr, xi, logm);
+                        break;
+                    default:
+                        cfft(&tables, out, in, logm);
+                        break;
+                    }
+                }
+                reps += count;
+                count *= 2;
+                elapsed = bench_clock() - start;
+            }
+            while (elapsed < 0.2);
+
+            ns[t] = elapsed * 1e9 / reps;
+        }
+
+        printf("%-5d %10.0f %10.0f %10.0f %12.2e %12.2e %12.2e %12.2e\n",
+               logm, ns[0], ns[1], ns[2], eold, enew, ecfft, change);
+
+        old_terminate(&old, logm);
+    }
+
+    fft_terminate(&tables);
+
+    return 0;
+}
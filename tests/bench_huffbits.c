@@ -0,0 +1,242 @@
+/****************************************************************************
+    Benchmark: Huffman bit counting of the bands
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+****************************************************************************/
+
+/*
+ * huffbook() is wrapped (ld --wrap) to keep a copy of every band the
+ * quantizer hands it while the corpus is encoded. The bands are then
+ * counted again: by huffbook(), which adds up the packed lengths of both
+ * books of a pair at once, and by counting codeword by codeword and book
+ * by book as huffcode() does, for the same books. It prints the time per
+ * band and coefficients per second of both, which must agree on every
+ * count.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <faac.h>
+
+#include "huff2.h"
+#include "huffdata.h"
+#include "bench.h"
+#include "signal.h"
+
+enum {RATE = 44100, CHANNELS = 2, SECONDS = 5, MAXBANDS = 1 << 20, MAXCOEFS = 1 << 23};
+
+int __real_huffbook(CoderInfo *coder, HuffSect *sect, int *qs, int len);
+
+/* the bands seen, one after the other */
+static int *coefs;
+static long ncoefs;
+static int *bandlen;
+static long nbands;
+
+int __wrap_huffbook(CoderInfo *coder, HuffSect *sect, int *qs, int len)
+{
+    if (nbands < MAXBANDS && ncoefs + len <= MAXCOEFS)
+    {
+        memcpy(coefs + ncoefs, qs, len * sizeof(*qs));
+        ncoefs += len;
+        bandlen[nbands++] = len;
+    }
+
+    return __real_huffbook(coder, sect, qs, len);
+}
+
+/* bits of qs in book 1 to 10 codeword by codeword, sign bits included */
+static int count(const int *qs, int len, int bnum)
+{
+    static const hcode16_t *const hmap[11] = {0, book01, book02, book03,
+      book04, book05, book06, book07, book08, book09, book10};
+    const hcode16_t *book = hmap[bnum];
+    int bits = 0;
+    int ofs, cnt;
+
+    switch (bnum)
+    {
+    case 1:
+    case 2:
+        for (ofs = 0; ofs < len; ofs += 4)
+            bits += book[27 * qs[ofs] + 9 * qs[ofs + 1] + 3 * qs[ofs + 2]
+                         + qs[ofs + 3] + 40].len;
+        break;
+    case 3:
+    case 4:
+        for (ofs = 0; ofs < len; ofs += 4)
+        {
+            bits += book[27 * abs(qs[ofs]) + 9 * abs(qs[ofs + 1])
+                         + 3 * abs(qs[ofs + 2]) + abs(qs[ofs + 3])].len;
+            for (cnt = 0; cnt < 4; cnt++)
+                if (qs[ofs + cnt])
+                    bits++;
+        }
+        break;
+    case 5:
+    case 6:
+        for (ofs = 0; ofs < len; ofs += 2)
+            bits += book[9 * qs[ofs] + qs[ofs + 1] + 40].len;
+        break;
+    default:
+        for (ofs = 0; ofs < len; ofs += 2)
+        {
+            int radix = (bnum < 9) ? 8 : 13;
+
+            bits += book[radix * abs(qs[ofs]) + abs(qs[ofs + 1])].len;
+            for (cnt = 0; cnt < 2; cnt++)
+                if (qs[ofs + cnt])
+                    bits++;
+        }
+        break;
+    }
+
+    return bits;
+}
+
+/* the first book of the band, as huffbook() chooses it */
+static int bookmin(const int *qs, int len)
+{
+    static const int book[13] = {HCB_ZERO, 1, 3, 5, 5, 7, 7, 7, 9, 9, 9, 9, 9};
+    int maxq = 0;
+    int cnt;
+
+    for (cnt = 0; cnt < len; cnt++)
+    {
+        int q = abs(qs[cnt]);
+        if (maxq < q)
+            maxq = q;
+    }
+
+    return (maxq < 13) ? book[maxq] : HCB_ESC;
+}
+
+/* every band through huffbook() or counted book by book, the number of
+   bands that differ in the first case */
+static long pass(int old, int bits[][HCB_ESC + 1])
+{
+    static CoderInfo coder;
+    static HuffSect sect;
+    const int *qs = coefs;
+    long band, differ = 0;
+    int book;
+
+    sect.band0 = 0;
+    for (band = 0; band < nbands; qs += bandlen[band++])
+    {
+        int len = bandlen[band];
+
+        if (old)
+        {
+            int first = bookmin(qs, len);
+
+            if (first > HCB_ZERO)
+                for (book = first; book < HCB_ESC; book++)
+                    bits[band][book] = count(qs, len, book);
+            continue;
+        }
+
+        coder.bandcnt = 0;
+        __real_huffbook(&coder, &sect, (int *)qs, len);
+        if (coder.book[0] > HCB_ZERO)
+            for (book = coder.book[0]; book < HCB_ESC; book++)
+                if (bits && sect.bits[0][book] != bits[band][book])
+                {
+                    differ++;
+                    break;
+                }
+    }
+
+    return differ;
+}
+
+int main(void)
+{
+    int (*bits)[HCB_ESC + 1];
+    double ns[2];
+    long differ;
+    int old, sig;
+
+    coefs = malloc(MAXCOEFS * sizeof(*coefs));
+    bandlen = malloc(MAXBANDS * sizeof(*bandlen));
+    if (!coefs || !bandlen)
+        return 1;
+
+    for (sig = 0; sig < SIGNAL_COUNT; sig++)
+    {
+        unsigned long inputSamples, maxBytes;
+        faacEncHandle enc = faacEncOpen(RATE, CHANNELS, &inputSamples, &maxBytes);
+        faacEncConfigurationPtr config;
+        float *pcm = malloc(inputSamples * sizeof(*pcm));
+        unsigned char *out = malloc(maxBytes);
+        long pos;
+
+        if (!enc || !pcm || !out)
+            return 1;
+        config = faacEncGetCurrentConfiguration(enc);
+        config->inputFormat = FAAC_INPUT_FLOAT;
+        config->quantqual = 100;
+        if (!faacEncSetConfiguration(enc, config))
+            return 1;
+
+        for (pos = 0; pos < (long)SECONDS * RATE; pos += inputSamples / CHANNELS)
+        {
+            signal_make(sig, pcm, inputSamples / CHANNELS, CHANNELS, RATE, pos);
+            if (faacEncEncode(enc, (int32_t *)pcm, inputSamples, out, maxBytes) < 0)
+                return 1;
+        }
+
+        free(pcm);
+        free(out);
+        faacEncClose(enc);
+    }
+
+    bits = malloc(nbands * sizeof(*bits));
+    if (!bits)
+        return 1;
+
+    /* the counts of the old way first, to check the new one against */
+    pass(1, bits);
+    differ = pass(0, bits);
+
+    /* each for at least 0.5 s */
+    for (old = 0; old < 2; old++)
+    {
+        long reps = 0;
+        double start = bench_clock(), elapsed;
+
+        do
+        {
+            pass(old, old ? bits : NULL);
+            reps++;
+            elapsed = bench_clock() - start;
+        }
+        while (elapsed < 0.5);
+
+        ns[old] = elapsed * 1e9 / reps / nbands;
+    }
+
+    printf("%ld bands, %ld coefficients, %.1f per band\n", nbands, ncoefs,
+           (double)ncoefs / nbands);
+    printf("%-22s %10s %12s\n", "", "ns/band", "Mcoef/s");
+    printf("%-22s %10.1f %12.1f\n", "codeword by codeword", ns[1],
+           ncoefs / (ns[1] * nbands) * 1e3);
+    printf("%-22s %10.1f %12.1f\n", "packed pairs", ns[0],
+           ncoefs / (ns[0] * nbands) * 1e3);
+    if (differ)
+        printf("%ld bands counted differently\n", differ);
+
+    return differ != 0;
+}
@@ -0,0 +1,139 @@
+/****************************************************************************
+    Benchmark: quantizer passes and bitrate of the rate control
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+****************************************************************************/
+
+/*
+ * Meant for the DRM library, which codes a frame again until it fits the
+ * bitrate. OpenBitStream() is wrapped (ld --wrap) and called once per
+ * pass, so the calls per coded frame are the quantizer passes. For every
+ * signal of the corpus and a few rates it prints the passes per frame and
+ * the target against the achieved bitrate, the latter of the whole output,
+ * CRC bytes included. Other builds code every frame once and keep the
+ * bitrate on average only.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <faac.h>
+
+#include "bitstream.h"
+#include "signal.h"
+
+void __real_OpenBitStream(BitStream *bitStream, int size, unsigned char *buffer);
+
+static long passes;
+
+void __wrap_OpenBitStream(BitStream *bitStream, int size, unsigned char *buffer)
+{
+    passes++;
+    __real_OpenBitStream(bitStream, size, buffer);
+}
+
+typedef struct
+{
+    int rate;
+    int channels;
+    /* bits per second and channel */
+    int bitRate;
+} setting_t;
+
+static const setting_t settings[] = {
+    {22050, 2, 12000},
+    {48000, 1, 32000},
+    {48000, 1, 64000},
+    {44100, 2, 16000},
+    {44100, 2, 32000},
+};
+
+enum {SECONDS = 10};
+
+int main(void)
+{
+    unsigned int s;
+    int sig;
+
+    printf("%-8s %6s %3s %8s %8s %10s %10s\n", "signal", "rate", "ch",
+           "frames", "passes", "target", "achieved");
+
+    for (s = 0; s < sizeof(settings) / sizeof(settings[0]); s++)
+    {
+        const setting_t *set = &settings[s];
+
+        for (sig = 0; sig < SIGNAL_COUNT; sig++)
+        {
+            faacEncHandle enc;
+            faacEncConfigurationPtr config;
+            unsigned long inputSamples, maxBytes;
+            float *pcm;
+            unsigned char *out;
+            long pos = 0, total = (long)SECONDS * set->rate;
+            long frames = 0, bytes = 0;
+            int n;
+
+            enc = faacEncOpen(set->rate, set->channels, &inputSamples, &maxBytes);
+            if (!enc)
+                return 1;
+            config = faacEncGetCurrentConfiguration(enc);
+            config->inputFormat = FAAC_INPUT_FLOAT;
+            config->outputFormat = RAW_STREAM;
+            config->bitRate = set->bitRate;
+            config->bandWidth = 0;
+            pcm = malloc(inputSamples * sizeof(*pcm));
+            out = malloc(maxBytes);
+            if (!pcm || !out || !faacEncSetConfiguration(enc, config))
+                return 1;
+
+            passes = 0;
+            for (;;)
+            {
+                int samples = inputSamples / set->channels;
+
+                if (pos < total)
+                {
+                    if (samples > total - pos)
+                        samples = total - pos;
+                    signal_make(sig, pcm, samples, set->channels, set->rate, pos);
+                    pos += samples;
+                    n = faacEncEncode(enc, (int32_t *)pcm, samples * set->channels,
+                                      out, maxBytes);
+                }
+                else
+                {
+                    n = faacEncEncode(enc, NULL, 0, out, maxBytes);
+                    if (n <= 0)
+                        break;
+                }
+                if (n < 0)
+                    return 1;
+                if (n > 0)
+                {
+                    frames++;
+                    bytes += n;
+                }
+            }
+
+            printf("%-8s %6d %3d %8ld %8.2f %10d %10.0f\n", signal_name[sig],
+                   set->rate, set->channels, frames, (double)passes / frames,
+                   set->bitRate * set->channels, bytes * 8.0 / SECONDS);
+
+            free(pcm);
+            free(out);
+            faacEncClose(enc);
+        }
+    }
+
+    return 0;
+}
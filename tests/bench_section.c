@@ -0,0 +1,126 @@
+/****************************************************************************
+    Benchmark: bytes the choice of section books saves
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+****************************************************************************/
+
+/*
+ * huffsect() is wrapped (ld --wrap). For every window group it counts the
+ * section and spectral bits of the books it chooses and of the greedy
+ * choice it replaced: the cheaper book of the pair of each band, equal
+ * neighbours merged into sections. The scalefactors do not depend on the
+ * choice, so the difference is what the stream saves, up to the padding
+ * of the frames. The corpus is encoded in quality mode, where the saved
+ * bits are not spent on anything else, and the savings are printed per
+ * hour of audio.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <faac.h>
+
+#include "greedy.h"
+#include "signal.h"
+
+enum {RATE = 44100, CHANNELS = 2, SECONDS = 10};
+
+static const int qualities[] = {50, 100, 200};
+
+void __real_huffsect(CoderInfo *coder, HuffSect *sect);
+
+static long savedBits;
+/* groups the trellis codes in more bits than the greedy choice */
+static long worse;
+
+void __wrap_huffsect(CoderInfo *coder, HuffSect *sect)
+{
+    int greedy[NSFB_LONG];
+    long before, after;
+
+    greedy_books(coder, sect, greedy);
+    before = sect_cost(coder, sect, greedy);
+
+    __real_huffsect(coder, sect);
+
+    after = sect_cost(coder, sect, coder->book + sect->band0);
+    savedBits += before - after;
+    if (after > before)
+        worse++;
+}
+
+int main(void)
+{
+    unsigned int q;
+    int sig;
+
+    printf("%-8s %7s %10s %10s %8s %14s\n", "signal", "quality", "bytes",
+           "saved", "saved %", "saved per hour");
+
+    for (q = 0; q < sizeof(qualities) / sizeof(qualities[0]); q++)
+    {
+        long allBytes = 0, allSaved = 0;
+
+        for (sig = 0; sig < SIGNAL_COUNT; sig++)
+        {
+            unsigned long inputSamples, maxBytes;
+            faacEncHandle enc = faacEncOpen(RATE, CHANNELS, &inputSamples, &maxBytes);
+            faacEncConfigurationPtr config;
+            float *pcm = malloc(inputSamples * sizeof(*pcm));
+            unsigned char *out = malloc(maxBytes);
+            long pos, bytes = 0;
+            int n;
+
+            if (!enc || !pcm || !out)
+                return 1;
+            config = faacEncGetCurrentConfiguration(enc);
+            config->inputFormat = FAAC_INPUT_FLOAT;
+            config->quantqual = qualities[q];
+            config->bitRate = 0;
+            if (!faacEncSetConfiguration(enc, config))
+                return 1;
+
+            savedBits = 0;
+            for (pos = 0; pos < (long)SECONDS * RATE; pos += inputSamples / CHANNELS)
+            {
+                signal_make(sig, pcm, inputSamples / CHANNELS, CHANNELS, RATE, pos);
+                n = faacEncEncode(enc, (int32_t *)pcm, inputSamples, out, maxBytes);
+                if (n < 0)
+                    return 1;
+                bytes += n;
+            }
+            while ((n = faacEncEncode(enc, NULL, 0, out, maxBytes)) > 0)
+                bytes += n;
+
+            printf("%-8s %7d %10ld %10ld %8.2f %14.0f\n", signal_name[sig],
+                   qualities[q], bytes, savedBits / 8,
+                   100.0 * savedBits / (8 * bytes + savedBits),
+                   savedBits / 8.0 / SECONDS * 3600);
+            allBytes += bytes;
+            allSaved += savedBits;
+
+            free(pcm);
+            free(out);
+            faacEncClose(enc);
+        }
+
+        printf("%-8s %7d %10ld %10ld %8.2f %14.0f\n", "all", qualities[q],
+               allBytes, allSaved / 8, 100.0 * allSaved / (8 * allBytes + allSaved),
+               allSaved / 8.0 / (SECONDS * SIGNAL_COUNT) * 3600);
+    }
+
+    if (worse)
+        printf("%ld window groups cost more than the greedy choice\n", worse);
+
+    return worse != 0;
+}
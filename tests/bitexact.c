@@ -0,0 +1,205 @@
+/****************************************************************************
+    Test: threads, pipelining and the ladder do not change the output
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+****************************************************************************/
+
+/*
+ * Every stream is coded single threaded first. Coded again on worker
+ * threads, pipelined, both, and as the primary stream of a bitrate
+ * ladder of two more rungs, the frames must be the same to the bit. The
+ * streams are stereo and 5.1, which has more channel elements than
+ * threads, in quality and in average bitrate mode, where every frame
+ * depends on the ones before.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <faac.h>
+
+#include "signal.h"
+
+typedef struct
+{
+    const char *name;
+    int signal;
+    int channels;
+    /* per channel, 0 for quality mode */
+    int bitRate;
+} testcase_t;
+
+static const testcase_t cases[] = {
+    {"stereo, music, quality", SIGNAL_MUSIC, 2, 0},
+    {"stereo, clicks, 64 kbps", SIGNAL_CLICKS, 2, 64000},
+    {"5.1, music, 48 kbps", SIGNAL_MUSIC, 6, 48000},
+    {"5.1, sweep, quality", SIGNAL_SWEEP, 6, 0},
+};
+
+enum {MODE_SERIAL, MODE_THREADS, MODE_PIPELINE, MODE_BOTH, MODE_LADDER, MODES};
+
+static const char *modeName[MODES] = {
+    "serial", "4 threads", "pipelined", "4 threads, pipelined", "ladder"
+};
+
+enum {RATE = 44100, FRAMES = 40, RUNGS = 2};
+
+static faacEncHandle open_encoder(const testcase_t *tc, int bitRate,
+                                  unsigned long *inputSamples,
+                                  unsigned long *maxBytes)
+{
+    faacEncHandle enc = faacEncOpen(RATE, tc->channels, inputSamples, maxBytes);
+    faacEncConfigurationPtr config;
+
+    if (!enc)
+        return NULL;
+    config = faacEncGetCurrentConfiguration(enc);
+    config->inputFormat = FAAC_INPUT_FLOAT;
+    config->outputFormat = ADTS_STREAM;
+    config->bitRate = bitRate;
+    if (!faacEncSetConfiguration(enc, config))
+    {
+        faacEncClose(enc);
+        return NULL;
+    }
+
+    return enc;
+}
+
+/* the stream of tc in mode into stream, its size, -1 if the mode can not
+   run here, -2 if encoding failed */
+static long encode(const testcase_t *tc, int mode, unsigned char *stream,
+                   long streamSize)
+{
+    faacEncHandle enc, rung[RUNGS] = {NULL, NULL};
+    unsigned long inputSamples, maxBytes;
+    unsigned char *rungBuffer[RUNGS] = {NULL, NULL};
+    unsigned int rungSize[RUNGS];
+    int rungBytes[RUNGS];
+    float *pcm = NULL;
+    long size = -1;
+    int frame, i, n;
+
+    enc = open_encoder(tc, tc->bitRate, &inputSamples, &maxBytes);
+    if (!enc)
+        return -2;
+
+    if (((mode == MODE_THREADS || mode == MODE_BOTH) && !faacEncSetThreads(enc, 4))
+        || ((mode == MODE_PIPELINE || mode == MODE_BOTH) && !faacEncSetPipeline(enc, 1)))
+        goto end;
+
+    size = -2;
+    if (mode == MODE_LADDER)
+    {
+        for (i = 0; i < RUNGS; i++)
+        {
+            rung[i] = open_encoder(tc, 32000 >> i, &inputSamples, &maxBytes);
+            rungBuffer[i] = malloc(maxBytes);
+            rungSize[i] = maxBytes;
+            if (!rung[i] || !rungBuffer[i])
+                goto end;
+        }
+        if (!faacEncSetLadder(enc, rung, RUNGS))
+            goto end;
+    }
+
+    pcm = malloc(inputSamples * sizeof(*pcm));
+    if (!pcm)
+        goto end;
+
+    size = 0;
+    for (frame = 0; ; frame++)
+    {
+        unsigned int samples = frame < FRAMES ? inputSamples : 0;
+
+        if (size + (long)maxBytes > streamSize)
+        {
+            size = -2;
+            goto end;
+        }
+        signal_make(tc->signal, pcm, inputSamples / tc->channels, tc->channels,
+                    RATE, (long)frame * (inputSamples / tc->channels));
+        if (mode == MODE_LADDER)
+            n = faacEncEncodeLadder(enc, (int32_t *)pcm, samples, stream + size,
+                                    maxBytes, rungBuffer, rungSize, rungBytes);
+        else
+            n = faacEncEncode(enc, (int32_t *)pcm, samples, stream + size, maxBytes);
+        if (n < 0)
+        {
+            size = -2;
+            goto end;
+        }
+        if (!n && frame >= FRAMES)
+            break;
+        size += n;
+    }
+
+end:
+    free(pcm);
+    faacEncClose(enc);
+    for (i = 0; i < RUNGS; i++)
+    {
+        free(rungBuffer[i]);
+        if (rung[i])
+            faacEncClose(rung[i]);
+    }
+
+    return size;
+}
+
+int main(void)
+{
+    /* more than FRAMES + flush frames of the largest size */
+    const long streamSize = 64L << 20;
+    unsigned char *serial = malloc(streamSize);
+    unsigned char *stream = malloc(streamSize);
+    unsigned int i;
+    int mode, failed = 0;
+
+    if (!serial || !stream)
+        return 1;
+
+    for (i = 0; i < sizeof(cases) / sizeof(cases[0]); i++)
+    {
+        long size = encode(&cases[i], MODE_SERIAL, serial, streamSize);
+
+        if (size < 0)
+        {
+            printf("%s: encoding failed\n", cases[i].name);
+            failed = 1;
+            continue;
+        }
+
+        for (mode = MODE_SERIAL + 1; mode < MODES; mode++)
+        {
+            long n = encode(&cases[i], mode, stream, streamSize);
+
+            if (n == -1)
+                printf("%s, %s: skipped\n", cases[i].name, modeName[mode]);
+            else if (n == -2)
+                printf("%s, %s: encoding failed\n", cases[i].name, modeName[mode]);
+            else if (n != size || memcmp(serial, stream, size))
+                printf("%s, %s: differs from serial\n", cases[i].name, modeName[mode]);
+            else
+                printf("%s, %s: %ld bytes, the same\n", cases[i].name, modeName[mode], n);
+            if (n == -2 || (n >= 0 && (n != size || memcmp(serial, stream, size))))
+                failed = 1;
+        }
+    }
+
+    free(serial);
+    free(stream);
+
+    return failed;
+}
@@ -0,0 +1,203 @@
+/****************************************************************************
+    Test: faacEncGetFootprint() and the tables shared between encoders
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+****************************************************************************/
+
+/*
+ * The heap functions are wrapped (ld --wrap) to keep the number of live
+ * bytes. HANDLES encoders are opened at 1024 and then at 960 samples per
+ * frame, the first ones kept open meanwhile. For every handle the bytes
+ * it added must be its footprint, plus the tables of its frame length for
+ * the first handle of that length only. The tables must be what
+ * TablesAcquire() builds, and everything must be freed after the last
+ * handle is closed.
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <faac.h>
+
+#include "tables.h"
+
+void *__real_malloc(size_t size);
+void *__real_calloc(size_t n, size_t size);
+void *__real_realloc(void *ptr, size_t size);
+void __real_free(void *ptr);
+
+/* in front of every block, keeps the alignment of malloc() */
+#define HEAD 16
+
+static long live;
+
+void *__wrap_malloc(size_t size)
+{
+    char *p = __real_malloc(size + HEAD);
+
+    if (!p)
+        return NULL;
+    *(size_t *)p = size;
+    live += size;
+
+    return p + HEAD;
+}
+
+void *__wrap_calloc(size_t n, size_t size)
+{
+    char *p;
+
+    if (size && n > ((size_t)-1 - HEAD) / size)
+        return NULL;
+    p = __wrap_malloc(n * size);
+    if (p)
+        memset(p, 0, n * size);
+
+    return p;
+}
+
+void *__wrap_realloc(void *ptr, size_t size)
+{
+    char *p;
+    size_t old;
+
+    if (!ptr)
+        return __wrap_malloc(size);
+
+    p = (char *)ptr - HEAD;
+    old = *(size_t *)p;
+    p = __real_realloc(p, size + HEAD);
+    if (!p)
+        return NULL;
+    *(size_t *)p = size;
+    live += (long)size - (long)old;
+
+    return p + HEAD;
+}
+
+void __wrap_free(void *ptr)
+{
+    char *p;
+
+    if (!ptr)
+        return;
+
+    p = (char *)ptr - HEAD;
+    live -= *(size_t *)p;
+    __real_free(p);
+}
+
+enum {RATE = 44100, CHANNELS = 2, HANDLES = 8};
+
+static const unsigned int frameLens[] = {1024, 960};
+
+static faacEncHandle open_handle(unsigned int frameLen)
+{
+    unsigned long inputSamples, maxBytes;
+    faacEncHandle enc = faacEncOpen(RATE, CHANNELS, &inputSamples, &maxBytes);
+    faacEncConfigurationPtr config;
+
+    if (!enc)
+        return NULL;
+
+    /* ADTS can not signal 960 sample frames */
+    config = faacEncGetCurrentConfiguration(enc);
+    config->outputFormat = RAW_STREAM;
+    if (!faacEncSetConfiguration(enc, config) || !faacEncSetFrameLength(enc, frameLen))
+    {
+        faacEncClose(enc);
+        return NULL;
+    }
+
+    return enc;
+}
+
+int main(void)
+{
+    faacEncHandle enc[2][HANDLES];
+    long tables[2], footprints = 0;
+    long start = live, bytes;
+    unsigned int l;
+    int failed = 0;
+    int i;
+
+    printf("%6s %8s %10s %10s\n", "frame", "handle", "bytes", "footprint");
+
+    for (l = 0; l < 2; l++)
+    {
+        for (i = 0; i < HANDLES; i++)
+        {
+            long mark = live;
+            unsigned long footprint;
+
+            enc[l][i] = open_handle(frameLens[l]);
+            if (!enc[l][i])
+            {
+                printf("%u: can not open an encoder\n", frameLens[l]);
+                return 1;
+            }
+            bytes = live - mark;
+            footprint = faacEncGetFootprint(enc[l][i]);
+            footprints += footprint;
+
+            printf("%6u %8d %10ld %10lu\n", frameLens[l], i + 1, bytes, footprint);
+
+            /* the first handle of a frame length also builds its tables */
+            if (!i)
+                tables[l] = bytes - (long)footprint;
+            else if (bytes != (long)footprint)
+            {
+                printf("the footprint is not what the handle allocated\n");
+                failed = 1;
+            }
+        }
+    }
+
+    /* each table counted once */
+    bytes = live - start;
+    printf("all handles: %ld bytes, footprints %ld, tables %ld + %ld\n",
+           bytes, footprints, tables[0], tables[1]);
+    if (bytes != footprints + tables[0] + tables[1])
+    {
+        printf("the handles hold more than their footprints and one set of tables per frame length\n");
+        failed = 1;
+    }
+
+    for (l = 0; l < 2; l++)
+        for (i = 0; i < HANDLES; i++)
+            faacEncClose(enc[l][i]);
+    if (live != start)
+    {
+        printf("%ld bytes left after closing all handles\n", live - start);
+        failed = 1;
+    }
+
+    /* the part of the first handle that is not in its footprint is the
+       tables, built by the first handle only */
+    for (l = 0; l < 2; l++)
+    {
+        SharedTables *t = TablesAcquire(frameLens[l]);
+        long built = live - start;
+
+        printf("%u: tables %ld bytes\n", frameLens[l], built);
+        if (!t || built <= 0 || built != tables[l])
+        {
+            printf("the first handle of %u samples added %ld bytes besides its footprint\n",
+                   frameLens[l], tables[l]);
+            failed = 1;
+        }
+        TablesRelease(t);
+    }
+
+    return failed;
+}
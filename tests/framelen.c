@@ -0,0 +1,233 @@
+/****************************************************************************
+    Test: frame lengths, decoder specific info and delays
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+****************************************************************************/
+
+/*
+ * Every object type is set up at both of its frame lengths, LC with 1024
+ * and 960 samples, LD with 512 and 480, as raw MPEG-4 streams. The
+ * decoder specific info must be an AudioSpecificConfig of 2 bytes, 3 for
+ * LD, with the frameLengthFlag set for 960 and 480. The encoder must take
+ * frames of that length, hold back faacEncGetLatency() samples, none with
+ * LD, and return frames until the decoder output, faacEncGetDelay()
+ * samples late, covers the input.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <faac.h>
+
+#include "signal.h"
+
+typedef struct
+{
+    const char *name;
+    int objectType;
+    unsigned int frameLen;
+    /* the other length of the object type, and one of another type */
+    unsigned int otherLen;
+    unsigned int wrongLen;
+    /* frames held back */
+    unsigned int lookahead;
+} testcase_t;
+
+static const testcase_t cases[] = {
+    {"LC, 1024", LOW, 1024, 960, 512, 3},
+    {"LC, 960", LOW, 960, 1024, 480, 3},
+    {"LD, 512", LD, 512, 480, 1024, 0},
+    {"LD, 480", LD, 480, 512, 960, 0},
+};
+
+enum {RATE = 48000, RATEIDX = 3, CHANNELS = 2, FRAMES = 20};
+
+static const unsigned char *asc;
+static int ascpos;
+
+static unsigned int bits(int n)
+{
+    unsigned int v = 0;
+
+    while (n--)
+    {
+        v = (v << 1) | ((asc[ascpos >> 3] >> (7 - (ascpos & 7))) & 1);
+        ascpos++;
+    }
+
+    return v;
+}
+
+/* NULL if the AudioSpecificConfig is right, else what is wrong */
+static const char *check_asc(const testcase_t *tc, const unsigned char *buf,
+                             unsigned long size)
+{
+    int ld = tc->objectType == LD;
+
+    if (size != (ld ? 3 : 2))
+        return "size";
+    asc = buf;
+    ascpos = 0;
+    if (bits(5) != (unsigned int)tc->objectType)
+        return "object type";
+    if (bits(4) != RATEIDX)
+        return "sampling frequency index";
+    if (bits(4) != CHANNELS)
+        return "channel configuration";
+    if (bits(1) != (tc->frameLen == 960 || tc->frameLen == 480))
+        return "frameLengthFlag";
+    if (bits(1))
+        return "dependsOnCoreCoder";
+    /* extensionFlag, then for the ER object types the resilience flags,
+       extensionFlag3 and epConfig */
+    if (bits(1) != ld)
+        return "extensionFlag";
+    if (ld && bits(3 + 1 + 2))
+        return "resilience flags, extensionFlag3 or epConfig";
+    /* byte alignment */
+    if (bits((8 - (ascpos & 7)) & 7))
+        return "padding";
+
+    return NULL;
+}
+
+/* NULL if passed, else what failed */
+static const char *run(const testcase_t *tc)
+{
+    faacEncHandle enc;
+    faacEncConfigurationPtr config;
+    unsigned long inputSamples, maxBytes, ascSize;
+    unsigned char *ascBuf;
+    float *pcm;
+    unsigned char *out;
+    const char *err = "encoding failed";
+    unsigned int latency, delay, held = 0, frames = 0;
+    int n, i;
+
+    enc = faacEncOpen(RATE, CHANNELS, &inputSamples, &maxBytes);
+    if (!enc)
+        return "faacEncOpen() failed";
+
+    config = faacEncGetCurrentConfiguration(enc);
+    config->aacObjectType = tc->objectType;
+    config->mpegVersion = MPEG4;
+    config->outputFormat = RAW_STREAM;
+    config->inputFormat = FAAC_INPUT_FLOAT;
+    if (!faacEncSetConfiguration(enc, config))
+    {
+        faacEncClose(enc);
+        return "configuration refused";
+    }
+    if (faacEncSetFrameLength(enc, tc->wrongLen))
+    {
+        faacEncClose(enc);
+        return "frame length of another object type taken";
+    }
+    /* the other length first, it must be possible to change it back */
+    if (!faacEncSetFrameLength(enc, tc->otherLen)
+        || !faacEncSetFrameLength(enc, tc->frameLen))
+    {
+        faacEncClose(enc);
+        return "frame length refused";
+    }
+    if (faacEncGetFrameLength(enc) != tc->frameLen)
+    {
+        faacEncClose(enc);
+        return "faacEncGetFrameLength()";
+    }
+
+    if (faacEncGetDecoderSpecificInfo(enc, &ascBuf, &ascSize))
+    {
+        faacEncClose(enc);
+        return "faacEncGetDecoderSpecificInfo() failed";
+    }
+    err = check_asc(tc, ascBuf, ascSize);
+    free(ascBuf);
+    if (err)
+    {
+        faacEncClose(enc);
+        return err;
+    }
+
+    latency = faacEncGetLatency(enc);
+    delay = faacEncGetDelay(enc);
+    if (latency != tc->lookahead * tc->frameLen)
+    {
+        faacEncClose(enc);
+        return "faacEncGetLatency()";
+    }
+    /* the first frame overlaps a frame of silence */
+    if (delay != tc->frameLen)
+    {
+        faacEncClose(enc);
+        return "faacEncGetDelay()";
+    }
+
+    err = "encoding failed";
+    pcm = malloc(tc->frameLen * CHANNELS * sizeof(*pcm));
+    out = malloc(maxBytes);
+    if (!pcm || !out)
+        goto end;
+
+    for (i = 0; i < FRAMES; i++)
+    {
+        signal_make(SIGNAL_MUSIC, pcm, tc->frameLen, CHANNELS, RATE,
+                    (long)i * tc->frameLen);
+        n = faacEncEncode(enc, (int32_t *)pcm, tc->frameLen * CHANNELS, out, maxBytes);
+        if (n < 0)
+            goto end;
+        if (n)
+            frames++;
+        else if (!frames)
+            held++;
+    }
+    while ((n = faacEncEncode(enc, NULL, 0, out, maxBytes)) > 0)
+        frames++;
+    if (n < 0)
+        goto end;
+
+    err = NULL;
+    if (held * tc->frameLen != latency)
+        err = "frames held back";
+    else if (frames * tc->frameLen < FRAMES * tc->frameLen + delay
+             || (frames - 1) * tc->frameLen >= FRAMES * tc->frameLen + delay)
+        err = "frame count";
+    printf("%s: %u samples held back, %u frames for %u input frames\n",
+           tc->name, held * tc->frameLen, frames, FRAMES);
+
+end:
+    free(pcm);
+    free(out);
+    faacEncClose(enc);
+
+    return err;
+}
+
+int main(void)
+{
+    unsigned int i;
+    int failed = 0;
+
+    for (i = 0; i < sizeof(cases) / sizeof(cases[0]); i++)
+    {
+        const char *err = run(&cases[i]);
+
+        if (err)
+        {
+            printf("%s: %s\n", cases[i].name, err);
+            failed = 1;
+        }
+    }
+
+    return failed;
+}
@@ -0,0 +1,66 @@
+/****************************************************************************
+    Greedy section books, for the tests of huffsect()
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+****************************************************************************/
+
+#include "greedy.h"
+
+void greedy_books(const CoderInfo *coder, const HuffSect *sect, int *book)
+{
+    const int *chosen = coder->book + sect->band0;
+    int band;
+
+    for (band = 0; band < coder->sfbn; band++)
+    {
+        int k = chosen[band];
+
+        if (sect->qs[band])
+        {
+            /* the first book the band fits, or the next one if cheaper */
+            for (k = 1; sect->bits[band][k] < 0; k++)
+                ;
+            if (k < HCB_ESC && sect->bits[band][k + 1] < sect->bits[band][k])
+                k++;
+        }
+        book[band] = k;
+    }
+}
+
+long sect_cost(const CoderInfo *coder, const HuffSect *sect, const int *book)
+{
+    int maxcnt = 31, cntbits = 5;
+    long bits = 0;
+    int band = 0;
+
+    if (coder->block_type == ONLY_SHORT_WINDOW)
+    {
+        maxcnt = 7;
+        cntbits = 3;
+    }
+
+    while (band < coder->sfbn)
+    {
+        int b = book[band], cnt = 0;
+
+        for (; band < coder->sfbn && book[band] == b; band++, cnt++)
+        {
+            if (sect->qs[band])
+                bits += sect->bits[band][b];
+        }
+        bits += LEN_CB + (cnt / maxcnt + 1) * cntbits;
+    }
+
+    return bits;
+}
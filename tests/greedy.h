@@ -0,0 +1,32 @@
+/****************************************************************************
+    Greedy section books, for the tests of huffsect()
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+****************************************************************************/
+
+#ifndef GREEDY_H
+#define GREEDY_H
+
+#include "huff2.h"
+
+/* the books of a window group the greedy choice huffsect() replaced: the
+   cheaper book of the pair of each band, equal neighbours merged into
+   sections */
+void greedy_books(const CoderInfo *coder, const HuffSect *sect, int *book);
+
+/* section and spectral bits of the books of a window group, the section
+   data counted as writebooks() writes it */
+long sect_cost(const CoderInfo *coder, const HuffSect *sect, const int *book);
+
+#endif
@@ -0,0 +1,183 @@
+/****************************************************************************
+    Test: the CPU kernels of every level agree bit for bit
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+****************************************************************************/
+
+/*
+ * cpu.h promises that the stream does not depend on the CPU. Every kernel
+ * of every level the CPU runs is compared with the scalar one on random
+ * data, for the sizes the encoder uses and some odd ones.
+ */
+
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "cpu.h"
+#include "quantize.h"
+
+enum {MAXN = 2048};
+
+static const char *const levelName[] = {"scalar", "sse2", "avx2", "avx512"};
+
+static uint32_t seed = 1;
+
+/* uniform in [-1, 1) */
+static double rnd(void)
+{
+    seed = seed * 1664525 + 1013904223;
+    return (seed >> 8) / 8388608.0 - 1.0;
+}
+
+static void fill(faac_real *x, int n)
+{
+    int i;
+
+    for (i = 0; i < n; i++)
+        x[i] = rnd();
+}
+
+static int check(const char *level, const char *kernel, int n,
+                 const void *ref, const void *test, size_t size)
+{
+    if (!memcmp(ref, test, size))
+        return 0;
+    printf("%s: %s differs for n = %d\n", level, kernel, n);
+    return 1;
+}
+
+static int quantize(const CPUKernels *ref, const CPUKernels *test, const char *level)
+{
+    static faac_real xr[MAXN];
+    static int xi0[MAXN], xi1[MAXN];
+    int failed = 0;
+    int trial, i;
+
+    for (trial = 0; trial < 2000; trial++)
+    {
+        int n = trial % 67 + 1 + (trial & 1) * 960;
+        double sfacfix = exp(4 * rnd());
+
+        /* wide dynamic range, every value close to where it rounds to
+           the next level */
+        for (i = 0; i < n; i++)
+        {
+            double q = floor(exp(5 * (rnd() + 1))) - MAGIC_NUMBER;
+
+            xr[i] = pow(q + 1e-5 * rnd(), 4.0 / 3) / sfacfix;
+            if (rnd() < 0)
+                xr[i] = -xr[i];
+        }
+
+        ref->quantize(xr, xi0, n, sfacfix);
+        test->quantize(xr, xi1, n, sfacfix);
+        failed |= check(level, "quantize", n, xi0, xi1, n * sizeof(*xi0));
+    }
+
+    return failed;
+}
+
+static int transforms(const CPUKernels *ref, const CPUKernels *test, const char *level)
+{
+    static faac_real x0[MAXN * 8], x1[MAXN * 8], w[MAXN * 8], wi[MAXN * 8];
+    static const int sizes[] = {1, 3, 7, 60, 64, 120, 128, 240, 256, 480, 512, 960, 1024};
+    int failed = 0;
+    unsigned int i;
+    int logm, s;
+
+    for (i = 0; i < sizeof(sizes) / sizeof(sizes[0]); i++)
+    {
+        int n = sizes[i];
+
+        fill(x0, 2 * n);
+        fill(w, 2 * n);
+        fill(wi, 2 * n);
+
+        memcpy(x1, x0, n * sizeof(*x0));
+        ref->window(x0, w, n);
+        test->window(x1, w, n);
+        failed |= check(level, "window", n, x0, x1, n * sizeof(*x0));
+
+        memcpy(x1, x0, n * sizeof(*x0));
+        ref->window_rev(x0, w, n);
+        test->window_rev(x1, w, n);
+        failed |= check(level, "window_rev", n, x0, x1, n * sizeof(*x0));
+
+        memcpy(x1, x0, 2 * n * sizeof(*x0));
+        ref->cmul(x0, w, wi, n);
+        test->cmul(x1, w, wi, n);
+        failed |= check(level, "cmul", n, x0, x1, 2 * n * sizeof(*x0));
+
+        if (n > MAXN / 4)
+            continue;
+        fill(x0, 16 * n);
+        memcpy(x1, x0, 16 * n * sizeof(*x0));
+        ref->cmul8(x0, w, wi, n);
+        test->cmul8(x1, w, wi, n);
+        failed |= check(level, "cmul8", n, x0, x1, 16 * n * sizeof(*x0));
+    }
+
+    /* the passes of the FFT sizes, 2^logm points */
+    for (logm = 2; logm <= 9; logm++)
+    {
+        int n = 1 << logm;
+
+        for (s = (logm & 1) ? 2 : 1; 4 * s <= n; s *= 4)
+        {
+            fill(w, 12 * s);
+
+            fill(x0, 2 * n);
+            memcpy(x1, x0, 2 * n * sizeof(*x0));
+            ref->radix4(x0, w, s, n);
+            test->radix4(x1, w, s, n);
+            failed |= check(level, "radix4", n, x0, x1, 2 * n * sizeof(*x0));
+
+            fill(x0, 16 * n);
+            memcpy(x1, x0, 16 * n * sizeof(*x0));
+            ref->radix4_8(x0, w, s, n);
+            test->radix4_8(x1, w, s, n);
+            failed |= check(level, "radix4_8", n, x0, x1, 16 * n * sizeof(*x0));
+        }
+    }
+
+    return failed;
+}
+
+int main(void)
+{
+    CPUKernels cpu, ref, test;
+    int failed = 0;
+    int level;
+
+    CPUKernelsInit(&cpu);
+    CPUKernelsSelect(&ref, CPU_SCALAR);
+
+    for (level = CPU_SCALAR + 1; level <= cpu.level; level++)
+    {
+        int f;
+
+        CPUKernelsSelect(&test, level);
+        f = quantize(&ref, &test, levelName[level]);
+        f |= transforms(&ref, &test, levelName[level]);
+        printf("%s: %s\n", levelName[level], f ? "FAILED" : "same as scalar");
+        failed |= f;
+    }
+    if (cpu.level == CPU_SCALAR)
+        printf("scalar kernels only\n");
+
+    return failed;
+}
@@ -0,0 +1,216 @@
+/****************************************************************************
+    Test: the encoder writes the frame and nothing else to the output
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+****************************************************************************/
+
+/*
+ * Two encoders code the same input, one into a buffer filled with zeros,
+ * the other into one filled with ones, both larger than needed. The
+ * frames must be the same, so nothing depends on what was in the buffer,
+ * not even the ADTS frame length patched in at the end, and every byte
+ * past the returned size must keep its fill. The ADTS header must give
+ * the returned size. Half way through, the second encoder gets one byte
+ * less than the frame needs: it must return -1 and leave the bytes past
+ * that size alone.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <faac.h>
+
+#include "signal.h"
+
+typedef struct
+{
+    const char *name;
+    int outputFormat;
+    int pipeline;
+} testcase_t;
+
+static const testcase_t cases[] = {
+    {"ADTS", ADTS_STREAM, 0},
+    {"raw", RAW_STREAM, 0},
+    {"ADTS, pipelined", ADTS_STREAM, 1},
+};
+
+enum {RATE = 44100, CHANNELS = 2, FRAMES = 40, GUARD = 4096};
+
+static faacEncHandle open_encoder(const testcase_t *tc, unsigned long *inputSamples,
+                                  unsigned long *maxBytes)
+{
+    faacEncHandle enc = faacEncOpen(RATE, CHANNELS, inputSamples, maxBytes);
+    faacEncConfigurationPtr config;
+
+    if (!enc)
+        return NULL;
+    config = faacEncGetCurrentConfiguration(enc);
+    config->inputFormat = FAAC_INPUT_FLOAT;
+    config->outputFormat = tc->outputFormat;
+    if (!faacEncSetConfiguration(enc, config))
+    {
+        faacEncClose(enc);
+        return NULL;
+    }
+
+    return enc;
+}
+
+/* index of the first byte from start on that is not fill, -1 if none */
+static long changed(const unsigned char *buf, long start, long size, int fill)
+{
+    long i;
+
+    for (i = start; i < size; i++)
+    {
+        if (buf[i] != fill)
+            return i;
+    }
+
+    return -1;
+}
+
+static const char skipped[] = "skipped, no threads";
+
+/* NULL if passed, skipped if it can not run here, else what failed */
+static const char *run(const testcase_t *tc)
+{
+    faacEncHandle enc[2];
+    unsigned long inputSamples, maxBytes;
+    unsigned char *out[2] = {NULL, NULL};
+    float *pcm = NULL;
+    const char *err = "encoding failed";
+    long size = 0;
+    int frame, checked = 0, i;
+
+    enc[0] = open_encoder(tc, &inputSamples, &maxBytes);
+    enc[1] = open_encoder(tc, &inputSamples, &maxBytes);
+    if (!enc[0] || !enc[1])
+    {
+        err = "configuration refused";
+        goto end;
+    }
+    if (tc->pipeline && !faacEncSetPipeline(enc[0], 1))
+    {
+        err = skipped;
+        goto end;
+    }
+    if (tc->pipeline && !faacEncSetPipeline(enc[1], 1))
+        goto end;
+
+    size = maxBytes + GUARD;
+    pcm = malloc(inputSamples * sizeof(*pcm));
+    out[0] = malloc(size);
+    out[1] = malloc(size);
+    if (!pcm || !out[0] || !out[1])
+        goto end;
+
+    for (frame = 0; frame < FRAMES + 4; frame++)
+    {
+        int n[2];
+        unsigned int samples = frame < FRAMES ? inputSamples : 0;
+
+        signal_make(SIGNAL_MUSIC, pcm, inputSamples / CHANNELS, CHANNELS, RATE,
+                    (long)frame * (inputSamples / CHANNELS));
+        memset(out[0], 0x00, size);
+        memset(out[1], 0xff, size);
+
+        n[0] = faacEncEncode(enc[0], (int32_t *)pcm, samples, out[0], maxBytes);
+        if (n[0] < 0)
+            goto end;
+
+        if (!checked && frame >= FRAMES / 2 && n[0] > 0)
+        {
+            /* one byte short */
+            n[1] = faacEncEncode(enc[1], (int32_t *)pcm, samples, out[1], n[0] - 1);
+            if (n[1] != -1)
+            {
+                err = "too small a buffer not refused";
+                goto end;
+            }
+            if (changed(out[1], n[0] - 1, size, 0xff) >= 0)
+            {
+                err = "written past too small a buffer";
+                goto end;
+            }
+            checked = 1;
+            continue;
+        }
+        if (checked)
+            continue;
+
+        n[1] = faacEncEncode(enc[1], (int32_t *)pcm, samples, out[1], maxBytes);
+        if (n[0] != n[1] || memcmp(out[0], out[1], n[0]))
+        {
+            err = "the frame depends on the buffer contents";
+            goto end;
+        }
+        for (i = 0; i < 2; i++)
+        {
+            if (changed(out[i], n[i], size, i ? 0xff : 0x00) >= 0)
+            {
+                err = "written past the frame";
+                goto end;
+            }
+        }
+        if (tc->outputFormat == ADTS_STREAM && n[0] > 0)
+        {
+            const unsigned char *h = out[0];
+            int length = ((h[3] & 3) << 11) | (h[4] << 3) | (h[5] >> 5);
+
+            if (n[0] < 7 || h[0] != 0xff || (h[1] & 0xf0) != 0xf0)
+            {
+                err = "no ADTS header";
+                goto end;
+            }
+            if (length != n[0])
+            {
+                err = "ADTS frame length";
+                goto end;
+            }
+        }
+    }
+
+    err = checked ? NULL : "too small a buffer not tried";
+
+end:
+    free(pcm);
+    free(out[0]);
+    free(out[1]);
+    for (i = 0; i < 2; i++)
+    {
+        if (enc[i])
+            faacEncClose(enc[i]);
+    }
+
+    return err;
+}
+
+int main(void)
+{
+    unsigned int i;
+    int failed = 0;
+
+    for (i = 0; i < sizeof(cases) / sizeof(cases[0]); i++)
+    {
+        const char *err = run(&cases[i]);
+
+        printf("%s: %s\n", cases[i].name, err ? err : "ok");
+        if (err && err != skipped)
+            failed = 1;
+    }
+
+    return failed;
+}
@@ -0,0 +1,207 @@
+/****************************************************************************
+    Test: single against double precision signal path
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+****************************************************************************/
+
+/*
+ * Built twice, as precision_double and precision_single, each linked with
+ * the library in its precision. "precision out" runs the filterbank over
+ * the corpus, at both frame lengths, in every block type and window shape,
+ * and stores the spectra as doubles. "precision -c a b" compares two such
+ * files frame by frame and fails if the SNR of any signal is below
+ * MINSNR dB. precision.sh runs the three.
+ */
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "frame.h"
+#include "filtbank.h"
+#include "signal.h"
+
+/* float has 24 bits, about 144 dB, the transforms lose a few of them */
+#define MINSNR 120.0
+
+enum {RATE = 44100, FRAMES = 64};
+
+static const int frameLens[] = {1024, 960};
+
+/* block types of consecutive frames, a valid sequence */
+static const int blocks[8] = {
+    ONLY_LONG_WINDOW, LONG_SHORT_WINDOW, ONLY_SHORT_WINDOW, ONLY_SHORT_WINDOW,
+    SHORT_LONG_WINDOW, ONLY_LONG_WINDOW, ONLY_LONG_WINDOW, ONLY_LONG_WINDOW
+};
+
+static int spectra(const char *path)
+{
+    FILE *f = fopen(path, "wb");
+    unsigned int l;
+
+    if (!f)
+    {
+        perror(path);
+        return 1;
+    }
+
+    for (l = 0; l < sizeof(frameLens) / sizeof(frameLens[0]); l++)
+    {
+        int len = frameLens[l];
+        SharedTables *tables = TablesAcquire(len);
+        faacEncStruct *enc = calloc(1, sizeof(*enc));
+        faac_real *in = malloc(len * sizeof(*in));
+        faac_real *overlap = malloc(len * sizeof(*overlap));
+        faac_real *mdct = malloc(2 * len * sizeof(*mdct));
+        double *out = malloc(len * sizeof(*out));
+        float *pcm = malloc(len * sizeof(*pcm));
+        CoderInfo coder;
+        int sig, frame, i;
+
+        if (!tables || !enc || !in || !overlap || !mdct || !out || !pcm)
+        {
+            fprintf(stderr, "out of memory\n");
+            return 1;
+        }
+
+        enc->frameLen = len;
+        enc->tables = tables;
+        enc->mdctInfo = &tables->mdctInfo;
+        enc->sin_window_long = tables->sin_window_long;
+        enc->sin_window_short = tables->sin_window_short;
+        enc->kbd_window_long = tables->kbd_window_long;
+        enc->kbd_window_short = tables->kbd_window_short;
+
+        for (sig = 0; sig < SIGNAL_COUNT; sig++)
+        {
+            memset(overlap, 0, len * sizeof(*overlap));
+            memset(&coder, 0, sizeof(coder));
+            coder.window_shape = SINE_WINDOW;
+
+            for (frame = 0; frame < FRAMES; frame++)
+            {
+                signal_make(sig, pcm, len, 1, RATE, (long)frame * len);
+                for (i = 0; i < len; i++)
+                    in[i] = pcm[i];
+
+                coder.prev_window_shape = coder.window_shape;
+                coder.window_shape = (frame / 8) & 1 ? KBD_WINDOW : SINE_WINDOW;
+                coder.block_type = blocks[frame & 7];
+
+                FilterBank(enc, &coder, in, mdct, overlap, MOVERLAPPED);
+
+                for (i = 0; i < len; i++)
+                    out[i] = mdct[i];
+                if (fwrite(out, sizeof(*out), len, f) != (size_t)len)
+                {
+                    perror(path);
+                    return 1;
+                }
+            }
+        }
+
+        free(pcm);
+        free(out);
+        free(mdct);
+        free(overlap);
+        free(in);
+        free(enc);
+        TablesRelease(tables);
+    }
+
+    return fclose(f) != 0;
+}
+
+static int compare(const char *path0, const char *path1)
+{
+    FILE *f0 = fopen(path0, "rb");
+    FILE *f1 = fopen(path1, "rb");
+    unsigned int l;
+    int failed = 0, same = 1;
+
+    if (!f0 || !f1)
+    {
+        perror(f0 ? path1 : path0);
+        return 1;
+    }
+
+    printf("%-8s %6s %12s %12s\n", "signal", "frame", "SNR dB", "worst frame");
+    for (l = 0; l < sizeof(frameLens) / sizeof(frameLens[0]); l++)
+    {
+        int len = frameLens[l];
+        double *x0 = malloc(len * sizeof(*x0));
+        double *x1 = malloc(len * sizeof(*x1));
+        int sig, frame, i;
+
+        for (sig = 0; sig < SIGNAL_COUNT; sig++)
+        {
+            double sum = 0, sumdiff = 0, worst = INFINITY;
+            double snr;
+
+            for (frame = 0; frame < FRAMES; frame++)
+            {
+                double e = 0, d = 0;
+
+                if (fread(x0, sizeof(*x0), len, f0) != (size_t)len
+                    || fread(x1, sizeof(*x1), len, f1) != (size_t)len)
+                {
+                    fprintf(stderr, "short file\n");
+                    return 1;
+                }
+                for (i = 0; i < len; i++)
+                {
+                    e += x0[i] * x0[i];
+                    d += (x1[i] - x0[i]) * (x1[i] - x0[i]);
+                }
+                sum += e;
+                sumdiff += d;
+                if (e > 0 && d > 0 && 10 * log10(e / d) < worst)
+                    worst = 10 * log10(e / d);
+            }
+
+            if (sumdiff > 0)
+                same = 0;
+            snr = sumdiff > 0 ? 10 * log10(sum / sumdiff) : INFINITY;
+            printf("%-8s %6d %12.1f %12.1f\n", signal_name[sig], len, snr, worst);
+            if (!(worst >= MINSNR))
+                failed = 1;
+        }
+
+        free(x0);
+        free(x1);
+    }
+
+    fclose(f0);
+    fclose(f1);
+
+    if (failed)
+        printf("SNR below %.0f dB\n", MINSNR);
+    /* then both were built in the same precision */
+    if (same)
+        printf("no difference at all\n");
+
+    return failed || same;
+}
+
+int main(int argc, char **argv)
+{
+    if (argc == 2)
+        return spectra(argv[1]);
+    if (argc == 4 && !strcmp(argv[1], "-c"))
+        return compare(argv[2], argv[3]);
+
+    fprintf(stderr, "usage: %s out | -c ref test\n", argv[0]);
+    return 2;
+}
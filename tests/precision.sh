@@ -0,0 +1,6 @@
+#!/bin/sh
+# Spectra of the corpus from the double and the single precision signal
+# path, compared by SNR, see precision.c
+./precision_double precision_double.out || exit 1
+./precision_single precision_single.out || exit 1
+./precision_double -c precision_double.out precision_single.out
@@ -0,0 +1,141 @@
+/****************************************************************************
+    Test: the section books never cost more than the greedy choice
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+****************************************************************************/
+
+/*
+ * huffsect() is wrapped (ld --wrap). For every window group the section
+ * and spectral bits of the books it chooses must not exceed those of the
+ * greedy choice it replaced. Every signal of the corpus is encoded at low,
+ * default and high quality, and once with short blocks only, where the
+ * section lengths are counted in 3 bit fields.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <faac.h>
+
+#include "greedy.h"
+#include "signal.h"
+
+void __real_huffsect(CoderInfo *coder, HuffSect *sect);
+
+static long groups;
+static long worse;
+
+void __wrap_huffsect(CoderInfo *coder, HuffSect *sect)
+{
+    int greedy[NSFB_LONG];
+    long before;
+
+    greedy_books(coder, sect, greedy);
+    before = sect_cost(coder, sect, greedy);
+
+    __real_huffsect(coder, sect);
+
+    groups++;
+    if (sect_cost(coder, sect, coder->book + sect->band0) > before)
+        worse++;
+}
+
+typedef struct
+{
+    const char *name;
+    int quality;
+    int shortctl;
+} testcase_t;
+
+static const testcase_t cases[] = {
+    {"quality 50", 50, SHORTCTL_NORMAL},
+    {"quality 100", 100, SHORTCTL_NORMAL},
+    {"quality 200", 200, SHORTCTL_NORMAL},
+    {"quality 100, short blocks only", 100, SHORTCTL_NOLONG},
+};
+
+enum {RATE = 44100, CHANNELS = 2, FRAMES = 80};
+
+/* 0 if encoded, -1 if encoding failed */
+static int run(const testcase_t *tc, int sig)
+{
+    faacEncHandle enc;
+    faacEncConfigurationPtr config;
+    unsigned long inputSamples, maxBytes;
+    float *pcm;
+    unsigned char *out;
+    long pos = 0;
+    int frame, result = -1;
+
+    enc = faacEncOpen(RATE, CHANNELS, &inputSamples, &maxBytes);
+    if (!enc)
+        return -1;
+
+    config = faacEncGetCurrentConfiguration(enc);
+    config->inputFormat = FAAC_INPUT_FLOAT;
+    config->shortctl = tc->shortctl;
+    config->quantqual = tc->quality;
+    config->bitRate = 0;
+    pcm = malloc(inputSamples * sizeof(*pcm));
+    out = malloc(maxBytes);
+
+    if (!pcm || !out || !faacEncSetConfiguration(enc, config))
+        goto end;
+
+    for (frame = 0; frame < FRAMES; frame++)
+    {
+        int n = inputSamples / CHANNELS;
+
+        signal_make(sig, pcm, n, CHANNELS, RATE, pos);
+        pos += n;
+        if (faacEncEncode(enc, (int32_t *)pcm, inputSamples, out, maxBytes) < 0)
+            goto end;
+    }
+    while (faacEncEncode(enc, NULL, 0, out, maxBytes) > 0)
+        ;
+    result = 0;
+
+end:
+    free(pcm);
+    free(out);
+    faacEncClose(enc);
+
+    return result;
+}
+
+int main(void)
+{
+    unsigned int i;
+    int sig, failed = 0;
+
+    for (i = 0; i < sizeof(cases) / sizeof(cases[0]); i++)
+    {
+        for (sig = 0; sig < SIGNAL_COUNT; sig++)
+        {
+            groups = 0;
+            worse = 0;
+            if (run(&cases[i], sig) < 0)
+            {
+                printf("%s, %s: encoding failed\n", cases[i].name, signal_name[sig]);
+                failed = 1;
+                continue;
+            }
+            printf("%s, %s: %ld of %ld window groups cost more than greedy\n",
+                   cases[i].name, signal_name[sig], worse, groups);
+            if (worse || !groups)
+                failed = 1;
+        }
+    }
+
+    return failed;
+}
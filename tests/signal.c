@@ -0,0 +1,118 @@
+/****************************************************************************
+    Test signals
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+****************************************************************************/
+
+#include <math.h>
+#include <stdint.h>
+
+#include "signal.h"
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+const char *const signal_name[SIGNAL_COUNT] = {
+    "tones", "noise", "clicks", "sweep", "quiet", "music"
+};
+
+/* uniform in [-1, 1), from the position alone */
+static double noise(long pos, int channel)
+{
+    uint32_t x = (uint32_t)pos * 2654435761u ^ (uint32_t)(channel + 1) * 2246822519u;
+
+    x ^= x >> 15;
+    x *= 2246822519u;
+    x ^= x >> 13;
+    x *= 3266489917u;
+    x ^= x >> 16;
+
+    return x / 2147483648.0 - 1.0;
+}
+
+/* harmonics of f with a 5 Hz vibrato of 0.5 % */
+static double tones(double f, double t, int channel)
+{
+    double v = 0;
+    int h;
+
+    for (h = 1; h <= 6; h++)
+        v += sin(2 * M_PI * h * f * t + h * f * 0.005 / 5 * sin(2 * M_PI * 5 * t)
+                 + channel) / h;
+
+    return v;
+}
+
+/* a burst of noise every period seconds, decaying in 5 ms */
+static double clicks(long pos, double t, double period, int channel)
+{
+    double age = fmod(t, period);
+
+    return noise(pos, channel) * exp(-age / 0.005);
+}
+
+void signal_make(int kind, float *buf, int n, int channels, int rate, long pos)
+{
+    /* roots of the chords of SIGNAL_MUSIC, two per second */
+    static const double root[8] = {220, 196, 174.6, 164.8, 220, 261.6, 246.9, 196};
+    int i, ch;
+
+    for (i = 0; i < n; i++, pos++)
+    {
+        double t = (double)pos / rate;
+
+        for (ch = 0; ch < channels; ch++)
+        {
+            double v;
+
+            switch (kind)
+            {
+            case SIGNAL_TONES:
+                v = 6000 * tones(220, t, ch);
+                break;
+            case SIGNAL_NOISE:
+                v = 4000 * noise(pos, ch);
+                break;
+            case SIGNAL_CLICKS:
+                v = 1000 * sin(2 * M_PI * 440 * t) + 16000 * clicks(pos, t, 0.25, ch);
+                break;
+            case SIGNAL_SWEEP:
+                /* 20 Hz to half the sample rate in 10 s */
+                {
+                    double k = log(rate / 40.0) / 10, u = fmod(t, 10);
+
+                    v = 8000 * sin(2 * M_PI * 20 * (exp(k * u) - 1) / k + ch);
+                }
+                break;
+            case SIGNAL_QUIET:
+                v = 3 * sin(2 * M_PI * 1000 * t + ch) + 0.5 * noise(pos, ch);
+                break;
+            case SIGNAL_MUSIC:
+            default:
+                {
+                    double f = root[(long)(t * 2) & 7];
+
+                    v = 3000 * (tones(f, t, ch) + tones(f * 1.26, t, ch)
+                                + tones(f * 1.5, t, ch))
+                        + 12000 * clicks(pos, t, 0.5, ch)
+                        + 300 * noise(pos, ch);
+                }
+                break;
+            }
+
+            buf[i * channels + ch] = v;
+        }
+    }
+}
@@ -0,0 +1,40 @@
+/****************************************************************************
+    Test signals
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+****************************************************************************/
+
+#ifndef SIGNAL_H
+#define SIGNAL_H
+
+/* The corpus of the tests and benchmarks. Every sample is a function of its
+   position only, so all builds and all block sizes see the same input. */
+enum
+{
+    SIGNAL_TONES,       /* harmonics with vibrato */
+    SIGNAL_NOISE,       /* white noise */
+    SIGNAL_CLICKS,      /* decaying noise bursts over a tone, short blocks */
+    SIGNAL_SWEEP,       /* exponential sweep over the whole band */
+    SIGNAL_QUIET,       /* tone and noise 80 dB down */
+    SIGNAL_MUSIC,       /* chords, percussion and some noise */
+    SIGNAL_COUNT
+};
+
+extern const char *const signal_name[SIGNAL_COUNT];
+
+/* n samples per channel from sample pos on, interleaved, in the range of
+   FAAC_INPUT_FLOAT */
+void signal_make(int kind, float *buf, int n, int channels, int rate, long pos);
+
+#endif